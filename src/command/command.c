@@ -61,6 +61,7 @@
 #endif
 #include "profanity.h"
 #include "tools/autocomplete.h"
+#include "tools/frecency.h"
 #include "tools/parser.h"
 #include "tools/tinyurl.h"
 #include "xmpp/xmpp.h"
@@ -70,7 +71,17 @@
 
 typedef char*(*autocompleter)(char*, int*);
 
+// completes the parameters of one command, with a function, or the first argument from an autocompleter
+typedef struct cmd_completer_t {
+    autocompleter complete;
+    Autocomplete ac;
+    autocomplete_func func;
+} CmdCompleter;
+
 static void _cmd_complete_parameters(char *input, int *size);
+static void _cmd_completers_init(void);
+static void _cmd_completer_add(char *cmd, autocompleter complete, Autocomplete ac,
+    autocomplete_func func);
 
 static char * _sub_autocomplete(char *input, int *size);
 static char * _notify_autocomplete(char *input, int *size);
@@ -96,9 +107,22 @@ static char * _ban_autocomplete(char *input, int *size);
 static char * _affiliation_autocomplete(char *input, int *size);
 static char * _role_autocomplete(char *input, int *size);
 static char * _resource_autocomplete(char *input, int *size);
+static char * _msg_autocomplete(char *input, int *size);
+static char * _info_autocomplete(char *input, int *size);
+static char * _status_autocomplete(char *input, int *size);
+static char * _caps_autocomplete(char *input, int *size);
+static char * _software_autocomplete(char *input, int *size);
+static char * _ping_autocomplete(char *input, int *size);
+static char * _target_autocomplete(char *input, int *size, char *command,
+    autocomplete_func roster_func, gboolean muc_nick);
+static autocomplete_func _contact_autocomplete_func(void);
+static gboolean _complete_fuzzy(void);
 
 GHashTable *commands = NULL;
 
+// command to CmdCompleter, built once in cmd_init
+static GHashTable *completers = NULL;
+
 /*
  * Command list
  */
@@ -398,13 +422,14 @@ static struct cmd_t command_defs[] =
 
     { "/occupants",
         cmd_occupants, parse_args, 1, 2, cons_occupants_setting,
-        { "/occupants show|hide|default|size [show|hide] [percent]", "Show or hide room occupants.",
-        { "/occupants show|hide|default|size [show|hide] [percent]",
-          "-------------------------------------------------------",
+        { "/occupants show|hide|default|size|compact [show|hide] [percent|count]", "Show or hide room occupants.",
+        { "/occupants show|hide|default|size|compact [show|hide] [percent|count]",
+          "---------------------------------------------------------------------",
           "show    - Show the occupants panel in chat rooms.",
           "hide    - Hide the occupants panel in chat rooms.",
           "default - Whether occupants are shown by default in new rooms, 'show' or 'hide'",
           "size    - Percentage of the screen taken by the occupants list in rooms (1-99).",
+          "compact - Occupant count at which a room switches to compact storage, 0 to disable.",
           NULL } } },
 
     { "/form",
@@ -619,6 +644,16 @@ static struct cmd_t command_defs[] =
           "Configure time precision for the main window.",
           NULL } } },
 
+    { "/complete",
+        cmd_complete, parse_args, 1, 1, &cons_complete_setting,
+        { "/complete prefix|fuzzy", "Contact and room completion.",
+        { "/complete prefix|fuzzy",
+          "----------------------",
+          "prefix : Tab cycles through contacts and rooms starting with the text, in order.",
+          "fuzzy  : Tab cycles through contacts and rooms containing the characters typed, in order,",
+          "         most often and most recently messaged first.",
+          NULL } } },
+
     { "/inpblock",
         cmd_inpblock, parse_args, 1, 1, &cons_inpblock_setting,
         { "/inpblock millis", "Input blocking delay.",
@@ -739,6 +774,18 @@ static struct cmd_t command_defs[] =
           "The default is 'off'.",
           NULL } } },
 
+    { "/multiline",
+        cmd_multiline, parse_args, 1, 1, &cons_multiline_setting,
+        { "/multiline on|off", "Send multi-line pastes as one message.",
+        { "/multiline on|off",
+          "-----------------",
+          "If set to 'on', pasting text that spans several lines sends it straight away as a single message,",
+          "keeping the line breaks, along with anything already typed.",
+          "If set to 'off', the lines are joined with spaces and left in the input window for editing.",
+          "Requires a terminal that supports bracketed paste.",
+          "The default is 'off'.",
+          NULL } } },
+
     { "/alias",
         cmd_alias, parse_args_with_freetext, 1, 3, NULL,
         { "/alias add|remove|list [name value]", "Add your own command aliases.",
@@ -785,9 +832,9 @@ static struct cmd_t command_defs[] =
 
     { "/otr",
         cmd_otr, parse_args, 1, 3, NULL,
-        { "/otr gen|myfp|theirfp|start|end|trust|untrust|log|warn|libver|policy|secret|question|answer", "Off The Record encryption commands.",
-        { "/otr gen|myfp|theirfp|start|end|trust|untrust|log|warn|libver|policy|secret|question|answer",
-          "-------------------------------------------------------------------------------------------",
+        { "/otr gen|myfp|theirfp|start|end|trust|untrust|log|warn|libver|policy|secret|question|answer|stats", "Off The Record encryption commands.",
+        { "/otr gen|myfp|theirfp|start|end|trust|untrust|log|warn|libver|policy|secret|question|answer|stats",
+          "-------------------------------------------------------------------------------------------------",
           "gen - Generate your private key.",
           "myfp - Show your fingerprint.",
           "theirfp - Show contacts fingerprint.",
@@ -802,6 +849,7 @@ static struct cmd_t command_defs[] =
           "secret [secret]- Verify a contacts identity using a shared secret.",
           "question [question] [answer] - Verify a contacts identity using a question and expected anwser, if the question has spaces, surround with double quotes.",
           "answer [answer] - Respond to a question answer verification request with your answer.",
+          "stats - Show time spent encrypting and decrypting messages with the current recipient.",
           NULL } } },
 
     { "/outtype",
@@ -861,15 +909,31 @@ static struct cmd_t command_defs[] =
           "-----------------",
           "Set the number of seconds between server pings, so ensure connection kept alive.",
           "A value of 0 will switch off autopinging the server.",
+          "If the server does not respond to a ping within 10 seconds the connection is closed,",
+          "and the interval is shortened until pings are answered reliably again.",
           NULL } } },
 
     { "/ping",
         cmd_ping, parse_args, 0, 1, NULL,
-        { "/ping [target]", "Send ping IQ request.",
-        { "/ping [rarget]",
-          "--------------",
+        { "/ping [target|stats]", "Send ping IQ request.",
+        { "/ping [target|stats]",
+          "--------------------",
           "Sends an IQ ping stanza to the specificed target.",
           "If no target is supplied, your chat server will be used.",
+          "stats : Show round trip times of server pings sent by /autoping,",
+          "        and the current autoping interval.",
+          NULL } } },
+
+    { "/iqstats",
+        cmd_iqstats, parse_args, 0, 1, NULL,
+        { "/iqstats [reset]", "Show IQ request latency statistics.",
+        { "/iqstats [reset]",
+          "----------------",
+          "Show response times for IQ requests sent during this session, grouped by namespace.",
+          "For each namespace the number of results, errors and timeouts is shown,",
+          "along with a histogram of response times.",
+          "Requests not answered within 30 seconds are timed out.",
+          "reset : Clear the collected statistics.",
           NULL } } },
 
     { "/autoaway",
@@ -995,6 +1059,30 @@ static struct cmd_t command_defs[] =
           "The default is 'all' for all windows.",
           NULL } } },
 
+    { "/highlight",
+        cmd_highlight, parse_args_with_freetext, 1, 2, NULL,
+        { "/highlight add|regex|remove|list [word|pattern]", "Highlight words in chat rooms.",
+        { "/highlight add|regex|remove|list [word|pattern]",
+          "-----------------------------------------------",
+          "Chat room messages containing your nick or one of these are coloured as mentions,",
+          "trigger 'mention' notifications and are listed in the /mentions window.",
+          "add    - Highlight a word, matched as a whole word ignoring case.",
+          "regex  - Highlight messages matching a regular expression, ignoring case.",
+          "remove - Remove a word or regular expression.",
+          "list   - List the highlight words and regular expressions.",
+          "Example : /highlight add deploy",
+          "Example : /highlight regex build (failed|broken)",
+          NULL } } },
+
+    { "/mentions",
+        cmd_mentions, parse_args, 0, 1, NULL,
+        { "/mentions [clear]", "Show chat room messages that mentioned you.",
+        { "/mentions [clear]",
+          "-----------------",
+          "Open a window listing the most recent chat room messages matching your nick or /highlight words.",
+          "clear - Forget the mentions received so far.",
+          NULL } } },
+
     { "/xmlconsole",
         cmd_xmlconsole, parse_args, 0, 0, NULL,
         { "/xmlconsole", "Open the XML console",
@@ -1076,11 +1164,15 @@ static Autocomplete autoconnect_ac;
 static Autocomplete titlebar_ac;
 static Autocomplete theme_ac;
 static Autocomplete theme_load_ac;
+static guint theme_load_generation;
 static Autocomplete account_ac;
 static Autocomplete account_set_ac;
 static Autocomplete account_clear_ac;
 static Autocomplete account_default_ac;
 static Autocomplete disco_ac;
+static Autocomplete iqstats_ac;
+static Autocomplete highlight_ac;
+static Autocomplete mentions_ac;
 static Autocomplete close_ac;
 static Autocomplete wins_ac;
 static Autocomplete roster_ac;
@@ -1108,6 +1200,7 @@ static Autocomplete form_field_multi_ac;
 static Autocomplete occupants_ac;
 static Autocomplete occupants_default_ac;
 static Autocomplete time_ac;
+static Autocomplete complete_ac;
 static Autocomplete resource_ac;
 
 /*
@@ -1236,6 +1329,18 @@ cmd_init(void)
     autocomplete_add(disco_ac, "info");
     autocomplete_add(disco_ac, "items");
 
+    iqstats_ac = autocomplete_new();
+    autocomplete_add(iqstats_ac, "reset");
+
+    highlight_ac = autocomplete_new();
+    autocomplete_add(highlight_ac, "add");
+    autocomplete_add(highlight_ac, "regex");
+    autocomplete_add(highlight_ac, "remove");
+    autocomplete_add(highlight_ac, "list");
+
+    mentions_ac = autocomplete_new();
+    autocomplete_add(mentions_ac, "clear");
+
     account_ac = autocomplete_new();
     autocomplete_add(account_ac, "list");
     autocomplete_add(account_ac, "show");
@@ -1363,6 +1468,7 @@ cmd_init(void)
     autocomplete_add(otr_ac, "policy");
     autocomplete_add(otr_ac, "question");
     autocomplete_add(otr_ac, "answer");
+    autocomplete_add(otr_ac, "stats");
 
     otr_log_ac = autocomplete_new();
     autocomplete_add(otr_log_ac, "on");
@@ -1438,6 +1544,7 @@ cmd_init(void)
     autocomplete_add(occupants_ac, "hide");
     autocomplete_add(occupants_ac, "default");
     autocomplete_add(occupants_ac, "size");
+    autocomplete_add(occupants_ac, "compact");
 
     occupants_default_ac = autocomplete_new();
     autocomplete_add(occupants_default_ac, "show");
@@ -1452,10 +1559,16 @@ cmd_init(void)
     autocomplete_add(time_ac, "minutes");
     autocomplete_add(time_ac, "seconds");
 
+    complete_ac = autocomplete_new();
+    autocomplete_add(complete_ac, "prefix");
+    autocomplete_add(complete_ac, "fuzzy");
+
     resource_ac = autocomplete_new();
     autocomplete_add(resource_ac, "set");
     autocomplete_add(resource_ac, "off");
 
+    _cmd_completers_init();
+
     cmd_history_init();
 }
 
@@ -1484,6 +1597,9 @@ cmd_uninit(void)
     autocomplete_free(account_clear_ac);
     autocomplete_free(account_default_ac);
     autocomplete_free(disco_ac);
+    autocomplete_free(iqstats_ac);
+    autocomplete_free(highlight_ac);
+    autocomplete_free(mentions_ac);
     autocomplete_free(close_ac);
     autocomplete_free(wins_ac);
     autocomplete_free(roster_ac);
@@ -1511,7 +1627,13 @@ cmd_uninit(void)
     autocomplete_free(occupants_ac);
     autocomplete_free(occupants_default_ac);
     autocomplete_free(time_ac);
+    autocomplete_free(complete_ac);
     autocomplete_free(resource_ac);
+
+    if (completers) {
+        g_hash_table_destroy(completers);
+        completers = NULL;
+    }
 }
 
 gboolean
@@ -1620,88 +1742,7 @@ cmd_autocomplete(char *input, int *size)
 void
 cmd_reset_autocomplete()
 {
-    roster_reset_search_attempts();
-    muc_invites_reset_ac();
-    accounts_reset_all_search();
-    accounts_reset_enabled_search();
-    prefs_reset_boolean_choice();
-    presence_reset_sub_request_search();
-    autocomplete_reset(help_ac);
-    autocomplete_reset(notify_ac);
-    autocomplete_reset(notify_message_ac);
-    autocomplete_reset(notify_room_ac);
-    autocomplete_reset(notify_typing_ac);
-    autocomplete_reset(sub_ac);
-
-    autocomplete_reset(who_room_ac);
-    autocomplete_reset(who_roster_ac);
-    autocomplete_reset(prefs_ac);
-    autocomplete_reset(log_ac);
-    autocomplete_reset(commands_ac);
-    autocomplete_reset(autoaway_ac);
-    autocomplete_reset(autoaway_mode_ac);
-    autocomplete_reset(autoconnect_ac);
-    autocomplete_reset(theme_ac);
-    if (theme_load_ac != NULL) {
-        autocomplete_reset(theme_load_ac);
-        theme_load_ac = NULL;
-    }
-    autocomplete_reset(account_ac);
-    autocomplete_reset(account_set_ac);
-    autocomplete_reset(account_clear_ac);
-    autocomplete_reset(account_default_ac);
-    autocomplete_reset(disco_ac);
-    autocomplete_reset(close_ac);
-    autocomplete_reset(wins_ac);
-    autocomplete_reset(roster_ac);
-    autocomplete_reset(roster_option_ac);
-    autocomplete_reset(roster_by_ac);
-    autocomplete_reset(group_ac);
-    autocomplete_reset(bookmark_ac);
-    autocomplete_reset(bookmark_property_ac);
-    autocomplete_reset(otr_ac);
-    autocomplete_reset(otr_log_ac);
-    autocomplete_reset(otr_policy_ac);
-    autocomplete_reset(connect_property_ac);
-    autocomplete_reset(statuses_ac);
-    autocomplete_reset(statuses_setting_ac);
-    autocomplete_reset(alias_ac);
-    autocomplete_reset(aliases_ac);
-    autocomplete_reset(join_property_ac);
-    autocomplete_reset(room_ac);
-    autocomplete_reset(affiliation_ac);
-    autocomplete_reset(role_ac);
-    autocomplete_reset(privilege_cmd_ac);
-    autocomplete_reset(subject_ac);
-    autocomplete_reset(form_ac);
-    autocomplete_reset(form_field_multi_ac);
-    autocomplete_reset(occupants_ac);
-    autocomplete_reset(occupants_default_ac);
-    autocomplete_reset(time_ac);
-    autocomplete_reset(resource_ac);
-
-    if (ui_current_win_type() == WIN_CHAT) {
-        ProfChatWin *chatwin = wins_get_current_chat();
-        PContact contact = roster_get_contact(chatwin->barejid);
-        if (contact) {
-            p_contact_resource_ac_reset(contact);
-        }
-    }
-
-    if (ui_current_win_type() == WIN_MUC) {
-        ProfMucWin *mucwin = wins_get_current_muc();
-        muc_autocomplete_reset(mucwin->roomjid);
-        muc_jid_autocomplete_reset(mucwin->roomjid);
-    }
-
-    if (ui_current_win_type() == WIN_MUC_CONFIG) {
-        ProfMucConfWin *confwin = wins_get_current_muc_conf();
-        if (confwin->form) {
-            form_reset_autocompleters(confwin->form);
-        }
-    }
-
-    bookmark_autocomplete_reset();
+    autocomplete_reset_all();
 }
 
 // Command execution
@@ -1786,6 +1827,13 @@ cmd_execute_default(const char * inp)
         return TRUE;
     }
 
+    // a window from another account would send from this one
+    ProfWin *window = wins_get_current();
+    if (status == JABBER_CONNECTED && win_other_account(window)) {
+        ui_current_print_line("This window belongs to account %s, connect with it to send.", window->account);
+        return TRUE;
+    }
+
     win_type_t win_type = ui_current_win_type();
     switch (win_type)
     {
@@ -1795,6 +1843,7 @@ cmd_execute_default(const char * inp)
             } else {
                 ProfMucWin *mucwin = wins_get_current_muc();
                 message_send_groupchat(mucwin->roomjid, inp);
+                frecency_record(mucwin->roomjid);
             }
             break;
 
@@ -1831,6 +1880,7 @@ cmd_execute_default(const char * inp)
                         }
 
                         ui_outgoing_chat_msg("me", chatwin->barejid, inp);
+                        frecency_record(chatwin->barejid);
                     } else {
                         cons_show_error("Failed to send message.");
                     }
@@ -1845,6 +1895,7 @@ cmd_execute_default(const char * inp)
                     }
 
                     ui_outgoing_chat_msg("me", chatwin->barejid, inp);
+                    frecency_record(chatwin->barejid);
                 }
 #else
                 gboolean send_state = chat_session_on_message_send(chatwin->barejid);
@@ -1857,6 +1908,7 @@ cmd_execute_default(const char * inp)
                 }
 
                 ui_outgoing_chat_msg("me", chatwin->barejid, inp);
+                frecency_record(chatwin->barejid);
 #endif
             }
             break;
@@ -1868,11 +1920,13 @@ cmd_execute_default(const char * inp)
                 ProfPrivateWin *privatewin = wins_get_current_private();
                 message_send_private(privatewin->fulljid, inp);
                 ui_outgoing_private_msg("me", privatewin->fulljid, inp);
+                frecency_record(privatewin->fulljid);
             }
             break;
 
         case WIN_CONSOLE:
         case WIN_XML:
+        case WIN_MENTIONS:
             cons_show("Unknown command: %s", inp);
             break;
 
@@ -1884,159 +1938,186 @@ cmd_execute_default(const char * inp)
 }
 
 static void
-_cmd_complete_parameters(char *input, int *size)
+_cmd_completers_init(void)
 {
-    int i;
-    char *result = NULL;
+    completers = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free);
 
-    // autocomplete boolean settings
+    // boolean settings
     gchar *boolean_choices[] = { "/beep", "/intype", "/states", "/outtype",
-        "/flash", "/splash", "/chlog", "/grlog", "/mouse", "/history", "/titlebar",
+        "/flash", "/splash", "/chlog", "/grlog", "/mouse", "/multiline", "/history", "/titlebar",
         "/vercheck", "/privileges", "/presence", "/wrap" };
-
+    unsigned int i;
     for (i = 0; i < ARRAY_SIZE(boolean_choices); i++) {
-        result = autocomplete_param_with_func(input, size, boolean_choices[i],
-            prefs_autocomplete_boolean_choice);
-        if (result != NULL) {
-            ui_replace_input(input, result, size);
-            g_free(result);
-            return;
+        _cmd_completer_add(boolean_choices[i], NULL, NULL, prefs_autocomplete_boolean_choice);
+    }
+
+    // occupant nicks in chat rooms, otherwise the roster
+    _cmd_completer_add("/msg",          _msg_autocomplete, NULL, NULL);
+    _cmd_completer_add("/info",         _info_autocomplete, NULL, NULL);
+    _cmd_completer_add("/status",       _status_autocomplete, NULL, NULL);
+    _cmd_completer_add("/caps",         _caps_autocomplete, NULL, NULL);
+    _cmd_completer_add("/software",     _software_autocomplete, NULL, NULL);
+    _cmd_completer_add("/ping",         _ping_autocomplete, NULL, NULL);
+
+    _cmd_completer_add("/invite",       NULL, NULL, roster_contact_autocomplete);
+    _cmd_completer_add("/decline",      NULL, NULL, muc_invites_find);
+
+    _cmd_completer_add("/help",         NULL, help_ac, NULL);
+    _cmd_completer_add("/prefs",        NULL, prefs_ac, NULL);
+    _cmd_completer_add("/disco",        NULL, disco_ac, NULL);
+    _cmd_completer_add("/close",        NULL, close_ac, NULL);
+    _cmd_completer_add("/wins",         NULL, wins_ac, NULL);
+    _cmd_completer_add("/subject",      NULL, subject_ac, NULL);
+    _cmd_completer_add("/room",         NULL, room_ac, NULL);
+    _cmd_completer_add("/time",         NULL, time_ac, NULL);
+    _cmd_completer_add("/iqstats",      NULL, iqstats_ac, NULL);
+    _cmd_completer_add("/highlight",    NULL, highlight_ac, NULL);
+    _cmd_completer_add("/mentions",     NULL, mentions_ac, NULL);
+    _cmd_completer_add("/complete",     NULL, complete_ac, NULL);
+
+    _cmd_completer_add("/who",          _who_autocomplete, NULL, NULL);
+    _cmd_completer_add("/sub",          _sub_autocomplete, NULL, NULL);
+    _cmd_completer_add("/notify",       _notify_autocomplete, NULL, NULL);
+    _cmd_completer_add("/autoaway",     _autoaway_autocomplete, NULL, NULL);
+    _cmd_completer_add("/theme",        _theme_autocomplete, NULL, NULL);
+    _cmd_completer_add("/log",          _log_autocomplete, NULL, NULL);
+    _cmd_completer_add("/account",      _account_autocomplete, NULL, NULL);
+    _cmd_completer_add("/roster",       _roster_autocomplete, NULL, NULL);
+    _cmd_completer_add("/group",        _group_autocomplete, NULL, NULL);
+    _cmd_completer_add("/bookmark",     _bookmark_autocomplete, NULL, NULL);
+    _cmd_completer_add("/autoconnect",  _autoconnect_autocomplete, NULL, NULL);
+    _cmd_completer_add("/otr",          _otr_autocomplete, NULL, NULL);
+    _cmd_completer_add("/connect",      _connect_autocomplete, NULL, NULL);
+    _cmd_completer_add("/statuses",     _statuses_autocomplete, NULL, NULL);
+    _cmd_completer_add("/alias",        _alias_autocomplete, NULL, NULL);
+    _cmd_completer_add("/join",         _join_autocomplete, NULL, NULL);
+    _cmd_completer_add("/form",         _form_autocomplete, NULL, NULL);
+    _cmd_completer_add("/occupants",    _occupants_autocomplete, NULL, NULL);
+    _cmd_completer_add("/kick",         _kick_autocomplete, NULL, NULL);
+    _cmd_completer_add("/ban",          _ban_autocomplete, NULL, NULL);
+    _cmd_completer_add("/affiliation",  _affiliation_autocomplete, NULL, NULL);
+    _cmd_completer_add("/role",         _role_autocomplete, NULL, NULL);
+    _cmd_completer_add("/resource",     _resource_autocomplete, NULL, NULL);
+}
+
+static void
+_cmd_completer_add(char *cmd, autocompleter complete, Autocomplete ac, autocomplete_func func)
+{
+    CmdCompleter *completer = malloc(sizeof(CmdCompleter));
+    completer->complete = complete;
+    completer->ac = ac;
+    completer->func = func;
+
+    g_hash_table_insert(completers, cmd, completer);
+}
+
+static void
+_cmd_complete_parameters(char *input, int *size)
+{
+    char *result = NULL;
+
+    char parsed[*size+1];
+    int i = 0;
+    while (i < *size) {
+        if (input[i] == ' ') {
+            break;
+        } else {
+            parsed[i] = input[i];
         }
+        i++;
     }
+    parsed[i] = '\0';
 
-    // autocomplete nickname in chat rooms
-    if (ui_current_win_type() == WIN_MUC) {
-        ProfMucWin *mucwin = wins_get_current_muc();
-        Autocomplete nick_ac = muc_roster_ac(mucwin->roomjid);
-        if (nick_ac != NULL) {
-            gchar *nick_choices[] = { "/msg", "/info", "/caps", "/status", "/software" } ;
-
-            for (i = 0; i < ARRAY_SIZE(nick_choices); i++) {
-                result = autocomplete_param_with_ac(input, size, nick_choices[i],
-                    nick_ac, TRUE);
-                if (result != NULL) {
-                    ui_replace_input(input, result, size);
-                    g_free(result);
-                    return;
-                }
-            }
+    CmdCompleter *completer = g_hash_table_lookup(completers, parsed);
+    if (completer != NULL) {
+        if (completer->complete != NULL) {
+            result = completer->complete(input, size);
+        } else if (completer->ac != NULL) {
+            result = autocomplete_param_with_ac(input, size, parsed, completer->ac, TRUE);
+        } else {
+            result = autocomplete_param_with_func(input, size, parsed, completer->func);
         }
-
-    // otherwise autocomplete using roster
     } else {
-        gchar *contact_choices[] = { "/msg", "/info", "/status" };
-        for (i = 0; i < ARRAY_SIZE(contact_choices); i++) {
-            result = autocomplete_param_with_func(input, size, contact_choices[i],
-                roster_contact_autocomplete);
-            if (result != NULL) {
-                ui_replace_input(input, result, size);
-                g_free(result);
-                return;
-            }
-        }
-
-        gchar *resource_choices[] = { "/caps", "/software", "/ping" };
-        for (i = 0; i < ARRAY_SIZE(resource_choices); i++) {
-            result = autocomplete_param_with_func(input, size, resource_choices[i],
-                roster_fulljid_autocomplete);
-            if (result != NULL) {
-                ui_replace_input(input, result, size);
-                g_free(result);
-                return;
-            }
+        input[*size] = '\0';
+        if (g_str_has_prefix(input, "/field")) {
+            result = _form_field_autocomplete(input, size);
         }
     }
 
-    result = autocomplete_param_with_func(input, size, "/invite", roster_contact_autocomplete);
     if (result != NULL) {
         ui_replace_input(input, result, size);
         g_free(result);
-        return;
     }
+}
 
-    gchar *invite_choices[] = { "/decline", "/join" };
-    for (i = 0; i < ARRAY_SIZE(invite_choices); i++) {
-        result = autocomplete_param_with_func(input, size, invite_choices[i],
-            muc_invites_find);
-        if (result != NULL) {
-            ui_replace_input(input, result, size);
-            g_free(result);
-            return;
-        }
-    }
+static char *
+_msg_autocomplete(char *input, int *size)
+{
+    return _target_autocomplete(input, size, "/msg", _contact_autocomplete_func(), TRUE);
+}
 
-    gchar *cmds[] = { "/help", "/prefs", "/disco", "/close", "/wins", "/subject", "/room", "/time" };
-    Autocomplete completers[] = { help_ac, prefs_ac, disco_ac, close_ac, wins_ac, subject_ac, room_ac, time_ac };
+static char *
+_info_autocomplete(char *input, int *size)
+{
+    return _target_autocomplete(input, size, "/info", _contact_autocomplete_func(), TRUE);
+}
 
-    for (i = 0; i < ARRAY_SIZE(cmds); i++) {
-        result = autocomplete_param_with_ac(input, size, cmds[i], completers[i], TRUE);
-        if (result != NULL) {
-            ui_replace_input(input, result, size);
-            g_free(result);
-            return;
-        }
-    }
+static char *
+_status_autocomplete(char *input, int *size)
+{
+    return _target_autocomplete(input, size, "/status", _contact_autocomplete_func(), TRUE);
+}
 
-    GHashTable *ac_funcs = g_hash_table_new(g_str_hash, g_str_equal);
-    g_hash_table_insert(ac_funcs, "/who",           _who_autocomplete);
-    g_hash_table_insert(ac_funcs, "/sub",           _sub_autocomplete);
-    g_hash_table_insert(ac_funcs, "/notify",        _notify_autocomplete);
-    g_hash_table_insert(ac_funcs, "/autoaway",      _autoaway_autocomplete);
-    g_hash_table_insert(ac_funcs, "/theme",         _theme_autocomplete);
-    g_hash_table_insert(ac_funcs, "/log",           _log_autocomplete);
-    g_hash_table_insert(ac_funcs, "/account",       _account_autocomplete);
-    g_hash_table_insert(ac_funcs, "/roster",        _roster_autocomplete);
-    g_hash_table_insert(ac_funcs, "/group",         _group_autocomplete);
-    g_hash_table_insert(ac_funcs, "/bookmark",      _bookmark_autocomplete);
-    g_hash_table_insert(ac_funcs, "/autoconnect",   _autoconnect_autocomplete);
-    g_hash_table_insert(ac_funcs, "/otr",           _otr_autocomplete);
-    g_hash_table_insert(ac_funcs, "/connect",       _connect_autocomplete);
-    g_hash_table_insert(ac_funcs, "/statuses",      _statuses_autocomplete);
-    g_hash_table_insert(ac_funcs, "/alias",         _alias_autocomplete);
-    g_hash_table_insert(ac_funcs, "/join",          _join_autocomplete);
-    g_hash_table_insert(ac_funcs, "/form",          _form_autocomplete);
-    g_hash_table_insert(ac_funcs, "/occupants",     _occupants_autocomplete);
-    g_hash_table_insert(ac_funcs, "/kick",          _kick_autocomplete);
-    g_hash_table_insert(ac_funcs, "/ban",           _ban_autocomplete);
-    g_hash_table_insert(ac_funcs, "/affiliation",   _affiliation_autocomplete);
-    g_hash_table_insert(ac_funcs, "/role",          _role_autocomplete);
-    g_hash_table_insert(ac_funcs, "/resource",      _resource_autocomplete);
+static char *
+_caps_autocomplete(char *input, int *size)
+{
+    return _target_autocomplete(input, size, "/caps", roster_fulljid_autocomplete, TRUE);
+}
 
-    char parsed[*size+1];
-    i = 0;
-    while (i < *size) {
-        if (input[i] == ' ') {
-            break;
-        } else {
-            parsed[i] = input[i];
-        }
-        i++;
-    }
-    parsed[i] = '\0';
+static char *
+_software_autocomplete(char *input, int *size)
+{
+    return _target_autocomplete(input, size, "/software", roster_fulljid_autocomplete, TRUE);
+}
 
-    char * (*ac_func)(char *, int *) = g_hash_table_lookup(ac_funcs, parsed);
-    if (ac_func != NULL) {
-        result = ac_func(input, size);
-        if (result != NULL) {
-            ui_replace_input(input, result, size);
-            g_free(result);
-            g_hash_table_destroy(ac_funcs);
-            return;
+static char *
+_ping_autocomplete(char *input, int *size)
+{
+    return _target_autocomplete(input, size, "/ping", roster_fulljid_autocomplete, FALSE);
+}
+
+static char *
+_target_autocomplete(char *input, int *size, char *command, autocomplete_func roster_func,
+    gboolean muc_nick)
+{
+    // autocomplete nickname in chat rooms
+    if (ui_current_win_type() == WIN_MUC) {
+        if (!muc_nick) {
+            return NULL;
         }
-    }
-    g_hash_table_destroy(ac_funcs);
 
-    input[*size] = '\0';
-    if (g_str_has_prefix(input, "/field")) {
-        result = _form_field_autocomplete(input, size);
-        if (result != NULL) {
-            ui_replace_input(input, result, size);
-            g_free(result);
-            return;
+        ProfMucWin *mucwin = wins_get_current_muc();
+        Autocomplete nick_ac = muc_roster_ac(mucwin->roomjid);
+        if (nick_ac == NULL) {
+            return NULL;
         }
+
+        return autocomplete_param_with_ac(input, size, command, nick_ac, TRUE);
+
+    // otherwise autocomplete using roster
+    } else {
+        return autocomplete_param_with_func(input, size, command, roster_func);
     }
+}
 
-    return;
+static autocomplete_func
+_contact_autocomplete_func(void)
+{
+    if (_complete_fuzzy()) {
+        return roster_contact_fuzzy_autocomplete;
+    } else {
+        return roster_contact_autocomplete;
+    }
 }
 
 static char *
@@ -2424,7 +2505,13 @@ _theme_autocomplete(char *input, int *size)
 {
     char *result = NULL;
     if ((strncmp(input, "/theme set ", 11) == 0) && (*size > 11)) {
+        // reload the theme list for each new search
+        if (theme_load_ac != NULL && theme_load_generation != autocomplete_generation()) {
+            autocomplete_free(theme_load_ac);
+            theme_load_ac = NULL;
+        }
         if (theme_load_ac == NULL) {
+            theme_load_generation = autocomplete_generation();
             theme_load_ac = autocomplete_new();
             GSList *themes = theme_list();
             while (themes != NULL) {
@@ -2816,7 +2903,16 @@ _join_autocomplete(char *input, int *size)
 
     input[*size] = '\0';
 
-    found = autocomplete_param_with_func(input, size, "/join", bookmark_find);
+    found = autocomplete_param_with_func(input, size, "/join", muc_invites_find);
+    if (found != NULL) {
+        return found;
+    }
+
+    if (_complete_fuzzy()) {
+        found = autocomplete_param_with_func(input, size, "/join", bookmark_fuzzy_find);
+    } else {
+        found = autocomplete_param_with_func(input, size, "/join", bookmark_find);
+    }
     if (found != NULL) {
         return found;
     }
@@ -2910,3 +3006,13 @@ _account_autocomplete(char *input, int *size)
     found = autocomplete_param_with_ac(input, size, "/account", account_ac, TRUE);
     return found;
 }
+
+static gboolean
+_complete_fuzzy(void)
+{
+    char *pref_complete = prefs_get_string(PREF_COMPLETE);
+    gboolean result = (g_strcmp0(pref_complete, "fuzzy") == 0);
+    prefs_free_string(pref_complete);
+
+    return result;
+}
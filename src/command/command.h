@@ -66,5 +66,10 @@ GSList * cmd_get_presence_help(void);
 void cmd_history_append(char *inp);
 char *cmd_history_previous(char *inp, int *size);
 char *cmd_history_next(char *inp, int *size);
+void cmd_history_load(const char * const account_name);
+void cmd_history_save(void);
+int cmd_history_search(const char * const search_str, int before);
+int cmd_history_length(void);
+const char * cmd_history_get(int index);
 
 #endif
@@ -61,6 +61,7 @@
 #endif
 #include "profanity.h"
 #include "tools/autocomplete.h"
+#include "tools/frecency.h"
 #include "tools/parser.h"
 #include "tools/tinyurl.h"
 #include "xmpp/xmpp.h"
@@ -78,6 +79,14 @@ static gint _compare_commands(Command *a, Command *b);
 static void _who_room(gchar **args, struct cmd_help_t help);
 static void _who_roster(gchar **args, struct cmd_help_t help);
 
+typedef struct tiny_request_t {
+    win_type_t win_type;
+    char *target;
+} TinyRequest;
+
+static void _tiny_send(const char * const tiny, void *userdata);
+static void _tiny_request_free(TinyRequest *request);
+
 extern GHashTable *commands;
 
 gboolean
@@ -664,7 +673,8 @@ cmd_help(gchar **args, struct cmd_help_t help)
     } else if (strcmp(args[0], "groupchat") == 0) {
         gchar *filter[] = { "/close", "/clear", "/decline", "/grlog",
             "/invite", "/invites", "/join", "/leave", "/notify", "/msg", "/room",
-            "/rooms", "/tiny", "/who", "/nick", "/privileges", "/info", "/occupants" };
+            "/rooms", "/tiny", "/who", "/nick", "/privileges", "/info", "/occupants",
+            "/highlight", "/mentions" };
         _cmd_show_filtered_help("Groupchat commands", filter, ARRAY_SIZE(filter));
 
     } else if (strcmp(args[0], "presence") == 0) {
@@ -678,15 +688,16 @@ cmd_help(gchar **args, struct cmd_help_t help)
         _cmd_show_filtered_help("Roster commands", filter, ARRAY_SIZE(filter));
 
     } else if (strcmp(args[0], "service") == 0) {
-        gchar *filter[] = { "/caps", "/disco", "/info", "/software", "/rooms" };
+        gchar *filter[] = { "/caps", "/disco", "/info", "/software", "/rooms", "/iqstats" };
         _cmd_show_filtered_help("Service discovery commands", filter, ARRAY_SIZE(filter));
 
     } else if (strcmp(args[0], "settings") == 0) {
         gchar *filter[] = { "/account", "/autoaway", "/autoping", "/autoconnect", "/beep",
             "/chlog", "/flash", "/gone", "/grlog", "/history", "/intype",
-            "/log", "/mouse", "/notify", "/outtype", "/prefs", "/priority",
+            "/log", "/mouse", "/multiline", "/notify", "/outtype", "/prefs", "/priority",
             "/reconnect", "/roster", "/splash", "/states", "/statuses", "/theme",
-            "/titlebar", "/vercheck", "/privileges", "/occupants", "/presence", "/wrap" };
+            "/titlebar", "/vercheck", "/privileges", "/occupants", "/presence", "/wrap",
+            "/complete" };
         _cmd_show_filtered_help("Settings commands", filter, ARRAY_SIZE(filter));
 
     } else if (strcmp(args[0], "navigation") == 0) {
@@ -1184,6 +1195,7 @@ cmd_msg(gchar **args, struct cmd_help_t help)
             if (msg != NULL) {
                 message_send_private(full_jid->str, msg);
                 ui_outgoing_private_msg("me", full_jid->str, msg);
+                frecency_record(full_jid->str);
             } else {
                 ui_new_private_win(full_jid->str);
             }
@@ -1223,6 +1235,7 @@ cmd_msg(gchar **args, struct cmd_help_t help)
                     message_send_chat(barejid, resource, encrypted, send_state);
                     otr_free_message(encrypted);
                     ui_outgoing_chat_msg("me", barejid, msg);
+                    frecency_record(barejid);
 
                     if (((win_type == WIN_CHAT) || (win_type == WIN_CONSOLE)) && prefs_get_boolean(PREF_CHLOG)) {
                         const char *jid = jabber_get_fulljid();
@@ -1258,6 +1271,7 @@ cmd_msg(gchar **args, struct cmd_help_t help)
                     message_send_chat(barejid, resource, msg, send_state);
                 }
                 ui_outgoing_chat_msg("me", barejid, msg);
+                frecency_record(barejid);
 
                 if (((win_type == WIN_CHAT) || (win_type == WIN_CONSOLE)) && prefs_get_boolean(PREF_CHLOG)) {
                     const char *jid = jabber_get_fulljid();
@@ -1271,6 +1285,7 @@ cmd_msg(gchar **args, struct cmd_help_t help)
             gboolean send_state = chat_session_on_message_send(barejid);
             message_send_chat(barejid, resource, msg, send_state);
             ui_outgoing_chat_msg("me", barejid, msg);
+            frecency_record(barejid);
 
             if (((win_type == WIN_CHAT) || (win_type == WIN_CONSOLE)) && prefs_get_boolean(PREF_CHLOG)) {
                 const char *jid = jabber_get_fulljid();
@@ -2695,6 +2710,23 @@ cmd_occupants(gchar **args, struct cmd_help_t help)
         }
     }
 
+    if (g_strcmp0(args[0], "compact") == 0) {
+        int intval = 0;
+        if (!args[1]) {
+            cons_show("Usage: %s", help.usage);
+            return TRUE;
+        } else if (_strtoi(args[1], &intval, 0, INT_MAX) == 0) {
+            prefs_set_occupants_compact(intval);
+            muc_set_compact_threshold(intval);
+            if (intval == 0) {
+                cons_show("Compact occupant storage disabled.");
+            } else {
+                cons_show("Rooms with at least %d occupants will use compact storage.", intval);
+            }
+            return TRUE;
+        }
+    }
+
     if (g_strcmp0(args[0], "default") == 0) {
         if (g_strcmp0(args[1], "show") == 0) {
             cons_show("Occupant list enabled.");
@@ -3000,76 +3032,104 @@ cmd_tiny(gchar **args, struct cmd_help_t help)
         }
         g_string_free(error, TRUE);
     } else if (win_type != WIN_CONSOLE) {
-        char *tiny = tinyurl_get(url);
+        TinyRequest *request = malloc(sizeof(TinyRequest));
+        request->win_type = win_type;
+        if (win_type == WIN_CHAT) {
+            ProfChatWin *chatwin = wins_get_current_chat();
+            request->target = strdup(chatwin->barejid);
+        } else if (win_type == WIN_PRIVATE) {
+            ProfPrivateWin *privatewin = wins_get_current_private();
+            request->target = strdup(privatewin->fulljid);
+        } else {
+            ProfMucWin *mucwin = wins_get_current_muc();
+            request->target = strdup(mucwin->roomjid);
+        }
 
-        if (tiny != NULL) {
-            if (win_type == WIN_CHAT) {
-                ProfChatWin *chatwin = wins_get_current_chat();
-#ifdef HAVE_LIBOTR
-                if (otr_is_secure(chatwin->barejid)) {
-                    char *encrypted = otr_encrypt_message(chatwin->barejid, tiny);
-                    if (encrypted != NULL) {
-                        gboolean send_state = chat_session_on_message_send(chatwin->barejid);
-                        message_send_chat(chatwin->barejid, chatwin->resource, encrypted, send_state);
-                        otr_free_message(encrypted);
-                        if (prefs_get_boolean(PREF_CHLOG)) {
-                            const char *jid = jabber_get_fulljid();
-                            Jid *jidp = jid_create(jid);
-                            char *pref_otr_log = prefs_get_string(PREF_OTR_LOG);
-                            if (strcmp(pref_otr_log, "on") == 0) {
-                                chat_log_chat(jidp->barejid, chatwin->barejid, tiny, PROF_OUT_LOG, NULL);
-                            } else if (strcmp(pref_otr_log, "redact") == 0) {
-                                chat_log_chat(jidp->barejid, chatwin->barejid, "[redacted]", PROF_OUT_LOG, NULL);
-                            }
-                            prefs_free_string(pref_otr_log);
-                            jid_destroy(jidp);
-                        }
+        // sent to the same recipient when the url arrives
+        tinyurl_get(url, _tiny_send, request, (GDestroyNotify)_tiny_request_free);
+    } else {
+        cons_show("/tiny can only be used in chat windows");
+    }
 
-                        ui_outgoing_chat_msg("me", chatwin->barejid, tiny);
-                    } else {
-                        cons_show_error("Failed to send message.");
-                    }
-                } else {
-                    gboolean send_state = chat_session_on_message_send(chatwin->barejid);
-                    message_send_chat(chatwin->barejid, chatwin->resource, tiny, send_state);
-                    if (prefs_get_boolean(PREF_CHLOG)) {
-                        const char *jid = jabber_get_fulljid();
-                        Jid *jidp = jid_create(jid);
-                        chat_log_chat(jidp->barejid, chatwin->barejid, tiny, PROF_OUT_LOG, NULL);
-                        jid_destroy(jidp);
-                    }
+    return TRUE;
+}
 
-                    ui_outgoing_chat_msg("me", chatwin->barejid, tiny);
-                }
-#else
-                gboolean send_state = chat_session_on_message_send(chatwin->barejid);
-                message_send_chat(chatwin->barejid, chatwin->resource, tiny, send_state);
+static void
+_tiny_send(const char * const tiny, void *userdata)
+{
+    TinyRequest *request = userdata;
+
+    if (tiny == NULL) {
+        cons_show_error("Couldn't get tinyurl.");
+        return;
+    }
+
+    if (jabber_get_connection_status() != JABBER_CONNECTED) {
+        cons_show_error("Couldn't send tinyurl, not connected.");
+        return;
+    }
+
+    if (request->win_type == WIN_CHAT) {
+        char *barejid = request->target;
+        ProfChatWin *chatwin = wins_get_chat(barejid);
+        char *resource = chatwin ? chatwin->resource : NULL;
+#ifdef HAVE_LIBOTR
+        if (otr_is_secure(barejid)) {
+            char *encrypted = otr_encrypt_message(barejid, tiny);
+            if (encrypted != NULL) {
+                gboolean send_state = chat_session_on_message_send(barejid);
+                message_send_chat(barejid, resource, encrypted, send_state);
+                otr_free_message(encrypted);
                 if (prefs_get_boolean(PREF_CHLOG)) {
-                    const char *jid = jabber_get_fulljid();
-                    Jid *jidp = jid_create(jid);
-                    chat_log_chat(jidp->barejid, chatwin->barejid, tiny, PROF_OUT_LOG, NULL);
-                    jid_destroy(jidp);
+                    char *pref_otr_log = prefs_get_string(PREF_OTR_LOG);
+                    if (strcmp(pref_otr_log, "on") == 0) {
+                        chat_log_chat(jabber_get_barejid(), barejid, tiny, PROF_OUT_LOG, NULL);
+                    } else if (strcmp(pref_otr_log, "redact") == 0) {
+                        chat_log_chat(jabber_get_barejid(), barejid, "[redacted]", PROF_OUT_LOG, NULL);
+                    }
+                    prefs_free_string(pref_otr_log);
                 }
 
-                ui_outgoing_chat_msg("me", chatwin->barejid, tiny);
-#endif
-            } else if (win_type == WIN_PRIVATE) {
-                ProfPrivateWin *privatewin = wins_get_current_private();
-                message_send_private(tiny, privatewin->fulljid);
-                ui_outgoing_private_msg("me", privatewin->fulljid, tiny);
-            } else if (win_type == WIN_MUC) {
-                ProfMucWin *mucwin = wins_get_current_muc();
-                message_send_groupchat(tiny, mucwin->roomjid);
+                ui_outgoing_chat_msg("me", barejid, tiny);
+            } else {
+                cons_show_error("Failed to send message.");
             }
-            free(tiny);
         } else {
-            cons_show_error("Couldn't get tinyurl.");
+            gboolean send_state = chat_session_on_message_send(barejid);
+            message_send_chat(barejid, resource, tiny, send_state);
+            if (prefs_get_boolean(PREF_CHLOG)) {
+                chat_log_chat(jabber_get_barejid(), barejid, tiny, PROF_OUT_LOG, NULL);
+            }
+
+            ui_outgoing_chat_msg("me", barejid, tiny);
+        }
+#else
+        gboolean send_state = chat_session_on_message_send(barejid);
+        message_send_chat(barejid, resource, tiny, send_state);
+        if (prefs_get_boolean(PREF_CHLOG)) {
+            chat_log_chat(jabber_get_barejid(), barejid, tiny, PROF_OUT_LOG, NULL);
+        }
+
+        ui_outgoing_chat_msg("me", barejid, tiny);
+#endif
+    } else if (request->win_type == WIN_PRIVATE) {
+        message_send_private(request->target, tiny);
+        ui_outgoing_private_msg("me", request->target, tiny);
+    } else if (request->win_type == WIN_MUC) {
+        // the room may have been left while the url was fetched
+        if (muc_active(request->target)) {
+            message_send_groupchat(request->target, tiny);
+        } else {
+            cons_show("Tinyurl not sent, no longer in room %s.", request->target);
         }
-    } else {
-        cons_show("/tiny can only be used in chat windows");
     }
+}
 
-    return TRUE;
+static void
+_tiny_request_free(TinyRequest *request)
+{
+    free(request->target);
+    free(request);
 }
 
 gboolean
@@ -3230,6 +3290,23 @@ cmd_time(gchar **args, struct cmd_help_t help)
     }
 }
 
+gboolean
+cmd_complete(gchar **args, struct cmd_help_t help)
+{
+    if (g_strcmp0(args[0], "prefix") == 0) {
+        prefs_set_string(PREF_COMPLETE, "prefix");
+        cons_show("Completion set to prefix.");
+        return TRUE;
+    } else if (g_strcmp0(args[0], "fuzzy") == 0) {
+        prefs_set_string(PREF_COMPLETE, "fuzzy");
+        cons_show("Completion set to fuzzy.");
+        return TRUE;
+    } else {
+        cons_show("Usage: %s", help.usage);
+        return TRUE;
+    }
+}
+
 gboolean
 cmd_states(gchar **args, struct cmd_help_t help)
 {
@@ -3542,6 +3619,11 @@ cmd_autoping(gchar **args, struct cmd_help_t help)
 gboolean
 cmd_ping(gchar **args, struct cmd_help_t help)
 {
+    if (g_strcmp0(args[0], "stats") == 0) {
+        cons_show_ping_stats(iq_autoping_stats(), iq_autoping_interval(), iq_autoping_last_rtt());
+        return TRUE;
+    }
+
     jabber_conn_status_t conn_status = jabber_get_connection_status();
 
     if (conn_status != JABBER_CONNECTED) {
@@ -3559,6 +3641,23 @@ cmd_ping(gchar **args, struct cmd_help_t help)
     return TRUE;
 }
 
+gboolean
+cmd_iqstats(gchar **args, struct cmd_help_t help)
+{
+    if (args[0] == NULL) {
+        GList *stats = iq_stats_list();
+        cons_show_iq_stats(stats, iq_outstanding_count());
+        g_list_free(stats);
+    } else if (strcmp(args[0], "reset") == 0) {
+        iq_stats_reset();
+        cons_show("IQ statistics cleared.");
+    } else {
+        cons_show("Usage: %s", help.usage);
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_autoaway(gchar **args, struct cmd_help_t help)
 {
@@ -3703,6 +3802,91 @@ cmd_vercheck(gchar **args, struct cmd_help_t help)
     }
 }
 
+gboolean
+cmd_highlight(gchar **args, struct cmd_help_t help)
+{
+    char *subcmd = args[0];
+
+    if (g_strcmp0(subcmd, "list") == 0) {
+        GList *words = prefs_get_highlights(FALSE);
+        GList *regexes = prefs_get_highlights(TRUE);
+        if (!words && !regexes) {
+            cons_show("No highlight words.");
+        } else {
+            cons_show("Highlight words:");
+            GList *curr = words;
+            while (curr) {
+                cons_show("  %s", curr->data);
+                curr = g_list_next(curr);
+            }
+            curr = regexes;
+            while (curr) {
+                cons_show("  %s (regex)", curr->data);
+                curr = g_list_next(curr);
+            }
+        }
+        g_list_free_full(words, g_free);
+        g_list_free_full(regexes, g_free);
+        return TRUE;
+    }
+
+    char *value = args[1];
+    if (!value) {
+        cons_show("Usage: %s", help.usage);
+        return TRUE;
+    }
+
+    if (g_strcmp0(subcmd, "add") == 0) {
+        if (prefs_add_highlight(value, FALSE)) {
+            ui_highlights_changed();
+            cons_show("Highlight word added: %s", value);
+        } else {
+            cons_show("Already highlighting: %s", value);
+        }
+    } else if (g_strcmp0(subcmd, "regex") == 0) {
+        GError *error = NULL;
+        GRegex *regex = g_regex_new(value, G_REGEX_CASELESS, 0, &error);
+        if (!regex) {
+            cons_show_error("Invalid regular expression: %s", error->message);
+            g_error_free(error);
+        } else {
+            g_regex_unref(regex);
+            if (prefs_add_highlight(value, TRUE)) {
+                ui_highlights_changed();
+                cons_show("Highlight regular expression added: %s", value);
+            } else {
+                cons_show("Already highlighting: %s", value);
+            }
+        }
+    } else if (g_strcmp0(subcmd, "remove") == 0) {
+        if (prefs_remove_highlight(value)) {
+            ui_highlights_changed();
+            cons_show("Highlight removed: %s", value);
+        } else {
+            cons_show("No such highlight: %s", value);
+        }
+    } else {
+        cons_show("Usage: %s", help.usage);
+    }
+
+    return TRUE;
+}
+
+gboolean
+cmd_mentions(gchar **args, struct cmd_help_t help)
+{
+    if (args[0] == NULL) {
+        ui_show_mentions();
+    } else if (g_strcmp0(args[0], "clear") == 0) {
+        ui_clear_mentions();
+        cons_show("Mentions cleared.");
+    } else {
+        cons_show("Usage: %s", help.usage);
+    }
+
+    return TRUE;
+}
+
 gboolean
 cmd_xmlconsole(gchar **args, struct cmd_help_t help)
 {
@@ -3781,6 +3965,13 @@ cmd_mouse(gchar **args, struct cmd_help_t help)
         "Mouse handling", PREF_MOUSE);
 }
 
+gboolean
+cmd_multiline(gchar **args, struct cmd_help_t help)
+{
+    return _cmd_set_boolean_preference(args[0], help,
+        "Multi-line paste sending", PREF_MULTILINE);
+}
+
 gboolean
 cmd_history(gchar **args, struct cmd_help_t help)
 {
@@ -3943,6 +4134,29 @@ cmd_otr(gchar **args, struct cmd_help_t help)
         }
         return TRUE;
 
+    } else if (strcmp(args[0], "stats") == 0) {
+        win_type_t win_type = ui_current_win_type();
+
+        if (win_type != WIN_CHAT) {
+            ui_current_print_line("You must be in a regular chat window to view OTR statistics.");
+        } else {
+            ProfChatWin *chatwin = ui_get_current_chat();
+            OtrStats *stats = otr_stats(chatwin->barejid);
+            if (stats == NULL) {
+                ui_current_print_formatted_line('!', 0, "No messages passed through OTR with %s.", chatwin->barejid);
+            } else {
+                if (stats->encrypted > 0) {
+                    ui_current_print_formatted_line('!', 0, "Encrypted %d messages, average: %dus, max: %dus",
+                        stats->encrypted, (int)(stats->encrypt_micros / stats->encrypted), stats->encrypt_max_micros);
+                }
+                if (stats->decrypted > 0) {
+                    ui_current_print_formatted_line('!', 0, "Decrypted %d messages, average: %dus, max: %dus",
+                        stats->decrypted, (int)(stats->decrypt_micros / stats->decrypted), stats->decrypt_max_micros);
+                }
+            }
+        }
+        return TRUE;
+
     } else if (strcmp(args[0], "start") == 0) {
         if (args[1] != NULL) {
             char *contact = args[1];
@@ -93,6 +93,7 @@ gboolean cmd_join(gchar **args, struct cmd_help_t help);
 gboolean cmd_leave(gchar **args, struct cmd_help_t help);
 gboolean cmd_log(gchar **args, struct cmd_help_t help);
 gboolean cmd_mouse(gchar **args, struct cmd_help_t help);
+gboolean cmd_multiline(gchar **args, struct cmd_help_t help);
 gboolean cmd_msg(gchar **args, struct cmd_help_t help);
 gboolean cmd_nick(gchar **args, struct cmd_help_t help);
 gboolean cmd_notify(gchar **args, struct cmd_help_t help);
@@ -123,7 +124,10 @@ gboolean cmd_wins(gchar **args, struct cmd_help_t help);
 gboolean cmd_xa(gchar **args, struct cmd_help_t help);
 gboolean cmd_alias(gchar **args, struct cmd_help_t help);
 gboolean cmd_xmlconsole(gchar **args, struct cmd_help_t help);
+gboolean cmd_highlight(gchar **args, struct cmd_help_t help);
+gboolean cmd_mentions(gchar **args, struct cmd_help_t help);
 gboolean cmd_ping(gchar **args, struct cmd_help_t help);
+gboolean cmd_iqstats(gchar **args, struct cmd_help_t help);
 gboolean cmd_form(gchar **args, struct cmd_help_t help);
 gboolean cmd_occupants(gchar **args, struct cmd_help_t help);
 gboolean cmd_kick(gchar **args, struct cmd_help_t help);
@@ -135,6 +139,7 @@ gboolean cmd_privileges(gchar **args, struct cmd_help_t help);
 gboolean cmd_presence(gchar **args, struct cmd_help_t help);
 gboolean cmd_wrap(gchar **args, struct cmd_help_t help);
 gboolean cmd_time(gchar **args, struct cmd_help_t help);
+gboolean cmd_complete(gchar **args, struct cmd_help_t help);
 gboolean cmd_resource(gchar **args, struct cmd_help_t help);
 gboolean cmd_inpblock(gchar **args, struct cmd_help_t help);
 
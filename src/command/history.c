@@ -32,13 +32,26 @@
  *
  */
 
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "command/command.h"
 #include "tools/history.h"
+#include "ui/ui.h"
 
-#define MAX_HISTORY 100
+#define MAX_HISTORY 1000
 
 static History history;
 
+// account whose history is loaded, NULL before the first login
+static char *history_account = NULL;
+
 void _stringify_input(char *inp, int size, char *string);
+static gchar * _get_history_file(const char * const account_name);
+static gboolean _is_private(const char * const inp);
 
 void
 cmd_history_init(void)
@@ -46,9 +59,63 @@ cmd_history_init(void)
     history = history_new(MAX_HISTORY);
 }
 
+void
+cmd_history_load(const char * const account_name)
+{
+    if (g_strcmp0(history_account, account_name) == 0) {
+        return;
+    }
+
+    // switching account, keep what was typed for the last one
+    if (history_account) {
+        cmd_history_save();
+        history_free(history);
+        history = history_new(MAX_HISTORY);
+        free(history_account);
+    }
+
+    history_account = strdup(account_name);
+    gchar *history_file = _get_history_file(history_account);
+    history_load(history, history_file);
+    g_free(history_file);
+}
+
+void
+cmd_history_save(void)
+{
+    if (history_account) {
+        gchar *history_file = _get_history_file(history_account);
+        history_save(history, history_file);
+        g_free(history_file);
+    }
+}
+
+int
+cmd_history_search(const char * const search_str, int before)
+{
+    return history_search(history, search_str, before);
+}
+
+int
+cmd_history_length(void)
+{
+    return history_length(history);
+}
+
+const char *
+cmd_history_get(int index)
+{
+    return history_get(history, index);
+}
+
 void
 cmd_history_append(char *inp)
 {
+    // history is written to disk, never keep secrets in it
+    if (_is_private(inp)) {
+        return;
+    }
+
     history_append(history, inp);
 }
 
@@ -79,3 +146,44 @@ _stringify_input(char *inp, int size, char *string)
     }
     string[size] = '\0';
 }
+
+static gchar *
+_get_history_file(const char * const account_name)
+{
+    gchar *xdg_data = xdg_get_data_home();
+    gchar *account_file = str_replace(account_name, "/", "_");
+    gchar *result = g_strdup_printf("%s/profanity/history/%s", xdg_data, account_file);
+
+    free(account_file);
+    g_free(xdg_data);
+
+    return result;
+}
+
+static gboolean
+_is_private(const char * const inp)
+{
+    if (inp[0] != '/') {
+        return ui_current_win_is_otr();
+    }
+
+    gboolean result = FALSE;
+    gchar **args = g_strsplit(inp, " ", 0);
+    int i;
+    for (i = 1; args[i] != NULL; i++) {
+        if (g_strcmp0(args[i], "password") == 0) {
+            result = TRUE;
+            break;
+        }
+    }
+
+    if (!result && g_strcmp0(args[0], "/otr") == 0 && args[1] != NULL) {
+        result = g_strcmp0(args[1], "secret") == 0 ||
+            g_strcmp0(args[1], "question") == 0 ||
+            g_strcmp0(args[1], "answer") == 0;
+    }
+
+    g_strfreev(args);
+
+    return result;
+}
@@ -41,8 +41,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
-#include <curl/curl.h>
-#include <curl/easy.h>
 #include <glib.h>
 
 #include "tools/p_sha1.h"
@@ -54,13 +52,8 @@
 // and page size is at least 4KB
 #define READ_BUF_SIZE 4088
 
-struct curl_data_t
-{
-    char *buffer;
-    size_t size;
-};
-
-static size_t _data_callback(void *ptr, size_t size, size_t nmemb, void *data);
+#define RELEASE_TIMEOUT_SECS 2
+#define RELEASE_CACHE_SECS (60 * 60)
 
 // taken from glib 2.30.3
 gchar *
@@ -92,6 +85,18 @@ p_list_free_full(GList *items, GDestroyNotify free_func)
     g_list_free (items);
 }
 
+gint64
+p_get_monotonic_time(void)
+{
+    // microseconds since first use, GTimer is the nearest to a monotonic clock
+    static GTimer *timer = NULL;
+    if (timer == NULL) {
+        timer = g_timer_new();
+    }
+
+    return g_timer_elapsed(timer, NULL) * G_USEC_PER_SEC;
+}
+
 gboolean
 p_hash_table_add(GHashTable *hash_table, gpointer key)
 {
@@ -110,6 +115,13 @@ p_hash_table_contains(GHashTable  *hash_table, gconstpointer key)
     return (found != NULL);
 }
 
+void
+p_queue_free_full(GQueue *queue, GDestroyNotify free_func)
+{
+    g_queue_foreach (queue, (GFunc) free_func, NULL);
+    g_queue_free (queue);
+}
+
 gboolean
 create_dir(char *name)
 {
@@ -249,34 +261,40 @@ prof_getline(FILE *stream)
     return s;
 }
 
-char *
-release_get_latest()
+/*
+ * Read a stream from its start, used to collect what libraries write to a
+ * tmpfile() as open_memstream is not available everywhere
+ */
+gchar *
+prof_read_stream(FILE *stream, gsize *length)
 {
-    char *url = "http://www.profanity.im/profanity_version.txt";
-
-    CURL *handle = curl_easy_init();
-    struct curl_data_t output;
-    output.buffer = NULL;
-    output.size = 0;
+    rewind(stream);
 
-    curl_easy_setopt(handle, CURLOPT_URL, url);
-    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, _data_callback);
-    curl_easy_setopt(handle, CURLOPT_TIMEOUT, 2);
-    curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void *)&output);
-
-    curl_easy_perform(handle);
-    curl_easy_cleanup(handle);
+    GString *contents = g_string_new("");
+    char buf[READ_BUF_SIZE];
+    size_t read;
+    while ((read = fread(buf, 1, sizeof(buf), stream)) > 0) {
+        g_string_append_len(contents, buf, read);
+    }
 
-    if (output.buffer != NULL) {
-        output.buffer[output.size++] = '\0';
-        return output.buffer;
-    } else {
+    if (ferror(stream)) {
+        g_string_free(contents, TRUE);
         return NULL;
     }
+
+    *length = contents->len;
+    return g_string_free(contents, FALSE);
+}
+
+void
+release_get_latest(http_func func, void *userdata, GDestroyNotify free_func)
+{
+    http_get("http://www.profanity.im/profanity_version.txt", RELEASE_TIMEOUT_SECS, RELEASE_CACHE_SECS,
+        func, userdata, free_func);
 }
 
 gboolean
-release_is_new(char *found_version)
+release_is_new(const char * const found_version)
 {
     int curr_maj, curr_min, curr_patch, found_maj, found_min, found_patch;
 
@@ -506,23 +524,6 @@ get_next_available_win_num(GList *used)
 }
 
 
-static size_t
-_data_callback(void *ptr, size_t size, size_t nmemb, void *data)
-{
-    size_t realsize = size * nmemb;
-    struct curl_data_t *mem = (struct curl_data_t *) data;
-    mem->buffer = realloc(mem->buffer, mem->size + realsize + 1);
-
-    if ( mem->buffer )
-    {
-        memcpy( &( mem->buffer[ mem->size ] ), ptr, realsize );
-        mem->size += realsize;
-        mem->buffer[ mem->size ] = 0;
-    }
-
-    return realsize;
-}
-
 char*
 get_file_or_linked(char *loc, char *basedir)
 {
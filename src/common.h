@@ -39,9 +39,12 @@
 
 #include <glib.h>
 
+#include "tools/http.h"
+
 #if !GLIB_CHECK_VERSION(2,28,0)
 #define g_slist_free_full(items, free_func)         p_slist_free_full(items, free_func)
 #define g_list_free_full(items, free_func)          p_list_free_full(items, free_func)
+#define g_get_monotonic_time()                      p_get_monotonic_time()
 #endif
 
 #if !GLIB_CHECK_VERSION(2,30,0)
@@ -51,6 +54,7 @@
 #if !GLIB_CHECK_VERSION(2,32,0)
 #define g_hash_table_add(hash_table, key)           p_hash_table_add(hash_table, key)
 #define g_hash_table_contains(hash_table, key)      p_hash_table_contains(hash_table, key)
+#define g_queue_free_full(queue, free_func)         p_queue_free_full(queue, free_func)
 #endif
 
 #ifndef NOTIFY_CHECK_VERSION
@@ -91,8 +95,10 @@ typedef enum {
 gchar* p_utf8_substring(const gchar *str, glong start_pos, glong end_pos);
 void p_slist_free_full(GSList *items, GDestroyNotify free_func);
 void p_list_free_full(GList *items, GDestroyNotify free_func);
+gint64 p_get_monotonic_time(void);
 gboolean p_hash_table_add(GHashTable *hash_table, gpointer key);
 gboolean p_hash_table_contains(GHashTable  *hash_table, gconstpointer  key);
+void p_queue_free_full(GQueue *queue, GDestroyNotify free_func);
 
 gboolean create_dir(char *name);
 gboolean mkdir_recursive(const char *dir);
@@ -100,8 +106,9 @@ char * str_replace(const char *string, const char *substr,
     const char *replacement);
 int str_contains(char str[], int size, char ch);
 char * prof_getline(FILE *stream);
-char* release_get_latest(void);
-gboolean release_is_new(char *found_version);
+gchar * prof_read_stream(FILE *stream, gsize *length);
+void release_get_latest(http_func func, void *userdata, GDestroyNotify free_func);
+gboolean release_is_new(const char * const found_version);
 gchar * xdg_get_config_home(void);
 gchar * xdg_get_data_home(void);
 
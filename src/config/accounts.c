@@ -45,10 +45,14 @@
 #include "jid.h"
 #include "log.h"
 #include "tools/autocomplete.h"
+#include "tools/filewriter.h"
 #include "xmpp/xmpp.h"
 
+#define ACCOUNTS_SAVE_DELAY_MS 1000
+
 static gchar *accounts_loc;
 static GKeyFile *accounts;
+static FileWriter accounts_writer = NULL;
 
 static Autocomplete all_ac;
 static Autocomplete enabled_ac;
@@ -69,6 +73,7 @@ static gchar *string_keys[] = {
 
 static void _fix_legacy_accounts(const char * const account_name);
 static void _save_accounts(void);
+static gchar * _serialise_accounts(gsize *length);
 static gchar * _get_accounts_file(void);
 static void _remove_from_list(GKeyFile *accounts, const char * const account_name, const char * const key, const char * const contact_jid);
 
@@ -89,6 +94,15 @@ accounts_load(void)
     g_key_file_load_from_file(accounts, accounts_loc, G_KEY_FILE_KEEP_COMMENTS,
         NULL);
 
+    gchar *xdg_data = xdg_get_data_home();
+    GString *base_str = g_string_new(xdg_data);
+    g_string_append(base_str, "/profanity/");
+    gchar *true_loc = get_file_or_linked(accounts_loc, base_str->str);
+    accounts_writer = filewriter_new(true_loc, _serialise_accounts, ACCOUNTS_SAVE_DELAY_MS);
+    g_free(xdg_data);
+    free(true_loc);
+    g_string_free(base_str, TRUE);
+
     // create the logins searchable list for autocompletion
     gsize naccounts;
     gchar **account_names =
@@ -110,6 +124,8 @@ accounts_load(void)
 void
 accounts_close(void)
 {
+    filewriter_free(accounts_writer);
+    accounts_writer = NULL;
     autocomplete_free(all_ac);
     autocomplete_free(enabled_ac);
     g_key_file_free(accounts);
@@ -127,18 +143,6 @@ accounts_find_all(char *prefix)
     return autocomplete_complete(all_ac, prefix, TRUE);
 }
 
-void
-accounts_reset_all_search(void)
-{
-    autocomplete_reset(all_ac);
-}
-
-void
-accounts_reset_enabled_search(void)
-{
-    autocomplete_reset(enabled_ac);
-}
-
 void
 accounts_add(const char *account_name, const char *altdomain, const int port)
 {
@@ -834,18 +838,13 @@ _fix_legacy_accounts(const char * const account_name)
 static void
 _save_accounts(void)
 {
-    gsize g_data_size;
-    gchar *g_accounts_data = g_key_file_to_data(accounts, &g_data_size, NULL);
-    gchar *xdg_data = xdg_get_data_home();
-    GString *base_str = g_string_new(xdg_data);
-    g_string_append(base_str, "/profanity/");
-    gchar *true_loc = get_file_or_linked(accounts_loc, base_str->str);
-    g_file_set_contents(true_loc, g_accounts_data, g_data_size, NULL);
-    g_chmod(accounts_loc, S_IRUSR | S_IWUSR);
-    g_free(xdg_data);
-    free(true_loc);
-    g_free(g_accounts_data);
-    g_string_free(base_str, TRUE);
+    filewriter_changed(accounts_writer);
+}
+
+static gchar *
+_serialise_accounts(gsize *length)
+{
+    return g_key_file_to_data(accounts, length, NULL);
 }
 
 static gchar *
@@ -45,8 +45,6 @@ void accounts_close(void);
 
 char * accounts_find_all(char *prefix);
 char * accounts_find_enabled(char *prefix);
-void accounts_reset_all_search(void);
-void accounts_reset_enabled_search(void);
 void accounts_add(const char *jid, const char *altdomain, const int port);
 int  accounts_remove(const char *jid);
 gchar** accounts_get_list(void);
@@ -51,6 +51,7 @@
 #include "log.h"
 #include "preferences.h"
 #include "tools/autocomplete.h"
+#include "tools/filewriter.h"
 
 #define PREF_GROUP_LOGGING "logging"
 #define PREF_GROUP_CHATSTATES "chatstates"
@@ -60,16 +61,20 @@
 #define PREF_GROUP_CONNECTION "connection"
 #define PREF_GROUP_ALIAS "alias"
 #define PREF_GROUP_OTR "otr"
+#define PREF_GROUP_HIGHLIGHT "highlight"
 
 #define INPBLOCK_DEFAULT 20
+#define PREFS_SAVE_DELAY_MS 1000
 
 static gchar *prefs_loc;
 static GKeyFile *prefs;
+static FileWriter prefs_writer = NULL;
 gint log_maxsize = 0;
 
 static Autocomplete boolean_choice_ac;
 
 static void _save_prefs(void);
+static gchar * _serialise_prefs(gsize *length);
 static gchar * _get_preferences_file(void);
 static const char * _get_group(preference_t pref);
 static const char * _get_key(preference_t pref);
@@ -80,6 +85,7 @@ void
 prefs_load(void)
 {
     GError *err;
+    gboolean migrated = FALSE;
 
     log_info("Loading preferences");
     prefs_loc = _get_preferences_file();
@@ -105,6 +111,7 @@ prefs_load(void)
     if (err == NULL) {
         g_key_file_set_boolean(prefs, PREF_GROUP_OTR, _get_key(PREF_OTR_WARN), ui_otr_warn);
         g_key_file_remove_key(prefs, PREF_GROUP_UI, "otr.warn", NULL);
+        migrated = TRUE;
     } else {
         g_error_free(err);
     }
@@ -114,6 +121,7 @@ prefs_load(void)
     if (err == NULL) {
         g_key_file_set_string(prefs, PREF_GROUP_OTR, _get_key(PREF_OTR_LOG), ui_otr_log);
         g_key_file_remove_key(prefs, PREF_GROUP_LOGGING, "otr", NULL);
+        migrated = TRUE;
     } else {
         g_error_free(err);
     }
@@ -123,11 +131,23 @@ prefs_load(void)
     if (err == NULL) {
         g_key_file_set_string(prefs, PREF_GROUP_OTR, _get_key(PREF_OTR_POLICY), ui_otr_policy);
         g_key_file_remove_group(prefs, "policy", NULL);
+        migrated = TRUE;
     } else {
         g_error_free(err);
     }
 
-    _save_prefs();
+    gchar *xdg_config = xdg_get_config_home();
+    GString *base_str = g_string_new(xdg_config);
+    g_string_append(base_str, "/profanity/");
+    gchar *true_loc = get_file_or_linked(prefs_loc, base_str->str);
+    prefs_writer = filewriter_new(true_loc, _serialise_prefs, PREFS_SAVE_DELAY_MS);
+    g_free(xdg_config);
+    free(true_loc);
+    g_string_free(base_str, TRUE);
+
+    if (migrated) {
+        _save_prefs();
+    }
 
     boolean_choice_ac = autocomplete_new();
     autocomplete_add(boolean_choice_ac, "on");
@@ -137,6 +157,8 @@ prefs_load(void)
 void
 prefs_close(void)
 {
+    filewriter_free(prefs_writer);
+    prefs_writer = NULL;
     autocomplete_free(boolean_choice_ac);
     g_key_file_free(prefs);
     prefs = NULL;
@@ -148,12 +170,6 @@ prefs_autocomplete_boolean_choice(char *prefix)
     return autocomplete_complete(boolean_choice_ac, prefix, TRUE);
 }
 
-void
-prefs_reset_boolean_choice(void)
-{
-    autocomplete_reset(boolean_choice_ac);
-}
-
 gboolean
 prefs_get_boolean(preference_t pref)
 {
@@ -353,6 +369,28 @@ prefs_get_occupants_size(void)
     }
 }
 
+void
+prefs_set_occupants_compact(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_UI, "occupants.compact", value);
+    _save_prefs();
+}
+
+gint
+prefs_get_occupants_compact(void)
+{
+    if (!g_key_file_has_key(prefs, PREF_GROUP_UI, "occupants.compact", NULL)) {
+        return PREFS_DEFAULT_OCCUPANTS_COMPACT;
+    }
+
+    gint result = g_key_file_get_integer(prefs, PREF_GROUP_UI, "occupants.compact", NULL);
+    if (result < 0) {
+        return PREFS_DEFAULT_OCCUPANTS_COMPACT;
+    } else {
+        return result;
+    }
+}
+
 void
 prefs_set_roster_size(gint value)
 {
@@ -403,6 +441,107 @@ prefs_remove_alias(const char * const name)
     }
 }
 
+/*
+ * Add a word, or a regular expression when regex is TRUE, to highlight in
+ * chat rooms, returns FALSE if it is already present
+ */
+gboolean
+prefs_add_highlight(const char * const value, gboolean regex)
+{
+    const char *key = regex ? "regex" : "words";
+    gsize len = 0;
+    gchar **values = g_key_file_get_string_list(prefs, PREF_GROUP_HIGHLIGHT, key, &len, NULL);
+
+    gsize i;
+    for (i = 0; i < len; i++) {
+        if (strcmp(values[i], value) == 0) {
+            g_strfreev(values);
+            return FALSE;
+        }
+    }
+
+    GPtrArray *updated = g_ptr_array_new();
+    for (i = 0; i < len; i++) {
+        g_ptr_array_add(updated, values[i]);
+    }
+    g_ptr_array_add(updated, (gpointer)value);
+
+    g_key_file_set_string_list(prefs, PREF_GROUP_HIGHLIGHT, key,
+        (const gchar * const *)updated->pdata, updated->len);
+    _save_prefs();
+
+    g_ptr_array_free(updated, TRUE);
+    g_strfreev(values);
+
+    return TRUE;
+}
+
+/*
+ * Remove a highlight word or regular expression, returns FALSE if neither
+ * list contains it
+ */
+gboolean
+prefs_remove_highlight(const char * const value)
+{
+    gboolean removed = FALSE;
+    const char *keys[] = { "words", "regex" };
+
+    int k;
+    for (k = 0; k < 2; k++) {
+        gsize len = 0;
+        gchar **values = g_key_file_get_string_list(prefs, PREF_GROUP_HIGHLIGHT, keys[k], &len, NULL);
+
+        GPtrArray *updated = g_ptr_array_new();
+        gsize i;
+        for (i = 0; i < len; i++) {
+            if (strcmp(values[i], value) == 0) {
+                removed = TRUE;
+            } else {
+                g_ptr_array_add(updated, values[i]);
+            }
+        }
+
+        if (updated->len < len) {
+            if (updated->len == 0) {
+                g_key_file_remove_key(prefs, PREF_GROUP_HIGHLIGHT, keys[k], NULL);
+            } else {
+                g_key_file_set_string_list(prefs, PREF_GROUP_HIGHLIGHT, keys[k],
+                    (const gchar * const *)updated->pdata, updated->len);
+            }
+        }
+
+        g_ptr_array_free(updated, TRUE);
+        g_strfreev(values);
+    }
+
+    if (removed) {
+        _save_prefs();
+    }
+
+    return removed;
+}
+
+/*
+ * Return the highlight words, or regular expressions when regex is TRUE,
+ * free with g_list_free_full(list, g_free)
+ */
+GList *
+prefs_get_highlights(gboolean regex)
+{
+    const char *key = regex ? "regex" : "words";
+    gsize len = 0;
+    gchar **values = g_key_file_get_string_list(prefs, PREF_GROUP_HIGHLIGHT, key, &len, NULL);
+
+    GList *result = NULL;
+    gsize i;
+    for (i = 0; i < len; i++) {
+        result = g_list_append(result, g_strdup(values[i]));
+    }
+    g_strfreev(values);
+
+    return result;
+}
+
 static gint
 _alias_cmp(gconstpointer *p1, gconstpointer *p2)
 {
@@ -460,18 +599,13 @@ prefs_free_aliases(GList *aliases)
 static void
 _save_prefs(void)
 {
-    gsize g_data_size;
-    gchar *g_prefs_data = g_key_file_to_data(prefs, &g_data_size, NULL);
-    gchar *xdg_config = xdg_get_config_home();
-    GString *base_str = g_string_new(xdg_config);
-    g_string_append(base_str, "/profanity/");
-    gchar *true_loc = get_file_or_linked(prefs_loc, base_str->str);
-    g_file_set_contents(true_loc, g_prefs_data, g_data_size, NULL);
-    g_chmod(prefs_loc, S_IRUSR | S_IWUSR);
-    g_free(xdg_config);
-    free(true_loc);
-    g_free(g_prefs_data);
-    g_string_free(base_str, TRUE);
+    filewriter_changed(prefs_writer);
+}
+
+static gchar *
+_serialise_prefs(gsize *length)
+{
+    return g_key_file_to_data(prefs, length, NULL);
 }
 
 static gchar *
@@ -501,6 +635,7 @@ _get_group(preference_t pref)
         case PREF_INTYPE:
         case PREF_HISTORY:
         case PREF_MOUSE:
+        case PREF_MULTILINE:
         case PREF_OCCUPANTS:
         case PREF_STATUSES:
         case PREF_STATUSES_CONSOLE:
@@ -514,6 +649,7 @@ _get_group(preference_t pref)
         case PREF_ROSTER_OFFLINE:
         case PREF_ROSTER_RESOURCE:
         case PREF_ROSTER_BY:
+        case PREF_COMPLETE:
             return PREF_GROUP_UI;
         case PREF_STATES:
         case PREF_OUTTYPE:
@@ -573,6 +709,8 @@ _get_key(preference_t pref)
             return "history";
         case PREF_MOUSE:
             return "mouse";
+        case PREF_MULTILINE:
+            return "multiline";
         case PREF_OCCUPANTS:
             return "occupants";
         case PREF_MUC_PRIVILEGES:
@@ -647,6 +785,8 @@ _get_key(preference_t pref)
             return "roster.resource";
         case PREF_ROSTER_BY:
             return "roster.by";
+        case PREF_COMPLETE:
+            return "complete";
         default:
             return NULL;
     }
@@ -695,6 +835,8 @@ _get_default_string(preference_t pref)
             return "none";
         case PREF_TIME:
             return "seconds";
+        case PREF_COMPLETE:
+            return "prefix";
         default:
             return NULL;
     }
@@ -46,6 +46,7 @@
 
 #define PREFS_MIN_LOG_SIZE 64
 #define PREFS_MAX_LOG_SIZE 1048580
+#define PREFS_DEFAULT_OCCUPANTS_COMPACT 1000
 
 typedef enum {
     PREF_SPLASH,
@@ -57,6 +58,7 @@ typedef enum {
     PREF_INTYPE,
     PREF_HISTORY,
     PREF_MOUSE,
+    PREF_MULTILINE,
     PREF_OCCUPANTS,
     PREF_OCCUPANTS_SIZE,
     PREF_ROSTER,
@@ -64,6 +66,7 @@ typedef enum {
     PREF_ROSTER_OFFLINE,
     PREF_ROSTER_RESOURCE,
     PREF_ROSTER_BY,
+    PREF_COMPLETE,
     PREF_MUC_PRIVILEGES,
     PREF_PRESENCE,
     PREF_WRAP,
@@ -109,7 +112,6 @@ void prefs_close(void);
 char * prefs_find_login(char *prefix);
 void prefs_reset_login_search(void);
 char * prefs_autocomplete_boolean_choice(char *prefix);
-void prefs_reset_boolean_choice(void);
 
 gint prefs_get_gone(void);
 void prefs_set_gone(gint value);
@@ -129,6 +131,8 @@ void prefs_set_inpblock(gint value);
 
 void prefs_set_occupants_size(gint value);
 gint prefs_get_occupants_size(void);
+void prefs_set_occupants_compact(gint value);
+gint prefs_get_occupants_compact(void);
 void prefs_set_roster_size(gint value);
 gint prefs_get_roster_size(void);
 
@@ -143,6 +147,10 @@ char* prefs_get_alias(const char * const name);
 GList* prefs_get_aliases(void);
 void prefs_free_aliases(GList *aliases);
 
+gboolean prefs_add_highlight(const char * const value, gboolean regex);
+gboolean prefs_remove_highlight(const char * const value);
+GList* prefs_get_highlights(gboolean regex);
+
 gboolean prefs_get_boolean(preference_t pref);
 void prefs_set_boolean(preference_t pref, gboolean value);
 char * prefs_get_string(preference_t pref);
@@ -36,6 +36,10 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
 
 #include <glib.h>
 #ifdef HAVE_NCURSESW_NCURSES_H
@@ -49,9 +53,85 @@
 #include "theme.h"
 #include "preferences.h"
 
+#define THEME_ITEMS (THEME_MAGENTA_BOLD + 1)
+
 static GString *theme_loc;
 static GKeyFile *theme;
-static GHashTable *bold_items;
+
+// attributes for each theme item, compiled when the theme is loaded
+static attr_t theme_attr_table[THEME_ITEMS];
+
+// colour pair initialised by theme_init_colours for each theme item
+static const short theme_pairs[THEME_ITEMS] = {
+    [THEME_TEXT]                  = 1,
+    [THEME_TEXT_ME]               = 2,
+    [THEME_TEXT_THEM]             = 3,
+    [THEME_SPLASH]                = 4,
+    [THEME_ERROR]                 = 5,
+    [THEME_INCOMING]              = 6,
+    [THEME_INPUT_TEXT]            = 7,
+    [THEME_TIME]                  = 8,
+    [THEME_TITLE_TEXT]            = 9,
+    [THEME_TITLE_BRACKET]         = 10,
+    [THEME_TITLE_UNENCRYPTED]     = 11,
+    [THEME_TITLE_ENCRYPTED]       = 12,
+    [THEME_TITLE_UNTRUSTED]       = 13,
+    [THEME_TITLE_TRUSTED]         = 14,
+    [THEME_TITLE_ONLINE]          = 15,
+    [THEME_TITLE_OFFLINE]         = 16,
+    [THEME_TITLE_AWAY]            = 17,
+    [THEME_TITLE_CHAT]            = 18,
+    [THEME_TITLE_DND]             = 19,
+    [THEME_TITLE_XA]              = 20,
+    [THEME_STATUS_TEXT]           = 21,
+    [THEME_STATUS_BRACKET]        = 22,
+    [THEME_STATUS_ACTIVE]         = 23,
+    [THEME_STATUS_NEW]            = 24,
+    [THEME_ME]                    = 25,
+    [THEME_THEM]                  = 26,
+    [THEME_ROOMINFO]              = 27,
+    [THEME_ROOMMENTION]           = 28,
+    [THEME_ONLINE]                = 29,
+    [THEME_OFFLINE]               = 30,
+    [THEME_AWAY]                  = 31,
+    [THEME_CHAT]                  = 32,
+    [THEME_DND]                   = 33,
+    [THEME_XA]                    = 34,
+    [THEME_TYPING]                = 35,
+    [THEME_GONE]                  = 36,
+    [THEME_SUBSCRIBED]            = 37,
+    [THEME_UNSUBSCRIBED]          = 38,
+    [THEME_OTR_STARTED_TRUSTED]   = 39,
+    [THEME_OTR_STARTED_UNTRUSTED] = 40,
+    [THEME_OTR_ENDED]             = 41,
+    [THEME_OTR_TRUSTED]           = 42,
+    [THEME_OTR_UNTRUSTED]         = 43,
+    [THEME_ROSTER_HEADER]         = 44,
+    [THEME_OCCUPANTS_HEADER]      = 45,
+    [THEME_WHITE]                 = 46,
+    [THEME_WHITE_BOLD]            = 46,
+    [THEME_GREEN]                 = 47,
+    [THEME_GREEN_BOLD]            = 47,
+    [THEME_RED]                   = 48,
+    [THEME_RED_BOLD]              = 48,
+    [THEME_YELLOW]                = 49,
+    [THEME_YELLOW_BOLD]           = 49,
+    [THEME_BLUE]                  = 50,
+    [THEME_BLUE_BOLD]             = 50,
+    [THEME_CYAN]                  = 51,
+    [THEME_CYAN_BOLD]             = 51,
+    [THEME_BLACK]                 = 52,
+    [THEME_BLACK_BOLD]            = 52,
+    [THEME_MAGENTA]               = 53,
+    [THEME_MAGENTA_BOLD]          = 53,
+};
+
+#ifdef HAVE_SYS_INOTIFY_H
+// the directory of the loaded theme file is watched, editors often replace the file
+static int inotify_fd = -1;
+static int theme_watch = -1;
+static gchar *theme_watch_name = NULL;
+#endif
 
 struct colour_string_t {
     char *str;
@@ -131,6 +211,7 @@ static gchar * _get_themes_dir(void);
 void _theme_list_dir(const gchar * const dir, GSList **result);
 static GString * _theme_find(const char * const theme_name);
 static gboolean _theme_load_file(const char * const theme_name);
+static void _theme_watch(void);
 
 void
 theme_init(const char * const theme_name)
@@ -163,6 +244,10 @@ _theme_load_file(const char * const theme_name)
             g_key_file_free(theme);
         }
         theme = g_key_file_new();
+        if (theme_loc != NULL) {
+            g_string_free(theme_loc, TRUE);
+            theme_loc = NULL;
+        }
 
     // load theme from file
     } else {
@@ -185,6 +270,8 @@ _theme_load_file(const char * const theme_name)
             NULL);
     }
 
+    _theme_watch();
+
     return TRUE;
 }
 
@@ -207,10 +294,63 @@ theme_close(void)
     }
     if (theme_loc != NULL) {
         g_string_free(theme_loc, TRUE);
+        theme_loc = NULL;
+    }
+#ifdef HAVE_SYS_INOTIFY_H
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+        inotify_fd = -1;
+        theme_watch = -1;
+    }
+    g_free(theme_watch_name);
+    theme_watch_name = NULL;
+#endif
+}
+
+/*
+ * Reload the theme if its file has been written since the last call,
+ * returns TRUE when the colours need to be applied again
+ */
+gboolean
+theme_reload_changed(void)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    if (theme_watch == -1) {
+        return FALSE;
+    }
+
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    gboolean changed = FALSE;
+    ssize_t len;
+
+    // one save can produce several events, they all result in one reload
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        char *ptr = buf;
+        while (ptr < buf + len) {
+            struct inotify_event *event = (struct inotify_event *) ptr;
+            if (event->wd == theme_watch && event->len > 0 && g_strcmp0(event->name, theme_watch_name) == 0) {
+                changed = TRUE;
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    if (!changed) {
+        return FALSE;
     }
-    if (bold_items) {
-        g_hash_table_destroy(bold_items);
+
+    gchar *theme_name = g_strdup(theme_watch_name);
+    log_info("Theme file changed, reloading \"%s\"", theme_name);
+    gboolean result = _theme_load_file(theme_name);
+    if (result) {
+        _load_colours();
     }
+    g_free(theme_name);
+
+    return result;
+#else
+    return FALSE;
+#endif
 }
 
 void
@@ -317,7 +457,7 @@ _set_colour(char *setting, NCURSES_COLOR_T *pref, NCURSES_COLOR_T def, theme_ite
         if (g_str_has_prefix(val, "bold_")) {
             true_val = &val[5];
             if (theme_item != THEME_NONE) {
-                g_hash_table_insert(bold_items, GINT_TO_POINTER(theme_item), GINT_TO_POINTER(theme_item));
+                theme_attr_table[theme_item] |= A_BOLD;
             }
         }
         NCURSES_COLOR_T col = _lookup_colour(true_val);
@@ -334,18 +474,18 @@ _set_colour(char *setting, NCURSES_COLOR_T *pref, NCURSES_COLOR_T def, theme_ite
 static void
 _load_colours(void)
 {
-    if (bold_items) {
-        g_hash_table_destroy(bold_items);
+    int i;
+    for (i = 0; i < THEME_ITEMS; i++) {
+        theme_attr_table[i] = COLOR_PAIR(theme_pairs[i]);
     }
-    bold_items = g_hash_table_new(g_direct_hash, g_direct_equal);
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_WHITE_BOLD),      GINT_TO_POINTER(THEME_WHITE_BOLD));
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_GREEN_BOLD),      GINT_TO_POINTER(THEME_GREEN_BOLD));
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_RED_BOLD),        GINT_TO_POINTER(THEME_RED_BOLD));
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_YELLOW_BOLD),     GINT_TO_POINTER(THEME_YELLOW_BOLD));
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_BLUE_BOLD),       GINT_TO_POINTER(THEME_BLUE_BOLD));
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_CYAN_BOLD),       GINT_TO_POINTER(THEME_CYAN_BOLD));
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_BLACK_BOLD),      GINT_TO_POINTER(THEME_BLACK_BOLD));
-    g_hash_table_insert(bold_items, GINT_TO_POINTER(THEME_MAGENTA_BOLD),    GINT_TO_POINTER(THEME_MAGENTA_BOLD));
+    theme_attr_table[THEME_WHITE_BOLD] |= A_BOLD;
+    theme_attr_table[THEME_GREEN_BOLD] |= A_BOLD;
+    theme_attr_table[THEME_RED_BOLD] |= A_BOLD;
+    theme_attr_table[THEME_YELLOW_BOLD] |= A_BOLD;
+    theme_attr_table[THEME_BLUE_BOLD] |= A_BOLD;
+    theme_attr_table[THEME_CYAN_BOLD] |= A_BOLD;
+    theme_attr_table[THEME_BLACK_BOLD] |= A_BOLD;
+    theme_attr_table[THEME_MAGENTA_BOLD] |= A_BOLD;
 
     _set_colour("bkgnd",                    &colour_prefs.bkgnd,                -1,             THEME_NONE);
     _set_colour("titlebar",                 &colour_prefs.titlebar,             COLOR_BLUE,     THEME_NONE);
@@ -528,77 +668,48 @@ theme_main_presence_attrs(const char * const presence)
 int
 theme_attrs(theme_item_t attrs)
 {
-    int result = 0;
-
-    switch (attrs) {
-    case THEME_TEXT:                    result = COLOR_PAIR(1); break;
-    case THEME_TEXT_ME:                 result = COLOR_PAIR(2); break;
-    case THEME_TEXT_THEM:               result = COLOR_PAIR(3); break;
-    case THEME_SPLASH:                  result = COLOR_PAIR(4); break;
-    case THEME_ERROR:                   result = COLOR_PAIR(5); break;
-    case THEME_INCOMING:                result = COLOR_PAIR(6); break;
-    case THEME_INPUT_TEXT:              result = COLOR_PAIR(7); break;
-    case THEME_TIME:                    result = COLOR_PAIR(8); break;
-    case THEME_TITLE_TEXT:              result = COLOR_PAIR(9); break;
-    case THEME_TITLE_BRACKET:           result = COLOR_PAIR(10); break;
-    case THEME_TITLE_UNENCRYPTED:       result = COLOR_PAIR(11); break;
-    case THEME_TITLE_ENCRYPTED:         result = COLOR_PAIR(12); break;
-    case THEME_TITLE_UNTRUSTED:         result = COLOR_PAIR(13); break;
-    case THEME_TITLE_TRUSTED:           result = COLOR_PAIR(14); break;
-    case THEME_TITLE_ONLINE:            result = COLOR_PAIR(15); break;
-    case THEME_TITLE_OFFLINE:           result = COLOR_PAIR(16); break;
-    case THEME_TITLE_AWAY:              result = COLOR_PAIR(17); break;
-    case THEME_TITLE_CHAT:              result = COLOR_PAIR(18); break;
-    case THEME_TITLE_DND:               result = COLOR_PAIR(19); break;
-    case THEME_TITLE_XA:                result = COLOR_PAIR(20); break;
-    case THEME_STATUS_TEXT:             result = COLOR_PAIR(21); break;
-    case THEME_STATUS_BRACKET:          result = COLOR_PAIR(22); break;
-    case THEME_STATUS_ACTIVE:           result = COLOR_PAIR(23); break;
-    case THEME_STATUS_NEW:              result = COLOR_PAIR(24); break;
-    case THEME_ME:                      result = COLOR_PAIR(25); break;
-    case THEME_THEM:                    result = COLOR_PAIR(26); break;
-    case THEME_ROOMINFO:                result = COLOR_PAIR(27); break;
-    case THEME_ROOMMENTION:             result = COLOR_PAIR(28); break;
-    case THEME_ONLINE:                  result = COLOR_PAIR(29); break;
-    case THEME_OFFLINE:                 result = COLOR_PAIR(30); break;
-    case THEME_AWAY:                    result = COLOR_PAIR(31); break;
-    case THEME_CHAT:                    result = COLOR_PAIR(32); break;
-    case THEME_DND:                     result = COLOR_PAIR(33); break;
-    case THEME_XA:                      result = COLOR_PAIR(34); break;
-    case THEME_TYPING:                  result = COLOR_PAIR(35); break;
-    case THEME_GONE:                    result = COLOR_PAIR(36); break;
-    case THEME_SUBSCRIBED:              result = COLOR_PAIR(37); break;
-    case THEME_UNSUBSCRIBED:            result = COLOR_PAIR(38); break;
-    case THEME_OTR_STARTED_TRUSTED:     result = COLOR_PAIR(39); break;
-    case THEME_OTR_STARTED_UNTRUSTED:   result = COLOR_PAIR(40); break;
-    case THEME_OTR_ENDED:               result = COLOR_PAIR(41); break;
-    case THEME_OTR_TRUSTED:             result = COLOR_PAIR(42); break;
-    case THEME_OTR_UNTRUSTED:           result = COLOR_PAIR(43); break;
-    case THEME_ROSTER_HEADER:           result = COLOR_PAIR(44); break;
-    case THEME_OCCUPANTS_HEADER:        result = COLOR_PAIR(45); break;
-    case THEME_WHITE:                   result = COLOR_PAIR(46); break;
-    case THEME_WHITE_BOLD:              result = COLOR_PAIR(46); break;
-    case THEME_GREEN:                   result = COLOR_PAIR(47); break;
-    case THEME_GREEN_BOLD:              result = COLOR_PAIR(47); break;
-    case THEME_RED:                     result = COLOR_PAIR(48); break;
-    case THEME_RED_BOLD:                result = COLOR_PAIR(48); break;
-    case THEME_YELLOW:                  result = COLOR_PAIR(49); break;
-    case THEME_YELLOW_BOLD:             result = COLOR_PAIR(49); break;
-    case THEME_BLUE:                    result = COLOR_PAIR(50); break;
-    case THEME_BLUE_BOLD:               result = COLOR_PAIR(50); break;
-    case THEME_CYAN:                    result = COLOR_PAIR(51); break;
-    case THEME_CYAN_BOLD:               result = COLOR_PAIR(51); break;
-    case THEME_BLACK:                   result = COLOR_PAIR(52); break;
-    case THEME_BLACK_BOLD:              result = COLOR_PAIR(52); break;
-    case THEME_MAGENTA:                 result = COLOR_PAIR(53); break;
-    case THEME_MAGENTA_BOLD:            result = COLOR_PAIR(53); break;
-    default:                           break;
+    if (attrs >= THEME_ITEMS) {
+        return 0;
     }
 
-    if (g_hash_table_lookup(bold_items, GINT_TO_POINTER(attrs))) {
-        return result | A_BOLD;
-    } else {
-        return result;
+    return theme_attr_table[attrs];
+}
 
+#ifdef HAVE_SYS_INOTIFY_H
+static void
+_theme_watch(void)
+{
+    if (inotify_fd != -1 && theme_watch != -1) {
+        inotify_rm_watch(inotify_fd, theme_watch);
+        theme_watch = -1;
     }
-}
\ No newline at end of file
+    g_free(theme_watch_name);
+    theme_watch_name = NULL;
+
+    if (theme_loc == NULL) {
+        return;
+    }
+
+    if (inotify_fd == -1) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd == -1) {
+            log_error("Could not watch theme files for changes");
+            return;
+        }
+    }
+
+    gchar *theme_dir = g_path_get_dirname(theme_loc->str);
+    theme_watch = inotify_add_watch(inotify_fd, theme_dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (theme_watch == -1) {
+        log_error("Could not watch theme directory %s", theme_dir);
+    } else {
+        theme_watch_name = g_path_get_basename(theme_loc->str);
+    }
+    g_free(theme_dir);
+}
+#else
+static void
+_theme_watch(void)
+{
+}
+#endif
@@ -114,6 +114,7 @@ void theme_init_colours(void);
 gboolean theme_load(const char * const theme_name);
 GSList* theme_list(void);
 void theme_close(void);
+gboolean theme_reload_changed(void);
 int theme_attrs(theme_item_t attrs);
 theme_item_t theme_main_presence_attrs(const char * const presence);
 
@@ -40,11 +40,12 @@
 
 #include "contact.h"
 #include "common.h"
+#include "jid.h"
 #include "resource.h"
 #include "tools/autocomplete.h"
 
 struct p_contact_t {
-    char *barejid;
+    const char *barejid; // interned
     char *name;
     GSList *groups;
     char *subscription;
@@ -52,16 +53,20 @@ struct p_contact_t {
     gboolean pending_out;
     GDateTime *last_activity;
     GHashTable *available_resources;
+    Resource *most_available;
     Autocomplete resource_ac;
 };
 
+static Resource * _highest_presence(Resource *first, Resource *second);
+static Resource * _get_most_available_resource(PContact contact);
+
 PContact
 p_contact_new(const char * const barejid, const char * const name,
     GSList *groups, const char * const subscription,
     const char * const offline_message, gboolean pending_out)
 {
     PContact contact = malloc(sizeof(struct p_contact_t));
-    contact->barejid = strdup(barejid);
+    contact->barejid = jid_intern(barejid);
 
     if (name != NULL) {
         contact->name = strdup(name);
@@ -86,6 +91,7 @@ p_contact_new(const char * const barejid, const char * const name,
 
     contact->available_resources = g_hash_table_new_full(g_str_hash, g_str_equal, free,
         (GDestroyNotify)resource_destroy);
+    contact->most_available = NULL;
 
     contact->resource_ac = autocomplete_new();
 
@@ -138,6 +144,10 @@ p_contact_remove_resource(PContact contact, const char * const resource)
     gboolean result = g_hash_table_remove(contact->available_resources, resource);
     autocomplete_remove(contact->resource_ac, resource);
 
+    if (result) {
+        contact->most_available = _get_most_available_resource(contact);
+    }
+
     return result;
 }
 
@@ -145,7 +155,7 @@ void
 p_contact_free(PContact contact)
 {
     if (contact != NULL) {
-        free(contact->barejid);
+        jid_intern_release(contact->barejid);
         free(contact->name);
         free(contact->subscription);
         free(contact->offline_message);
@@ -232,9 +242,13 @@ _highest_presence(Resource *first, Resource *second)
     }
 }
 
-Resource *
+static Resource *
 _get_most_available_resource(PContact contact)
 {
+    if (g_hash_table_size(contact->available_resources) == 0) {
+        return NULL;
+    }
+
     // find resource with highest priority, if more than one,
     // use highest availability, in the following order:
     //      chat
@@ -272,13 +286,11 @@ p_contact_presence(const PContact contact)
     assert(contact != NULL);
 
     // no available resources, offline
-    if (g_hash_table_size(contact->available_resources) == 0) {
+    if (contact->most_available == NULL) {
         return "offline";
     }
 
-    Resource *resource = _get_most_available_resource(contact);
-
-    return string_from_resource_presence(resource->presence);
+    return string_from_resource_presence(contact->most_available->presence);
 }
 
 const char *
@@ -287,13 +299,11 @@ p_contact_status(const PContact contact)
     assert(contact != NULL);
 
     // no available resources, use offline message
-    if (g_hash_table_size(contact->available_resources) == 0) {
+    if (contact->most_available == NULL) {
         return contact->offline_message;
     }
 
-    Resource *resource = _get_most_available_resource(contact);
-
-    return resource->status;
+    return contact->most_available->status;
 }
 
 const char *
@@ -357,12 +367,12 @@ gboolean
 p_contact_is_available(const PContact contact)
 {
     // no available resources, unavailable
-    if (g_hash_table_size(contact->available_resources) == 0) {
+    Resource *most_available = contact->most_available;
+    if (most_available == NULL) {
         return FALSE;
     }
 
     // if most available resource is CHAT or ONLINE, available
-    Resource *most_available = _get_most_available_resource(contact);
     if ((most_available->presence == RESOURCE_ONLINE) ||
         (most_available->presence == RESOURCE_CHAT)) {
         return TRUE;
@@ -380,8 +390,23 @@ p_contact_has_available_resource(const PContact contact)
 void
 p_contact_set_presence(const PContact contact, Resource *resource)
 {
+    Resource *most_available = contact->most_available;
+    gboolean replaces_most_available = (most_available != NULL) &&
+        (g_strcmp0(most_available->name, resource->name) == 0);
+
     g_hash_table_replace(contact->available_resources, strdup(resource->name), resource);
     autocomplete_add(contact->resource_ac, strdup(resource->name));
+
+    // the cached resource has been freed by the replace, find it again
+    if (replaces_most_available) {
+        contact->most_available = _get_most_available_resource(contact);
+
+    // otherwise only the new resource can take over
+    } else if (most_available == NULL || resource->priority > most_available->priority) {
+        contact->most_available = resource;
+    } else if (resource->priority == most_available->priority) {
+        contact->most_available = _highest_presence(most_available, resource);
+    }
 }
 
 void
@@ -416,10 +441,4 @@ Autocomplete
 p_contact_resource_ac(const PContact contact)
 {
     return contact->resource_ac;
-}
-
-void
-p_contact_resource_ac_reset(const PContact contact)
-{
-    autocomplete_reset(contact->resource_ac);
 }
\ No newline at end of file
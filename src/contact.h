@@ -70,6 +70,5 @@ gboolean p_contact_in_group(const PContact contact, const char * const group);
 gboolean p_contact_subscribed(const PContact contact);
 char * p_contact_create_display_string(const PContact contact, const char * const resource);
 Autocomplete p_contact_resource_ac(const PContact contact);
-void p_contact_resource_ac_reset(const PContact contact);
 
 #endif
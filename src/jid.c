@@ -189,4 +189,199 @@ jid_fulljid_or_barejid(Jid *jid)
     } else {
         return jid->barejid;
     }
-}
\ No newline at end of file
+}
+
+/*
+ * Parse str into view without allocating, each part of the view is a slice
+ * into str. Returns FALSE for the same input that jid_create rejects.
+ */
+gboolean
+jid_view_parse(const char * const str, JidView *view)
+{
+    if (str == NULL || str[0] == '\0') {
+        return FALSE;
+    }
+
+    if (str[0] == '/' || str[0] == '@') {
+        return FALSE;
+    }
+
+    if (!g_utf8_validate(str, -1, NULL)) {
+        return FALSE;
+    }
+
+    const char *slashp = strchr(str, '/');
+    const char *atp = memchr(str, '@', slashp ? (size_t)(slashp - str) : strlen(str));
+    const char *domain_start = str;
+
+    view->str = str;
+    view->localpart.ptr = NULL;
+    view->localpart.len = 0;
+    view->resourcepart.ptr = NULL;
+    view->resourcepart.len = 0;
+
+    if (atp != NULL) {
+        view->localpart.ptr = str;
+        view->localpart.len = atp - str;
+        domain_start = atp + 1;
+    }
+
+    view->domainpart.ptr = domain_start;
+    view->barejid.ptr = str;
+    if (slashp != NULL) {
+        view->domainpart.len = slashp - domain_start;
+        view->barejid.len = slashp - str;
+        view->resourcepart.ptr = slashp + 1;
+        view->resourcepart.len = strlen(slashp + 1);
+    } else {
+        view->domainpart.len = strlen(domain_start);
+        view->barejid.len = view->domainpart.len + (domain_start - str);
+    }
+
+    return TRUE;
+}
+
+gboolean
+jid_slice_equals(JidSlice slice, const char * const str)
+{
+    if (slice.ptr == NULL || str == NULL) {
+        return (slice.ptr == NULL && str == NULL);
+    }
+
+    return (strncmp(slice.ptr, str, slice.len) == 0 && str[slice.len] == '\0');
+}
+
+/*
+ * Interned jids are reference counted, each entry is its own key and is
+ * freed when the last holder releases it. Compact rooms keep their occupant
+ * nicks and statuses here too.
+ */
+typedef struct jid_interned_t {
+    JidSlice slice;
+    guint refs;
+} JidInterned;
+
+static GHashTable *interned = NULL;
+
+static guint
+_slice_hash(gconstpointer key)
+{
+    const JidSlice *slice = key;
+    guint hash = 5381;
+    size_t i;
+    for (i = 0; i < slice->len; i++) {
+        hash = (hash << 5) + hash + (unsigned char)slice->ptr[i];
+    }
+
+    return hash;
+}
+
+static gboolean
+_slice_equal(gconstpointer a, gconstpointer b)
+{
+    const JidSlice *slice_a = a;
+    const JidSlice *slice_b = b;
+
+    return (slice_a->len == slice_b->len &&
+        memcmp(slice_a->ptr, slice_b->ptr, slice_a->len) == 0);
+}
+
+static void
+_interned_free(gpointer data)
+{
+    JidInterned *entry = data;
+    g_free((gchar *)entry->slice.ptr);
+    g_free(entry);
+}
+
+/*
+ * Return the canonical copy of slice from the intern pool, adding it if not
+ * already present. Each call takes a reference which must be given back with
+ * jid_intern_release, lookups of held jids do not allocate.
+ */
+const char *
+jid_intern_slice(JidSlice slice)
+{
+    if (slice.ptr == NULL) {
+        return NULL;
+    }
+
+    if (interned == NULL) {
+        interned = g_hash_table_new_full(_slice_hash, _slice_equal, NULL, _interned_free);
+    }
+
+    JidInterned *entry = g_hash_table_lookup(interned, &slice);
+    if (entry == NULL) {
+        entry = g_new(JidInterned, 1);
+        entry->slice.ptr = g_strndup(slice.ptr, slice.len);
+        entry->slice.len = slice.len;
+        entry->refs = 0;
+        g_hash_table_insert(interned, entry, entry);
+    }
+    entry->refs++;
+
+    return entry->slice.ptr;
+}
+
+const char *
+jid_intern(const char * const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    JidSlice slice = { str, strlen(str) };
+    return jid_intern_slice(slice);
+}
+
+/*
+ * Return the interned barejid of str, or NULL if str is not a valid JID
+ */
+const char *
+jid_intern_barejid(const char * const str)
+{
+    JidView view;
+    if (!jid_view_parse(str, &view)) {
+        return NULL;
+    }
+
+    return jid_intern_slice(view.barejid);
+}
+
+void
+jid_intern_release(const char * const str)
+{
+    if (str == NULL || interned == NULL) {
+        return;
+    }
+
+    JidSlice slice = { str, strlen(str) };
+    JidInterned *entry = g_hash_table_lookup(interned, &slice);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->refs--;
+    if (entry->refs == 0) {
+        g_hash_table_remove(interned, entry);
+    }
+}
+
+guint
+jid_intern_size(void)
+{
+    if (interned == NULL) {
+        return 0;
+    }
+
+    return g_hash_table_size(interned);
+}
+
+void
+jid_intern_clear(void)
+{
+    if (interned != NULL) {
+        g_hash_table_destroy(interned);
+        interned = NULL;
+    }
+}
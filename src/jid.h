@@ -48,6 +48,27 @@ struct jid_t {
 
 typedef struct jid_t Jid;
 
+/*
+ * A slice of a JID string, not NUL terminated unless it runs to the end
+ * of the original string (as the resourcepart always does)
+ */
+typedef struct jid_slice_t {
+    const char *ptr;
+    size_t len;
+} JidSlice;
+
+/*
+ * Allocation free view of a JID, all parts point into the parsed string
+ * which must outlive the view
+ */
+typedef struct jid_view_t {
+    const char *str;
+    JidSlice localpart;
+    JidSlice domainpart;
+    JidSlice resourcepart;
+    JidSlice barejid;
+} JidView;
+
 Jid * jid_create(const gchar * const str);
 Jid * jid_create_from_bare_and_resource(const char * const room, const char * const nick);
 void jid_destroy(Jid *jid);
@@ -58,4 +79,14 @@ char * get_nick_from_full_jid(const char * const full_room_jid);
 
 char * jid_fulljid_or_barejid(Jid *jid);
 
+gboolean jid_view_parse(const char * const str, JidView *view);
+gboolean jid_slice_equals(JidSlice slice, const char * const str);
+
+const char * jid_intern(const char * const str);
+const char * jid_intern_slice(JidSlice slice);
+const char * jid_intern_barejid(const char * const str);
+void jid_intern_release(const char * const str);
+guint jid_intern_size(void);
+void jid_intern_clear(void);
+
 #endif
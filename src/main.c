@@ -52,6 +52,7 @@ static gboolean disable_tls = FALSE;
 static gboolean version = FALSE;
 static char *log = "INFO";
 static char *account_name = NULL;
+static gboolean startup_profile = FALSE;
 
 int
 main(int argc, char **argv)
@@ -62,6 +63,7 @@ main(int argc, char **argv)
         { "disable-tls", 'd', 0, G_OPTION_ARG_NONE, &disable_tls, "Disable TLS", NULL },
         { "account", 'a', 0, G_OPTION_ARG_STRING, &account_name, "Auto connect to an account on startup" },
         { "log",'l', 0, G_OPTION_ARG_STRING, &log, "Set logging levels, DEBUG, INFO (default), WARN, ERROR", "LEVEL" },
+        { "startup-profile", 0, 0, G_OPTION_ARG_NONE, &startup_profile, "Show how long each startup phase took", NULL },
         { NULL }
     };
 
@@ -125,7 +127,7 @@ main(int argc, char **argv)
         return 0;
     }
 
-    prof_run(disable_tls, log, account_name);
+    prof_run(disable_tls, log, account_name, startup_profile);
 
     return 0;
 }
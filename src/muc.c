@@ -41,47 +41,98 @@
 #include "common.h"
 #include "jid.h"
 #include "tools/autocomplete.h"
+#include "tools/filewriter.h"
 #include "ui/ui.h"
 #include "ui/windows.h"
 #include "muc.h"
 
+#define LAST_SEEN_SAVE_DELAY_MS 5000
+
+// hashed stanza id and sender of a received message
+typedef struct _muc_seen_t {
+    guint id_hash;
+    guint nick_hash;
+} SeenMessage;
+
 typedef struct _muc_room_t {
-    char *room; // e.g. test@conference.server
+    const char *room; // interned, e.g. test@conference.server
     char *nick; // e.g. Some User
     muc_role_t role;
     muc_affiliation_t affiliation;
     char *password;
     char *subject;
     char *autocomplete_prefix;
+    guint autocomplete_generation;
     gboolean pending_config;
     GList *pending_broadcasts;
     gboolean autojoin;
     gboolean pending_nick_change;
     GHashTable *roster;
+    GSequence *occupants;
+    GSequence *occupants_by_role[MUC_ROLE_MODERATOR + 1];
+    GSequence *occupants_by_affiliation[MUC_AFFILIATION_OWNER + 1];
+    gboolean compact;
     Autocomplete nick_ac;
     Autocomplete jid_ac;
     GHashTable *nick_changes;
     gboolean roster_received;
+    GQueue *pending_history;
+    // ring of the last MUC_SEEN_IDS_MAX messages received
+    SeenMessage *seen;
+    guint seen_count;
+    guint seen_next;
 } ChatRoom;
 
+// roster value, allocated in one block with the occupant's nick, keeps the
+// occupant's position in each of the room's sorted indices, compact rooms keep
+// only the index of all occupants and no collate key
+typedef struct _muc_occupant_entry_t {
+    Occupant occupant;
+    gchar *collate_key;
+    GSequenceIter *all_iter;
+    GSequenceIter *role_iter;
+    GSequenceIter *affiliation_iter;
+} OccupantEntry;
+
 GHashTable *rooms = NULL;
 Autocomplete invite_ac;
 
+// last message time per room, kept across leaves and persisted between sessions
+static GHashTable *last_seen = NULL;
+// account whose last seen times are loaded, NULL before the first login
+static char *last_seen_account = NULL;
+static FileWriter last_seen_writer = NULL;
+
+// roster size at which a room switches to compact occupants, 0 never,
+// set from the preferences on startup
+static int compact_threshold = 0;
+
 static void _free_room(ChatRoom *room);
-static gint _compare_occupants(Occupant *a, Occupant *b);
+static gint _compare_entries(OccupantEntry *a, OccupantEntry *b, gpointer data);
+static gint _compare_entries_compact(OccupantEntry *a, OccupantEntry *b, gpointer data);
+static OccupantEntry* _entry_new(const char * const nick, const char * const jid, muc_role_t role,
+    muc_affiliation_t affiliation, resource_presence_t presence, const char * const status);
+static void _entry_free(OccupantEntry *entry);
+static void _roster_remove(ChatRoom *chat_room, const char * const nick);
+static GList* _index_to_list(GSequence *index);
+static GSList* _index_to_slist(GSequence *index);
+static GSList* _index_to_slist_where(GSequence *index, int role, int affiliation);
 static muc_role_t _role_from_string(const char * const role);
 static muc_affiliation_t _affiliation_from_string(const char * const affiliation);
 static char* _role_to_string(muc_role_t role);
 static char* _affiliation_to_string(muc_affiliation_t affiliation);
-static Occupant* _muc_occupant_new(const char *const nick, const char * const jid,
-    muc_role_t role, muc_affiliation_t affiliation, resource_presence_t presence, const char * const status);
-static void _occupant_free(Occupant *occupant);
+static void _room_compact(ChatRoom *chat_room);
+static void _history_free(MucHistory *history);
+static gchar* _get_history_file(const char * const account_name);
+static gchar* _serialise_last_seen(gsize *length);
 
 void
 muc_init(void)
 {
     invite_ac = autocomplete_new();
-    rooms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_free_room);
+    // keyed on the rooms' own interned jids
+    rooms = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_free_room);
+    last_seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 }
 
 void
@@ -90,6 +141,33 @@ muc_close(void)
     autocomplete_free(invite_ac);
     g_hash_table_destroy(rooms);
     rooms = NULL;
+    filewriter_free(last_seen_writer);
+    last_seen_writer = NULL;
+    g_hash_table_destroy(last_seen);
+    last_seen = NULL;
+    free(last_seen_account);
+    last_seen_account = NULL;
+}
+
+/*
+ * Set the roster size at which rooms switch to compact occupant storage,
+ * 0 disables it, rooms that are already compact stay so
+ */
+void
+muc_set_compact_threshold(int threshold)
+{
+    compact_threshold = threshold;
+}
+
+gboolean
+muc_compact(const char * const room)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room) {
+        return chat_room->compact;
+    } else {
+        return FALSE;
+    }
 }
 
 void
@@ -134,12 +212,6 @@ muc_invites_contain(const char * const room)
     return FALSE;
 }
 
-void
-muc_invites_reset_ac(void)
-{
-    autocomplete_reset(invite_ac);
-}
-
 char *
 muc_invites_find(char *search_str)
 {
@@ -157,11 +229,12 @@ muc_join(const char * const room, const char * const nick,
     const char * const password, gboolean autojoin)
 {
     ChatRoom *new_room = malloc(sizeof(ChatRoom));
-    new_room->room = strdup(room);
+    new_room->room = jid_intern(room);
     new_room->nick = strdup(nick);
     new_room->role = MUC_ROLE_NONE;
     new_room->affiliation = MUC_AFFILIATION_NONE;
     new_room->autocomplete_prefix = NULL;
+    new_room->autocomplete_generation = 0;
     if (password) {
         new_room->password = strdup(password);
     } else {
@@ -170,15 +243,30 @@ muc_join(const char * const room, const char * const nick,
     new_room->subject = NULL;
     new_room->pending_broadcasts = NULL;
     new_room->pending_config = FALSE;
-    new_room->roster = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_occupant_free);
-    new_room->nick_ac = autocomplete_new();
-    new_room->jid_ac = autocomplete_new();
+    // keys are the occupants' own nicks
+    new_room->roster = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)_entry_free);
+    new_room->compact = FALSE;
+    new_room->occupants = g_sequence_new(NULL);
+    int i;
+    for (i = 0; i <= MUC_ROLE_MODERATOR; i++) {
+        new_room->occupants_by_role[i] = g_sequence_new(NULL);
+    }
+    for (i = 0; i <= MUC_AFFILIATION_OWNER; i++) {
+        new_room->occupants_by_affiliation[i] = g_sequence_new(NULL);
+    }
+    // both borrow their items, the nicks from the roster and the jids from the intern pool
+    new_room->nick_ac = autocomplete_new_borrowed(NULL);
+    new_room->jid_ac = autocomplete_new_borrowed((GDestroyNotify)jid_intern_release);
     new_room->nick_changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
     new_room->roster_received = FALSE;
     new_room->pending_nick_change = FALSE;
     new_room->autojoin = autojoin;
+    new_room->pending_history = g_queue_new();
+    new_room->seen = g_new(SeenMessage, MUC_SEEN_IDS_MAX);
+    new_room->seen_count = 0;
+    new_room->seen_next = 0;
 
-    g_hash_table_insert(rooms, strdup(room), new_room);
+    g_hash_table_insert(rooms, (gpointer)new_room->room, new_room);
 }
 
 void
@@ -323,8 +411,7 @@ muc_nick_change_complete(const char * const room, const char * const nick)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        g_hash_table_remove(chat_room->roster, chat_room->nick);
-        autocomplete_remove(chat_room->nick_ac, chat_room->nick);
+        _roster_remove(chat_room, chat_room->nick);
         free(chat_room->nick);
         chat_room->nick = strdup(nick);
         chat_room->pending_nick_change = FALSE;
@@ -381,8 +468,8 @@ muc_roster_contains_nick(const char * const room, const char * const nick)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        Occupant *occupant = g_hash_table_lookup(chat_room->roster, nick);
-        return (occupant != NULL);
+        OccupantEntry *entry = g_hash_table_lookup(chat_room->roster, nick);
+        return (entry != NULL);
     } else {
         return FALSE;
     }
@@ -400,28 +487,71 @@ muc_roster_add(const char * const room, const char * const nick, const char * co
     resource_presence_t new_presence = resource_presence_from_string(show);
 
     if (chat_room) {
-        Occupant *old = g_hash_table_lookup(chat_room->roster, nick);
+        OccupantEntry *entry = g_hash_table_lookup(chat_room->roster, nick);
 
-        if (!old) {
+        if (!entry) {
             updated = TRUE;
-            autocomplete_add(chat_room->nick_ac, nick);
-        } else if (old->presence != new_presence ||
-                    (g_strcmp0(old->status, status) != 0)) {
+        } else if (entry->occupant.presence != new_presence ||
+                    (g_strcmp0(entry->occupant.status, status) != 0)) {
             updated = TRUE;
         }
 
         resource_presence_t presence = resource_presence_from_string(show);
         muc_role_t role_t = _role_from_string(role);
         muc_affiliation_t affiliation_t = _affiliation_from_string(affiliation);
-        Occupant *occupant = _muc_occupant_new(nick, jid, role_t, affiliation_t, presence, status);
-        g_hash_table_replace(chat_room->roster, strdup(nick), occupant);
 
-        if (jid) {
-            Jid *jidp = jid_create(jid);
-            if (jidp->barejid) {
-                autocomplete_add(chat_room->jid_ac, jidp->barejid);
+        if (!entry) {
+            entry = _entry_new(nick, jid, role_t, affiliation_t, presence, status);
+            if (chat_room->compact) {
+                entry->all_iter = g_sequence_insert_sorted(chat_room->occupants, entry,
+                    (GCompareDataFunc)_compare_entries_compact, NULL);
+            } else {
+                entry->collate_key = g_utf8_collate_key(nick, -1);
+                entry->all_iter = g_sequence_insert_sorted(chat_room->occupants, entry,
+                    (GCompareDataFunc)_compare_entries, NULL);
+                entry->role_iter = g_sequence_insert_sorted(chat_room->occupants_by_role[role_t], entry,
+                    (GCompareDataFunc)_compare_entries, NULL);
+                entry->affiliation_iter = g_sequence_insert_sorted(chat_room->occupants_by_affiliation[affiliation_t],
+                    entry, (GCompareDataFunc)_compare_entries, NULL);
+            }
+            g_hash_table_insert(chat_room->roster, entry->occupant.nick, entry);
+            autocomplete_add(chat_room->nick_ac, entry->occupant.nick);
+
+            if (!chat_room->compact && compact_threshold > 0 &&
+                    g_hash_table_size(chat_room->roster) >= (guint)compact_threshold) {
+                _room_compact(chat_room);
             }
-            jid_destroy(jidp);
+
+        // indices are ordered by nick only, so an update just moves between role and affiliation
+        } else {
+            Occupant *occupant = &entry->occupant;
+            if (!chat_room->compact && occupant->role != role_t) {
+                g_sequence_remove(entry->role_iter);
+                entry->role_iter = g_sequence_insert_sorted(chat_room->occupants_by_role[role_t], entry,
+                    (GCompareDataFunc)_compare_entries, NULL);
+            }
+            if (!chat_room->compact && occupant->affiliation != affiliation_t) {
+                g_sequence_remove(entry->affiliation_iter);
+                entry->affiliation_iter = g_sequence_insert_sorted(chat_room->occupants_by_affiliation[affiliation_t],
+                    entry, (GCompareDataFunc)_compare_entries, NULL);
+            }
+            occupant->role = role_t;
+            occupant->affiliation = affiliation_t;
+            occupant->presence = presence;
+            if (g_strcmp0(occupant->jid, jid) != 0) {
+                free(occupant->jid);
+                occupant->jid = jid ? strdup(jid) : NULL;
+            }
+            if (g_strcmp0(occupant->status, status) != 0) {
+                free(occupant->status);
+                occupant->status = status ? strdup(status) : NULL;
+            }
+        }
+
+        // a jid already listed releases the reference just taken
+        JidView jidv;
+        if (jid_view_parse(jid, &jidv)) {
+            autocomplete_add(chat_room->jid_ac, jid_intern_slice(jidv.barejid));
         }
     }
 
@@ -436,8 +566,7 @@ muc_roster_remove(const char * const room, const char * const nick)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        g_hash_table_remove(chat_room->roster, nick);
-        autocomplete_remove(chat_room->nick_ac, nick);
+        _roster_remove(chat_room, nick);
     }
 }
 
@@ -446,33 +575,27 @@ muc_roster_item(const char * const room, const char * const nick)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        Occupant *occupant = g_hash_table_lookup(chat_room->roster, nick);
-        return occupant;
+        OccupantEntry *entry = g_hash_table_lookup(chat_room->roster, nick);
+        if (entry) {
+            return &entry->occupant;
+        } else {
+            return NULL;
+        }
     } else {
         return NULL;
     }
 }
 
 /*
- * Return a list of PContacts representing the room members in the room's roster
+ * Return a list of Occupants representing the room members in the room's roster,
+ * ordered by nick
  */
 GList *
 muc_roster(const char * const room)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        GList *result = NULL;
-        GList *occupants = g_hash_table_get_values(chat_room->roster);
-
-        GList *curr = occupants;
-        while (curr) {
-            result = g_list_insert_sorted(result, curr->data, (GCompareFunc)_compare_occupants);
-            curr = g_list_next(curr);
-        }
-
-        g_list_free(occupants);
-
-        return result;
+        return _index_to_list(chat_room->occupants);
     } else {
         return NULL;
     }
@@ -547,47 +670,37 @@ muc_occupant_role_str(Occupant *occupant)
     return _role_to_string(occupant->role);
 }
 
+/*
+ * Return the room's occupants with the given role, ordered by nick
+ */
 GSList *
 muc_occupants_by_role(const char * const room, muc_role_t role)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        GSList *result = NULL;
-        GHashTableIter iter;
-        gpointer key;
-        gpointer value;
-
-        g_hash_table_iter_init(&iter, chat_room->roster);
-        while (g_hash_table_iter_next(&iter, &key, &value)) {
-            Occupant *occupant = (Occupant *)value;
-            if (occupant->role == role) {
-                result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_occupants);
-            }
+        if (chat_room->compact) {
+            return _index_to_slist_where(chat_room->occupants, role, -1);
+        } else {
+            return _index_to_slist(chat_room->occupants_by_role[role]);
         }
-        return result;
     } else {
         return NULL;
     }
 }
 
+/*
+ * Return the room's occupants with the given affiliation, ordered by nick
+ */
 GSList *
 muc_occupants_by_affiliation(const char * const room, muc_affiliation_t affiliation)
 {
     ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
     if (chat_room) {
-        GSList *result = NULL;
-        GHashTableIter iter;
-        gpointer key;
-        gpointer value;
-
-        g_hash_table_iter_init(&iter, chat_room->roster);
-        while (g_hash_table_iter_next(&iter, &key, &value)) {
-            Occupant *occupant = (Occupant *)value;
-            if (occupant->affiliation == affiliation) {
-                result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_occupants);
-            }
+        if (chat_room->compact) {
+            return _index_to_slist_where(chat_room->occupants, -1, affiliation);
+        } else {
+            return _index_to_slist(chat_room->occupants_by_affiliation[affiliation]);
         }
-        return result;
     } else {
         return NULL;
     }
@@ -632,6 +745,192 @@ muc_roster_nick_change_complete(const char * const room,
     return NULL;
 }
 
+/*
+ * Queue a delayed message received on joining, the history is rendered in one
+ * batch by the caller once the room subject or first live message arrives
+ */
+void
+muc_pending_history_add(const char * const room, const char * const nick,
+    GTimeVal tv_stamp, const char * const message)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room) {
+        MucHistory *history = malloc(sizeof(MucHistory));
+        history->nick = strdup(nick);
+        history->tv_stamp = tv_stamp;
+        history->message = strdup(message);
+        g_queue_push_tail(chat_room->pending_history, history);
+    }
+}
+
+/*
+ * Return the queued history for the room, oldest first
+ * The list is owned by the room and is freed by muc_pending_history_clear
+ */
+GList *
+muc_pending_history(const char * const room)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room) {
+        return chat_room->pending_history->head;
+    } else {
+        return NULL;
+    }
+}
+
+gint
+muc_pending_history_count(const char * const room)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room) {
+        return g_queue_get_length(chat_room->pending_history);
+    } else {
+        return 0;
+    }
+}
+
+void
+muc_pending_history_clear(const char * const room)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room) {
+        g_queue_foreach(chat_room->pending_history, (GFunc)_history_free, NULL);
+        g_queue_clear(chat_room->pending_history);
+    }
+}
+
+/*
+ * Returns TRUE if a message with the same stanza id and sender has already
+ * been received in the room, otherwise records it. Ids are only unique per
+ * client, so the id alone would drop real messages. Only the most recent
+ * MUC_SEEN_IDS_MAX messages are remembered.
+ */
+gboolean
+muc_message_seen(const char * const room, const char * const id,
+    const char * const nick)
+{
+    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
+    if (chat_room == NULL || id == NULL) {
+        return FALSE;
+    }
+
+    guint id_hash = g_str_hash(id);
+    guint nick_hash = nick ? g_str_hash(nick) : 0;
+
+    guint i;
+    for (i = 0; i < chat_room->seen_count; i++) {
+        SeenMessage *seen = &chat_room->seen[i];
+        if (seen->id_hash == id_hash && seen->nick_hash == nick_hash) {
+            return TRUE;
+        }
+    }
+
+    // overwrite the oldest once full
+    chat_room->seen[chat_room->seen_next].id_hash = id_hash;
+    chat_room->seen[chat_room->seen_next].nick_hash = nick_hash;
+    chat_room->seen_next = (chat_room->seen_next + 1) % MUC_SEEN_IDS_MAX;
+    if (chat_room->seen_count < MUC_SEEN_IDS_MAX) {
+        chat_room->seen_count++;
+    }
+
+    return FALSE;
+}
+
+/*
+ * Record the server stamp of the latest message received from the room,
+ * earlier times are ignored
+ */
+void
+muc_set_last_seen(const char * const room, GTimeVal *tv_stamp)
+{
+    gint64 *curr = g_hash_table_lookup(last_seen, room);
+    gint64 stamp = ((gint64)tv_stamp->tv_sec * G_USEC_PER_SEC) + tv_stamp->tv_usec;
+
+    if (curr == NULL) {
+        curr = g_new(gint64, 1);
+        *curr = stamp;
+        g_hash_table_insert(last_seen, strdup(room), curr);
+        filewriter_changed(last_seen_writer);
+    } else if (stamp > *curr) {
+        *curr = stamp;
+        filewriter_changed(last_seen_writer);
+    }
+}
+
+/*
+ * Record a message received live, which carries no server stamp
+ */
+void
+muc_set_last_seen_now(const char * const room)
+{
+    GTimeVal tv_now;
+    g_get_current_time(&tv_now);
+    tv_now.tv_sec -= MUC_CLOCK_SKEW_SECS;
+    muc_set_last_seen(room, &tv_now);
+}
+
+/*
+ * Get the time of the latest message received from the room in this or a
+ * previous session, returns FALSE if the room has not been seen
+ */
+gboolean
+muc_last_seen(const char * const room, GTimeVal *tv_stamp)
+{
+    gint64 *curr = g_hash_table_lookup(last_seen, room);
+    if (curr == NULL) {
+        return FALSE;
+    }
+
+    tv_stamp->tv_sec = *curr / G_USEC_PER_SEC;
+    tv_stamp->tv_usec = *curr % G_USEC_PER_SEC;
+
+    return TRUE;
+}
+
+/*
+ * Load the last seen times of the account's rooms, saving and forgetting
+ * those of the account loaded before, later changes are written behind
+ */
+void
+muc_history_load(const char * const account_name)
+{
+    if (g_strcmp0(last_seen_account, account_name) == 0) {
+        return;
+    }
+
+    if (last_seen_account) {
+        filewriter_free(last_seen_writer);
+        last_seen_writer = NULL;
+        g_hash_table_remove_all(last_seen);
+        free(last_seen_account);
+    }
+
+    last_seen_account = strdup(account_name);
+    gchar *history_file = _get_history_file(last_seen_account);
+    GKeyFile *history = g_key_file_new();
+    g_key_file_load_from_file(history, history_file, G_KEY_FILE_NONE, NULL);
+    g_free(history_file);
+
+    gsize len = 0;
+    gchar **saved_rooms = g_key_file_get_groups(history, &len);
+    gsize i;
+    for (i = 0; i < len; i++) {
+        gchar *stamp = g_key_file_get_string(history, saved_rooms[i], "last_seen", NULL);
+        GTimeVal tv_stamp;
+        if (stamp != NULL && g_time_val_from_iso8601(stamp, &tv_stamp)) {
+            muc_set_last_seen(saved_rooms[i], &tv_stamp);
+        }
+        g_free(stamp);
+    }
+
+    g_strfreev(saved_rooms);
+    g_key_file_free(history);
+
+    history_file = _get_history_file(last_seen_account);
+    last_seen_writer = filewriter_new(history_file, _serialise_last_seen, LAST_SEEN_SAVE_DELAY_MS);
+    g_free(history_file);
+}
+
 void
 muc_autocomplete(char *input, int *size)
 {
@@ -644,6 +943,12 @@ muc_autocomplete(char *input, int *size)
             input[*size] = '\0';
             char *search_str = NULL;
 
+            // prefix of a search that has since been reset
+            if (chat_room->autocomplete_generation != autocomplete_generation()) {
+                FREE_SET_NULL(chat_room->autocomplete_prefix);
+                chat_room->autocomplete_generation = autocomplete_generation();
+            }
+
             gchar *last_space = g_strrstr(input, " ");
             if (!last_space) {
                 search_str = input;
@@ -672,17 +977,6 @@ muc_autocomplete(char *input, int *size)
     }
 }
 
-void
-muc_jid_autocomplete_reset(const char * const room)
-{
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
-    if (chat_room) {
-        if (chat_room->jid_ac) {
-            autocomplete_reset(chat_room->jid_ac);
-        }
-    }
-}
-
 void
 muc_jid_autocomplete_add_all(const char * const room, GSList *jids)
 {
@@ -695,7 +989,7 @@ muc_jid_autocomplete_add_all(const char * const room, GSList *jids)
                 Jid *jidp = jid_create(jid);
                 if (jidp) {
                     if (jidp->barejid) {
-                        autocomplete_add(chat_room->jid_ac, jidp->barejid);
+                        autocomplete_add(chat_room->jid_ac, jid_intern(jidp->barejid));
                     }
                 }
                 jid_destroy(jidp);
@@ -705,22 +999,6 @@ muc_jid_autocomplete_add_all(const char * const room, GSList *jids)
     }
 }
 
-void
-muc_autocomplete_reset(const char * const room)
-{
-    ChatRoom *chat_room = g_hash_table_lookup(rooms, room);
-    if (chat_room) {
-        if (chat_room->nick_ac) {
-            autocomplete_reset(chat_room->nick_ac);
-        }
-
-        if (chat_room->autocomplete_prefix) {
-            free(chat_room->autocomplete_prefix);
-            chat_room->autocomplete_prefix = NULL;
-        }
-    }
-}
-
 char *
 muc_role_str(const char * const room)
 {
@@ -765,11 +1043,21 @@ static void
 _free_room(ChatRoom *room)
 {
     if (room) {
-        free(room->room);
+        jid_intern_release(room->room);
         free(room->nick);
         free(room->subject);
         free(room->password);
         free(room->autocomplete_prefix);
+
+        // indices don't own their entries, drop them before the roster frees the entries
+        g_sequence_free(room->occupants);
+        int i;
+        for (i = 0; i <= MUC_ROLE_MODERATOR; i++) {
+            g_sequence_free(room->occupants_by_role[i]);
+        }
+        for (i = 0; i <= MUC_AFFILIATION_OWNER; i++) {
+            g_sequence_free(room->occupants_by_affiliation[i]);
+        }
         if (room->roster) {
             g_hash_table_destroy(room->roster);
         }
@@ -781,23 +1069,128 @@ _free_room(ChatRoom *room)
         if (room->pending_broadcasts) {
             g_list_free_full(room->pending_broadcasts, free);
         }
+        g_queue_free_full(room->pending_history, (GDestroyNotify)_history_free);
+        g_free(room->seen);
         free(room);
     }
 }
 
-static
-gint _compare_occupants(Occupant *a, Occupant *b)
+static gint
+_compare_entries(OccupantEntry *a, OccupantEntry *b, gpointer data)
+{
+    gint result = g_strcmp0(a->collate_key, b->collate_key);
+    if (result == 0) {
+        result = g_strcmp0(a->occupant.nick, b->occupant.nick);
+    }
+
+    return result;
+}
+
+// compact rooms skip the collate key and order by nick ignoring ascii case
+static gint
+_compare_entries_compact(OccupantEntry *a, OccupantEntry *b, gpointer data)
 {
-    const char * utf8_str_a = a->nick;
-    const char * utf8_str_b = b->nick;
+    gint result = g_ascii_strcasecmp(a->occupant.nick, b->occupant.nick);
+    if (result == 0) {
+        result = strcmp(a->occupant.nick, b->occupant.nick);
+    }
 
-    gchar *key_a = g_utf8_collate_key(utf8_str_a, -1);
-    gchar *key_b = g_utf8_collate_key(utf8_str_b, -1);
+    return result;
+}
 
-    gint result = g_strcmp0(key_a, key_b);
+static OccupantEntry*
+_entry_new(const char * const nick, const char * const jid, muc_role_t role,
+    muc_affiliation_t affiliation, resource_presence_t presence, const char * const status)
+{
+    size_t nick_size = strlen(nick) + 1;
+    OccupantEntry *entry = malloc(sizeof(OccupantEntry) + nick_size);
+
+    entry->occupant.nick = (char *)(entry + 1);
+    memcpy(entry->occupant.nick, nick, nick_size);
+    entry->occupant.jid = jid ? strdup(jid) : NULL;
+    entry->occupant.status = status ? strdup(status) : NULL;
+    entry->occupant.presence = presence;
+    entry->occupant.role = role;
+    entry->occupant.affiliation = affiliation;
+    entry->collate_key = NULL;
+    entry->all_iter = NULL;
+    entry->role_iter = NULL;
+    entry->affiliation_iter = NULL;
+
+    return entry;
+}
 
-    g_free(key_a);
-    g_free(key_b);
+static void
+_entry_free(OccupantEntry *entry)
+{
+    if (entry) {
+        free(entry->occupant.jid);
+        free(entry->occupant.status);
+        g_free(entry->collate_key);
+        free(entry);
+    }
+}
+
+static void
+_roster_remove(ChatRoom *chat_room, const char * const nick)
+{
+    OccupantEntry *entry = g_hash_table_lookup(chat_room->roster, nick);
+    if (entry) {
+        // the autocompleter borrows the nick, drop it before the entry is freed
+        autocomplete_remove(chat_room->nick_ac, entry->occupant.nick);
+        g_sequence_remove(entry->all_iter);
+        if (entry->role_iter) {
+            g_sequence_remove(entry->role_iter);
+        }
+        if (entry->affiliation_iter) {
+            g_sequence_remove(entry->affiliation_iter);
+        }
+        g_hash_table_remove(chat_room->roster, nick);
+    }
+}
+
+static GList*
+_index_to_list(GSequence *index)
+{
+    GList *result = NULL;
+    GSequenceIter *iter = g_sequence_get_end_iter(index);
+    while (!g_sequence_iter_is_begin(iter)) {
+        iter = g_sequence_iter_prev(iter);
+        OccupantEntry *entry = g_sequence_get(iter);
+        result = g_list_prepend(result, &entry->occupant);
+    }
+
+    return result;
+}
+
+static GSList*
+_index_to_slist(GSequence *index)
+{
+    GSList *result = NULL;
+    GSequenceIter *iter = g_sequence_get_end_iter(index);
+    while (!g_sequence_iter_is_begin(iter)) {
+        iter = g_sequence_iter_prev(iter);
+        OccupantEntry *entry = g_sequence_get(iter);
+        result = g_slist_prepend(result, &entry->occupant);
+    }
+
+    return result;
+}
+
+// role or affiliation -1 matches any
+static GSList*
+_index_to_slist_where(GSequence *index, int role, int affiliation)
+{
+    GSList *result = NULL;
+    GSequenceIter *iter = g_sequence_get_end_iter(index);
+    while (!g_sequence_iter_is_begin(iter)) {
+        iter = g_sequence_iter_prev(iter);
+        OccupantEntry *entry = g_sequence_get(iter);
+        if ((role == -1 || entry->occupant.role == role) &&
+                (affiliation == -1 || entry->occupant.affiliation == affiliation)) {
+            result = g_slist_prepend(result, &entry->occupant);
+        }
+    }
 
     return result;
 }
@@ -895,46 +1288,84 @@ _affiliation_to_string(muc_affiliation_t affiliation)
     return result;
 }
 
-static Occupant*
-_muc_occupant_new(const char *const nick, const char * const jid, muc_role_t role, muc_affiliation_t affiliation, resource_presence_t presence,
-    const char * const status)
+/*
+ * Drop the collate keys and the role and affiliation indices, the index of all
+ * occupants is re-sorted in place and new occupants are added compact
+ */
+static void
+_room_compact(ChatRoom *chat_room)
 {
-    Occupant *occupant = malloc(sizeof(Occupant));
-
-    if (nick) {
-        occupant->nick = strdup(nick);
-    } else {
-        occupant->nick = NULL;
+    GList *entries = g_hash_table_get_values(chat_room->roster);
+    GList *curr = entries;
+    while (curr) {
+        OccupantEntry *entry = curr->data;
+        g_free(entry->collate_key);
+        entry->collate_key = NULL;
+        entry->role_iter = NULL;
+        entry->affiliation_iter = NULL;
+        curr = g_list_next(curr);
     }
+    g_list_free(entries);
 
-    if (jid) {
-        occupant->jid = strdup(jid);
-    } else {
-        occupant->jid = NULL;
+    // the indices don't own their entries, so can be emptied wholesale
+    int i;
+    for (i = 0; i <= MUC_ROLE_MODERATOR; i++) {
+        g_sequence_remove_range(g_sequence_get_begin_iter(chat_room->occupants_by_role[i]),
+            g_sequence_get_end_iter(chat_room->occupants_by_role[i]));
+    }
+    for (i = 0; i <= MUC_AFFILIATION_OWNER; i++) {
+        g_sequence_remove_range(g_sequence_get_begin_iter(chat_room->occupants_by_affiliation[i]),
+            g_sequence_get_end_iter(chat_room->occupants_by_affiliation[i]));
     }
+    g_sequence_sort(chat_room->occupants, (GCompareDataFunc)_compare_entries_compact, NULL);
 
-    occupant->presence = presence;
+    chat_room->compact = TRUE;
+}
 
-    if (status) {
-        occupant->status = strdup(status);
-    } else {
-        occupant->status = NULL;
+static void
+_history_free(MucHistory *history)
+{
+    if (history) {
+        free(history->nick);
+        free(history->message);
+        free(history);
     }
+}
 
-    occupant->role = role;
-    occupant->affiliation = affiliation;
+static gchar *
+_get_history_file(const char * const account_name)
+{
+    gchar *xdg_data = xdg_get_data_home();
+    gchar *account_file = str_replace(account_name, "/", "_");
+    gchar *result = g_strdup_printf("%s/profanity/lastseen/%s", xdg_data, account_file);
+
+    free(account_file);
+    g_free(xdg_data);
 
-    return occupant;
+    return result;
 }
 
-static void
-_occupant_free(Occupant *occupant)
+static gchar*
+_serialise_last_seen(gsize *length)
 {
-    if (occupant) {
-        free(occupant->nick);
-        free(occupant->jid);
-        free(occupant->status);
-        free(occupant);
-        occupant = NULL;
+    GKeyFile *history = g_key_file_new();
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, last_seen);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gint64 stamp = *(gint64 *)value;
+        GTimeVal tv_stamp;
+        tv_stamp.tv_sec = stamp / G_USEC_PER_SEC;
+        tv_stamp.tv_usec = stamp % G_USEC_PER_SEC;
+        gchar *stamp_str = g_time_val_to_iso8601(&tv_stamp);
+        g_key_file_set_string(history, key, "last_seen", stamp_str);
+        g_free(stamp_str);
     }
-}
\ No newline at end of file
+
+    gchar *g_history_data = g_key_file_to_data(history, length, NULL);
+    g_key_file_free(history);
+
+    return g_history_data;
+}
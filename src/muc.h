@@ -56,17 +56,33 @@ typedef enum {
     MUC_AFFILIATION_OWNER
 } muc_affiliation_t;
 
+// role, affiliation and presence are packed into one word, the nick is stored
+// with the room's roster entry
 typedef struct _muc_occupant_t {
     char *nick;
     char *jid;
-    muc_role_t role;
-    muc_affiliation_t affiliation;
-    resource_presence_t presence;
     char *status;
+    unsigned int role : 2;          // muc_role_t
+    unsigned int affiliation : 3;   // muc_affiliation_t
+    unsigned int presence : 3;      // resource_presence_t
 } Occupant;
 
+typedef struct _muc_history_t {
+    char *nick;
+    GTimeVal tv_stamp;
+    char *message;
+} MucHistory;
+
+#define MUC_SEEN_IDS_MAX 500
+// a live message has no server stamp, local time is taken back this far so a
+// clock running ahead of the server's cannot skip unseen history
+#define MUC_CLOCK_SKEW_SECS 120
+#define MUC_HISTORY_BATCH_MAX 1000
+
 void muc_init(void);
 void muc_close(void);
+void muc_set_compact_threshold(int threshold);
+gboolean muc_compact(const char * const room);
 
 void muc_join(const char * const room, const char * const nick, const char * const password, gboolean autojoin);
 void muc_leave(const char * const room);
@@ -94,7 +110,6 @@ void muc_roster_set_complete(const char * const room);
 GList * muc_roster(const char * const room);
 Autocomplete muc_roster_ac(const char * const room);
 Autocomplete muc_roster_jid_ac(const char * const room);
-void muc_jid_autocomplete_reset(const char * const room);
 void muc_jid_autocomplete_add_all(const char * const room, GSList *jids);
 
 Occupant* muc_roster_item(const char * const room, const char * const nick);
@@ -113,7 +128,6 @@ void muc_invites_remove(const char * const room);
 gint muc_invites_count(void);
 GSList* muc_invites(void);
 gboolean muc_invites_contain(const char * const room);
-void muc_invites_reset_ac(void);
 char* muc_invites_find(char *search_str);
 void muc_invites_clear(void);
 
@@ -123,8 +137,20 @@ char* muc_subject(const char * const room);
 void muc_pending_broadcasts_add(const char * const room, const char * const message);
 GList * muc_pending_broadcasts(const char * const room);
 
+void muc_pending_history_add(const char * const room, const char * const nick,
+    GTimeVal tv_stamp, const char * const message);
+GList * muc_pending_history(const char * const room);
+gint muc_pending_history_count(const char * const room);
+void muc_pending_history_clear(const char * const room);
+
+gboolean muc_message_seen(const char * const room, const char * const id,
+    const char * const nick);
+void muc_set_last_seen(const char * const room, GTimeVal *tv_stamp);
+void muc_set_last_seen_now(const char * const room);
+gboolean muc_last_seen(const char * const room, GTimeVal *tv_stamp);
+void muc_history_load(const char * const account_name);
+
 void muc_autocomplete(char *input, int *size);
-void muc_autocomplete_reset(const char * const room);
 
 gboolean muc_requires_config(const char * const room);
 void muc_set_requires_config(const char * const room, gboolean val);
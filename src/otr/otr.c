@@ -41,21 +41,57 @@
 #include "otr/otr.h"
 #include "otr/otrlib.h"
 #include "log.h"
+#include "common.h"
 #include "roster_list.h"
 #include "contact.h"
 #include "ui/ui.h"
 #include "config/preferences.h"
 #include "chat_session.h"
+#include "tools/worker.h"
+#include "tools/filewriter.h"
 
 #define PRESENCE_ONLINE 1
 #define PRESENCE_OFFLINE 0
 #define PRESENCE_UNKNOWN -1
 
+#define KEYGEN_PROGRESS_SECS 10
+#define OTR_WRITE_DELAY_MS 2000
+
+typedef struct otr_keygen_t {
+    OtrlUserState user_state;
+    void *newkey;
+    gcry_error_t err;
+    char *accountname;
+    gchar *keysfilename;
+} OtrKeygen;
+
 static OtrlUserState user_state;
 static OtrlMessageAppOps ops;
 static char *jid;
 static gboolean data_loaded;
+static gboolean data_pending;
 static GHashTable *smp_initiators;
+static FileWriter fps_writer = NULL;
+
+// per contact crypto timings, keyed on barejid
+static GHashTable *stats = NULL;
+static GTimer *crypto_timer = NULL;
+
+// private key generation running on a worker thread
+static OtrKeygen *keygen = NULL;
+static GTimer *keygen_timer = NULL;
+static int keygen_reported = 0;
+
+static void _keygen_calculate(gpointer data);
+static void _keygen_done(gpointer data);
+static void _keygen_free(OtrKeygen *gen);
+static void _keygen_progress(void);
+static gchar* _otr_dir(void);
+static void _load_data(void);
+static void _close_writers(void);
+static gchar* _serialise_fingerprints(gsize *length);
+static OtrStats* _stats_for(const char * const barejid);
+static int _crypto_micros(void);
 
 OtrlUserState
 otr_userstate(void)
@@ -117,27 +153,7 @@ cb_inject_message(void *opdata, const char *accountname,
 static void
 cb_write_fingerprints(void *opdata)
 {
-    gcry_error_t err = 0;
-
-    gchar *data_home = xdg_get_data_home();
-    GString *basedir = g_string_new(data_home);
-    free(data_home);
-
-    gchar *account_dir = str_replace(jid, "@", "_at_");
-    g_string_append(basedir, "/profanity/otr/");
-    g_string_append(basedir, account_dir);
-    g_string_append(basedir, "/");
-    free(account_dir);
-
-    GString *fpsfilename = g_string_new(basedir->str);
-    g_string_append(fpsfilename, "fingerprints.txt");
-    err = otrl_privkey_write_fingerprints(user_state, fpsfilename->str);
-    if (!err == GPG_ERR_NO_ERROR) {
-        log_error("Failed to write fingerprints file");
-        cons_show_error("Failed to create fingerprints file");
-    }
-    g_string_free(basedir, TRUE);
-    g_string_free(fpsfilename, TRUE);
+    filewriter_changed(fps_writer);
 }
 
 static void
@@ -173,15 +189,32 @@ otr_init(void)
     otrlib_init_ops(&ops);
     otrlib_init_timer();
     smp_initiators = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    stats = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free);
+    crypto_timer = g_timer_new();
 
     data_loaded = FALSE;
+    data_pending = FALSE;
 }
 
 void
 otr_shutdown(void)
 {
+    _close_writers();
     if (jid != NULL) {
         free(jid);
+        jid = NULL;
+    }
+    if (keygen_timer != NULL) {
+        g_timer_destroy(keygen_timer);
+        keygen_timer = NULL;
+    }
+    if (stats != NULL) {
+        g_hash_table_destroy(stats);
+        stats = NULL;
+    }
+    if (crypto_timer != NULL) {
+        g_timer_destroy(crypto_timer);
+        crypto_timer = NULL;
     }
 }
 
@@ -189,49 +222,79 @@ void
 otr_poll(void)
 {
     otrlib_poll();
+    _keygen_progress();
 }
 
+/*
+ * Keys and fingerprints are read when OTR is first used on the connection
+ */
 void
 otr_on_connect(ProfAccount *account)
 {
+    // pending writes belong to the previous user state
+    _close_writers();
+
     if (jid != NULL) {
         free(jid);
     }
     jid = strdup(account->jid);
-    log_info("Loading OTR key for %s", jid);
 
-    gchar *data_home = xdg_get_data_home();
-    GString *basedir = g_string_new(data_home);
-    free(data_home);
+    user_state = otrl_userstate_create();
+    data_loaded = FALSE;
+    data_pending = TRUE;
+    g_hash_table_remove_all(stats);
+}
 
+static gchar*
+_otr_dir(void)
+{
+    gchar *data_home = xdg_get_data_home();
     gchar *account_dir = str_replace(jid, "@", "_at_");
-    g_string_append(basedir, "/profanity/otr/");
-    g_string_append(basedir, account_dir);
-    g_string_append(basedir, "/");
+    gchar *result = g_strdup_printf("%s/profanity/otr/%s/", data_home, account_dir);
     free(account_dir);
+    free(data_home);
 
-    if (!mkdir_recursive(basedir->str)) {
-        log_error("Could not create %s for account %s.", basedir->str, jid);
-        cons_show_error("Could not create %s for account %s.", basedir->str, jid);
-        g_string_free(basedir, TRUE);
+    return result;
+}
+
+static void
+_load_data(void)
+{
+    if (!data_pending) {
         return;
     }
+    data_pending = FALSE;
 
-    user_state = otrl_userstate_create();
+    log_info("Loading OTR key for %s", jid);
+    gchar *basedir = _otr_dir();
+    if (!mkdir_recursive(basedir)) {
+        log_error("Could not create %s for account %s.", basedir, jid);
+        cons_show_error("Could not create %s for account %s.", basedir, jid);
+        g_free(basedir);
+        return;
+    }
 
     gcry_error_t err = 0;
 
-    GString *keysfilename = g_string_new(basedir->str);
-    g_string_append(keysfilename, "keys.txt");
-    if (!g_file_test(keysfilename->str, G_FILE_TEST_IS_REGULAR)) {
-        log_info("No private key file found %s", keysfilename->str);
+    gchar *keysfilename = g_strdup_printf("%skeys.txt", basedir);
+    gchar *fpsfilename = g_strdup_printf("%sfingerprints.txt", basedir);
+    gchar *instagsfilename = g_strdup_printf("%sinstance_tags.txt", basedir);
+    g_free(basedir);
+
+    // later changes are written behind, the files are not read again
+    fps_writer = filewriter_new(fpsfilename, _serialise_fingerprints, OTR_WRITE_DELAY_MS);
+    otrlib_load_instags(user_state, instagsfilename);
+    g_free(instagsfilename);
+
+    if (!g_file_test(keysfilename, G_FILE_TEST_IS_REGULAR)) {
+        log_info("No private key file found %s", keysfilename);
         data_loaded = FALSE;
     } else {
-        log_info("Loading OTR private key %s", keysfilename->str);
-        err = otrl_privkey_read(user_state, keysfilename->str);
+        log_info("Loading OTR private key %s", keysfilename);
+        err = otrl_privkey_read(user_state, keysfilename);
         if (!err == GPG_ERR_NO_ERROR) {
-            g_string_free(basedir, TRUE);
-            g_string_free(keysfilename, TRUE);
+            g_free(keysfilename);
+            g_free(fpsfilename);
             log_error("Failed to load private key");
             return;
         } else {
@@ -240,18 +303,15 @@ otr_on_connect(ProfAccount *account)
         }
     }
 
-    GString *fpsfilename = g_string_new(basedir->str);
-    g_string_append(fpsfilename, "fingerprints.txt");
-    if (!g_file_test(fpsfilename->str, G_FILE_TEST_IS_REGULAR)) {
-        log_info("No fingerprints file found %s", fpsfilename->str);
+    if (!g_file_test(fpsfilename, G_FILE_TEST_IS_REGULAR)) {
+        log_info("No fingerprints file found %s", fpsfilename);
         data_loaded = FALSE;
     } else {
-        log_info("Loading fingerprints %s", fpsfilename->str);
-        err = otrl_privkey_read_fingerprints(user_state, fpsfilename->str, NULL, NULL);
+        log_info("Loading fingerprints %s", fpsfilename);
+        err = otrl_privkey_read_fingerprints(user_state, fpsfilename, NULL, NULL);
         if (!err == GPG_ERR_NO_ERROR) {
-            g_string_free(basedir, TRUE);
-            g_string_free(keysfilename, TRUE);
-            g_string_free(fpsfilename, TRUE);
+            g_free(keysfilename);
+            g_free(fpsfilename);
             log_error("Failed to load fingerprints");
             return;
         } else {
@@ -260,109 +320,172 @@ otr_on_connect(ProfAccount *account)
         }
     }
 
-    if (data_loaded) {
-        cons_show("Loaded OTR private key for %s", jid);
+    g_free(keysfilename);
+    g_free(fpsfilename);
+}
+
+static void
+_close_writers(void)
+{
+    filewriter_free(fps_writer);
+    fps_writer = NULL;
+    otrlib_close_instags();
+}
+
+static gchar*
+_serialise_fingerprints(gsize *length)
+{
+    FILE *stream = tmpfile();
+    if (stream == NULL) {
+        log_error("Could not serialise fingerprints");
+        return NULL;
     }
 
-    g_string_free(basedir, TRUE);
-    g_string_free(keysfilename, TRUE);
-    g_string_free(fpsfilename, TRUE);
-    return;
+    gchar *result = NULL;
+    gcry_error_t err = otrl_privkey_write_fingerprints_FILEp(user_state, stream);
+    if (err == GPG_ERR_NO_ERROR) {
+        result = prof_read_stream(stream, length);
+    }
+    fclose(stream);
+    if (result == NULL) {
+        log_error("Could not serialise fingerprints");
+    }
+
+    return result;
 }
 
+/*
+ * Start generating a private key, the slow part runs on a worker thread and
+ * the key is installed from the main loop when it is ready
+ */
 void
 otr_keygen(ProfAccount *account)
 {
+    _load_data();
     if (data_loaded) {
         cons_show("OTR key already generated.");
         return;
     }
 
-    if (jid != NULL) {
-        free(jid);
+    if (keygen != NULL) {
+        cons_show("OTR key generation already in progress.");
+        return;
     }
-    jid = strdup(account->jid);
+
     log_info("Generating OTR key for %s", jid);
 
-    gchar *data_home = xdg_get_data_home();
-    GString *basedir = g_string_new(data_home);
-    free(data_home);
+    gchar *basedir = _otr_dir();
+    if (!mkdir_recursive(basedir)) {
+        log_error("Could not create %s for account %s.", basedir, jid);
+        cons_show_error("Could not create %s for account %s.", basedir, jid);
+        g_free(basedir);
+        return;
+    }
 
-    gchar *account_dir = str_replace(jid, "@", "_at_");
-    g_string_append(basedir, "/profanity/otr/");
-    g_string_append(basedir, account_dir);
-    g_string_append(basedir, "/");
-    free(account_dir);
+    OtrKeygen *gen = malloc(sizeof(OtrKeygen));
+    gen->user_state = user_state;
+    gen->newkey = NULL;
+    gen->err = 0;
+    gen->accountname = strdup(account->jid);
+    gen->keysfilename = g_strdup_printf("%skeys.txt", basedir);
+    g_free(basedir);
 
-    if (!mkdir_recursive(basedir->str)) {
-        log_error("Could not create %s for account %s.", basedir->str, jid);
-        cons_show_error("Could not create %s for account %s.", basedir->str, jid);
-        g_string_free(basedir, TRUE);
+    gcry_error_t err = otrl_privkey_generate_start(user_state, gen->accountname, "xmpp", &gen->newkey);
+    if (!err == GPG_ERR_NO_ERROR) {
+        log_error("Failed to start private key generation");
+        cons_show_error("Failed to generate private key");
+        _keygen_free(gen);
         return;
     }
 
-    gcry_error_t err = 0;
-
-    GString *keysfilename = g_string_new(basedir->str);
-    g_string_append(keysfilename, "keys.txt");
-    log_debug("Generating private key file %s for %s", keysfilename->str, jid);
+    log_debug("Generating private key file %s for %s", gen->keysfilename, jid);
     cons_show("Generating private key, this may take some time.");
     cons_show("Moving the mouse randomly around the screen may speed up the process!");
-    ui_update();
-    err = otrl_privkey_generate(user_state, keysfilename->str, account->jid, "xmpp");
+
+    keygen = gen;
+    keygen_reported = 0;
+    if (keygen_timer == NULL) {
+        keygen_timer = g_timer_new();
+    } else {
+        g_timer_start(keygen_timer);
+    }
+
+    // may take minutes, so quitting does not wait for it
+    worker_run_detached(_keygen_calculate, _keygen_done, gen);
+}
+
+static void
+_keygen_calculate(gpointer data)
+{
+    OtrKeygen *gen = data;
+    gen->err = otrl_privkey_generate_calculate(gen->newkey);
+}
+
+static void
+_keygen_done(gpointer data)
+{
+    OtrKeygen *gen = data;
+    keygen = NULL;
+
+    // connected as another account while generating
+    if (g_strcmp0(gen->accountname, jid) != 0) {
+        otrl_privkey_generate_cancelled(gen->user_state, gen->newkey);
+        log_info("Discarded private key generated for %s", gen->accountname);
+        cons_show("Private key generation for %s discarded, the account changed.", gen->accountname);
+        _keygen_free(gen);
+        return;
+    }
+
+    // same account but reconnected, the key goes into the current user state
+    _load_data();
+
+    gcry_error_t err = gen->err;
+    if (err == GPG_ERR_NO_ERROR) {
+        err = otrl_privkey_generate_finish(user_state, gen->newkey, gen->keysfilename);
+    } else {
+        otrl_privkey_generate_cancelled(user_state, gen->newkey);
+    }
     if (!err == GPG_ERR_NO_ERROR) {
-        g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
         log_error("Failed to generate private key");
         cons_show_error("Failed to generate private key");
+        _keygen_free(gen);
         return;
     }
     log_info("Private key generated");
     cons_show("");
     cons_show("Private key generation complete.");
 
-    GString *fpsfilename = g_string_new(basedir->str);
-    g_string_append(fpsfilename, "fingerprints.txt");
-    log_debug("Generating fingerprints file %s for %s", fpsfilename->str, jid);
-    err = otrl_privkey_write_fingerprints(user_state, fpsfilename->str);
-    if (!err == GPG_ERR_NO_ERROR) {
-        g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
-        log_error("Failed to create fingerprints file");
-        cons_show_error("Failed to create fingerprints file");
-        return;
-    }
-    log_info("Fingerprints file created");
+    data_loaded = TRUE;
+    cb_write_fingerprints(NULL);
+    _keygen_free(gen);
+}
 
-    err = otrl_privkey_read(user_state, keysfilename->str);
-    if (!err == GPG_ERR_NO_ERROR) {
-        g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
-        log_error("Failed to load private key");
-        data_loaded = FALSE;
-        return;
-    }
+static void
+_keygen_free(OtrKeygen *gen)
+{
+    free(gen->accountname);
+    g_free(gen->keysfilename);
+    free(gen);
+}
 
-    err = otrl_privkey_read_fingerprints(user_state, fpsfilename->str, NULL, NULL);
-    if (!err == GPG_ERR_NO_ERROR) {
-        g_string_free(basedir, TRUE);
-        g_string_free(keysfilename, TRUE);
-        log_error("Failed to load fingerprints");
-        data_loaded = FALSE;
+static void
+_keygen_progress(void)
+{
+    if (keygen == NULL) {
         return;
     }
 
-    data_loaded = TRUE;
-
-    g_string_free(basedir, TRUE);
-    g_string_free(keysfilename, TRUE);
-    g_string_free(fpsfilename, TRUE);
-    return;
+    int elapsed = g_timer_elapsed(keygen_timer, NULL);
+    if (elapsed >= keygen_reported + KEYGEN_PROGRESS_SECS) {
+        keygen_reported = elapsed - (elapsed % KEYGEN_PROGRESS_SECS);
+        cons_show("Still generating private key (%d seconds)...", keygen_reported);
+    }
 }
 
 gboolean
 otr_key_loaded(void)
 {
+    _load_data();
     return data_loaded;
 }
 
@@ -517,12 +640,14 @@ otr_smp_answer(const char * const recipient, const char *answer)
 void
 otr_end_session(const char * const recipient)
 {
+    _load_data();
     otrlib_end_session(user_state, recipient, jid, &ops);
 }
 
 char *
 otr_get_my_fingerprint(void)
 {
+    _load_data();
     char fingerprint[45];
     otrl_privkey_fingerprint(user_state, fingerprint, jid, "xmpp");
     char *result = strdup(fingerprint);
@@ -533,6 +658,7 @@ otr_get_my_fingerprint(void)
 char *
 otr_get_their_fingerprint(const char * const recipient)
 {
+    _load_data();
     ConnContext *context = otrlib_context_find(user_state, recipient, jid);
 
     if (context != NULL) {
@@ -600,9 +726,17 @@ otr_get_policy(const char * const recipient)
 char *
 otr_encrypt_message(const char * const to, const char * const message)
 {
+    _load_data();
     char *newmessage = NULL;
+    g_timer_start(crypto_timer);
     gcry_error_t err = otrlib_encrypt_message(user_state, &ops, jid, to, message, &newmessage);
 
+    OtrStats *to_stats = _stats_for(to);
+    int micros = _crypto_micros();
+    to_stats->encrypted++;
+    to_stats->encrypt_micros += micros;
+    to_stats->encrypt_max_micros = MAX(to_stats->encrypt_max_micros, micros);
+
     if (err != 0) {
         return NULL;
     } else {
@@ -613,11 +747,19 @@ otr_encrypt_message(const char * const to, const char * const message)
 char *
 otr_decrypt_message(const char * const from, const char * const message, gboolean *was_decrypted)
 {
+    _load_data();
     char *decrypted = NULL;
     OtrlTLV *tlvs = NULL;
 
+    g_timer_start(crypto_timer);
     int result = otrlib_decrypt_message(user_state, &ops, jid, from, message, &decrypted, &tlvs);
 
+    OtrStats *from_stats = _stats_for(from);
+    int micros = _crypto_micros();
+    from_stats->decrypted++;
+    from_stats->decrypt_micros += micros;
+    from_stats->decrypt_max_micros = MAX(from_stats->decrypt_max_micros, micros);
+
     // internal libotr message
     if (result == 1) {
         ConnContext *context = otrlib_context_find(user_state, from, jid);
@@ -653,4 +795,29 @@ void
 otr_free_message(char *message)
 {
     otrl_message_free(message);
-}
\ No newline at end of file
+}
+
+OtrStats*
+otr_stats(const char * const recipient)
+{
+    return g_hash_table_lookup(stats, recipient);
+}
+
+static OtrStats*
+_stats_for(const char * const barejid)
+{
+    OtrStats *result = g_hash_table_lookup(stats, barejid);
+    if (result == NULL) {
+        result = malloc(sizeof(OtrStats));
+        memset(result, 0, sizeof(OtrStats));
+        g_hash_table_insert(stats, strdup(barejid), result);
+    }
+
+    return result;
+}
+
+static int
+_crypto_micros(void)
+{
+    return (int)(g_timer_elapsed(crypto_timer, NULL) * G_USEC_PER_SEC);
+}
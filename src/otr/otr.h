@@ -46,6 +46,16 @@ typedef enum {
     PROF_OTRPOLICY_ALWAYS
 } prof_otrpolicy_t;
 
+// time spent in libotr for one contact since connecting
+typedef struct otr_stats_t {
+    int encrypted;
+    gint64 encrypt_micros;
+    int encrypt_max_micros;
+    int decrypted;
+    gint64 decrypt_micros;
+    int decrypt_max_micros;
+} OtrStats;
+
 OtrlUserState otr_userstate(void);
 OtrlMessageAppOps* otr_messageops(void);
 GHashTable* otr_smpinitators(void);
@@ -80,6 +90,8 @@ char * otr_decrypt_message(const char * const from, const char * const message,
 
 void otr_free_message(char *message);
 
+OtrStats* otr_stats(const char * const recipient);
+
 prof_otrpolicy_t otr_get_policy(const char * const recipient);
 
 #endif
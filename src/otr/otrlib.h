@@ -44,6 +44,9 @@ void otrlib_init_ops(OtrlMessageAppOps *ops);
 void otrlib_init_timer(void);
 void otrlib_poll(void);
 
+void otrlib_load_instags(OtrlUserState user_state, const char * const filename);
+void otrlib_close_instags(void);
+
 ConnContext * otrlib_context_find(OtrlUserState user_state, const char * const recipient, char *jid);
 
 void otrlib_end_session(OtrlUserState user_state, const char * const recipient, char *jid, OtrlMessageAppOps *ops);
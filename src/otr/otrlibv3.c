@@ -55,6 +55,16 @@ otrlib_poll(void)
 {
 }
 
+void
+otrlib_load_instags(OtrlUserState user_state, const char * const filename)
+{
+}
+
+void
+otrlib_close_instags(void)
+{
+}
+
 char *
 otrlib_start_query(void)
 {
@@ -38,24 +38,37 @@
 
 #include "ui/ui.h"
 #include "log.h"
+#include "common.h"
 #include "otr/otr.h"
 #include "otr/otrlib.h"
+#include "tools/filewriter.h"
+
+#define INSTAGS_WRITE_DELAY_MS 2000
 
 static GTimer *timer;
 static unsigned int current_interval;
 
+// instance tags as last generated, written behind
+static gchar *instags = NULL;
+static FileWriter instags_writer = NULL;
+
+static gchar* _serialise_instags(gsize *length);
+
 OtrlPolicy
 otrlib_policy(void)
 {
     return OTRL_POLICY_ALLOW_V1 | OTRL_POLICY_ALLOW_V2;
 }
 
+/*
+ * libotr turns polling on through timer_control when a context needs it and
+ * off again once nothing is left to expire
+ */
 void
 otrlib_init_timer(void)
 {
-    OtrlUserState user_state = otr_userstate();
     timer = g_timer_new();
-    current_interval = otrl_message_poll_get_default_interval(user_state);
+    current_interval = 0;
 }
 
 void
@@ -71,6 +84,41 @@ otrlib_poll(void)
     }
 }
 
+void
+otrlib_load_instags(OtrlUserState user_state, const char * const filename)
+{
+    otrlib_close_instags();
+
+    if (g_file_test(filename, G_FILE_TEST_IS_REGULAR)) {
+        gcry_error_t err = otrl_instag_read(user_state, filename);
+        if (!err == GPG_ERR_NO_ERROR) {
+            log_error("Failed to load instance tags %s", filename);
+        }
+    }
+
+    instags_writer = filewriter_new(filename, _serialise_instags, INSTAGS_WRITE_DELAY_MS);
+}
+
+void
+otrlib_close_instags(void)
+{
+    filewriter_free(instags_writer);
+    instags_writer = NULL;
+    g_free(instags);
+    instags = NULL;
+}
+
+static gchar*
+_serialise_instags(gsize *length)
+{
+    if (instags == NULL) {
+        return NULL;
+    }
+
+    *length = strlen(instags);
+    return g_strdup(instags);
+}
+
 char *
 otrlib_start_query(void)
 {
@@ -105,7 +153,11 @@ cb_otr_error_message_free(void *opdata, const char *err_msg)
 static void
 cb_timer_control(void *opdata, unsigned int interval)
 {
-    current_interval = interval;
+    if (interval != current_interval) {
+        log_debug("OTR poll interval set to %u seconds", interval);
+        current_interval = interval;
+        g_timer_start(timer);
+    }
 }
 
 static void
@@ -186,6 +238,36 @@ cb_handle_smp_event(void *opdata, OtrlSMPEvent smp_event,
     }
 }
 
+/*
+ * libotr writes the whole tag file when generating, so generate into memory
+ * and leave the file to the writer
+ */
+static void
+cb_create_instag(void *opdata, const char *accountname, const char *protocol)
+{
+    FILE *stream = tmpfile();
+    if (stream == NULL) {
+        log_error("Could not generate instance tag");
+        return;
+    }
+
+    gchar *data = NULL;
+    gsize size = 0;
+    gcry_error_t err = otrl_instag_generate_FILEp(otr_userstate(), stream, accountname, protocol);
+    if (err == GPG_ERR_NO_ERROR) {
+        data = prof_read_stream(stream, &size);
+    }
+    fclose(stream);
+    if (data == NULL) {
+        log_error("Could not generate instance tag");
+        return;
+    }
+
+    g_free(instags);
+    instags = data;
+    filewriter_changed(instags_writer);
+}
+
 void
 otrlib_init_ops(OtrlMessageAppOps *ops)
 {
@@ -194,6 +276,7 @@ otrlib_init_ops(OtrlMessageAppOps *ops)
     ops->handle_msg_event = cb_handle_msg_event;
     ops->handle_smp_event = cb_handle_smp_event;
     ops->timer_control = cb_timer_control;
+    ops->create_instag = cb_create_instag;
 }
 
 ConnContext *
@@ -42,6 +42,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <curl/curl.h>
 #include <glib.h>
 
 #include "profanity.h"
@@ -53,6 +54,11 @@
 #include "common.h"
 #include "contact.h"
 #include "roster_list.h"
+#include "jid.h"
+#include "tools/filewriter.h"
+#include "tools/frecency.h"
+#include "tools/http.h"
+#include "tools/worker.h"
 #include "log.h"
 #include "muc.h"
 #ifdef HAVE_LIBOTR
@@ -67,13 +73,33 @@ static void _handle_idle_time(void);
 static void _init(const int disable_tls, char *log_level);
 static void _shutdown(void);
 static void _create_directories(void);
+static void _startup_phase(const char * const phase);
+static void _startup_report(void);
+static void _preload_caps(gpointer data);
+static void _startup_background_done(gpointer data);
 
 static gboolean idle = FALSE;
 
+// time spent in each startup phase, kept with --startup-profile
+static gboolean startup_profile = FALSE;
+static GTimer *startup_timer = NULL;
+static gdouble startup_last = 0;
+static GString *startup_phases = NULL;
+
 void
-prof_run(const int disable_tls, char *log_level, char *account_name)
+prof_run(const int disable_tls, char *log_level, char *account_name, const int profile_startup)
 {
+    if (profile_startup) {
+        startup_profile = TRUE;
+        startup_timer = g_timer_new();
+        startup_phases = g_string_new("");
+    }
+
     _init(disable_tls, log_level);
+    ui_update();
+    _startup_phase("first paint");
+    _startup_report();
+
     log_info("Starting main event loop");
     ui_input_nonblocking();
     GTimer *timer = g_timer_new();
@@ -115,6 +141,11 @@ prof_run(const int disable_tls, char *log_level, char *account_name)
                 g_timer_start(timer);
             }
 
+            filewriter_tick();
+            worker_poll();
+            http_process();
+            notifier_tick();
+
             ch = ui_get_char(inp, &size, &result);
 
             ui_handle_special_keys(&ch, result);
@@ -197,7 +228,7 @@ process_input(char *inp)
     }
 
     ui_input_clear();
-    roster_reset_search_attempts();
+    cmd_reset_autocomplete();
 
     return result;
 }
@@ -256,10 +287,16 @@ _init(const int disable_tls, char *log_level)
     signal(SIGPIPE, SIG_IGN);
     signal(SIGINT, SIG_IGN);
     signal(SIGTSTP, SIG_IGN);
+    // before any thread uses curl
+    curl_global_init(CURL_GLOBAL_ALL);
     _create_directories();
     log_level_t prof_log_level = log_level_from_string(log_level);
     prefs_load();
+    _startup_phase("preferences");
     log_init(prof_log_level);
+    filewriter_init();
+    worker_init();
+    http_init();
     if (strcmp(PACKAGE_STATUS, "development") == 0) {
 #ifdef HAVE_GIT_VERSION
             log_info("Starting Profanity (%sdev.%s.%s)...", PACKAGE_VERSION, PROF_GIT_BRANCH, PROF_GIT_REVISION);
@@ -271,33 +308,95 @@ _init(const int disable_tls, char *log_level)
     }
     chat_log_init();
     groupchat_log_init();
+    _startup_phase("logs");
     accounts_load();
+    _startup_phase("accounts");
     char *theme = prefs_get_string(PREF_THEME);
     theme_init(theme);
     prefs_free_string(theme);
+    _startup_phase("theme");
     ui_init();
+    _startup_phase("ui");
     jabber_init(disable_tls);
+    // the capabilities cache is only needed once connected
+    worker_run(_preload_caps, _startup_background_done, "capabilities cache");
     cmd_init();
+    _startup_phase("xmpp and commands");
     log_info("Initialising contact list");
     roster_init();
     muc_init();
+    muc_set_compact_threshold(prefs_get_occupants_compact());
+    frecency_init();
+    frecency_load();
+    _startup_phase("rooms and contacts");
 #ifdef HAVE_LIBOTR
     otr_init();
+    _startup_phase("otr");
 #endif
     atexit(_shutdown);
 }
 
+static void
+_startup_phase(const char * const phase)
+{
+    if (startup_profile) {
+        gdouble now = g_timer_elapsed(startup_timer, NULL) * 1000;
+        g_string_append_printf(startup_phases, "  %-20s %8.1f ms %8.1f ms\n", phase, now - startup_last, now);
+        startup_last = now;
+    }
+}
+
+static void
+_startup_report(void)
+{
+    if (startup_profile) {
+        cons_show("Startup profile:              phase     total");
+        gchar **lines = g_strsplit(startup_phases->str, "\n", -1);
+        int i;
+        for (i = 0; lines[i] != NULL && lines[i][0] != '\0'; i++) {
+            cons_show("%s", lines[i]);
+            log_info("Startup:%s", lines[i]);
+        }
+        g_strfreev(lines);
+        g_string_free(startup_phases, TRUE);
+        startup_phases = NULL;
+    }
+}
+
+static void
+_preload_caps(gpointer data)
+{
+    caps_preload();
+}
+
+static void
+_startup_background_done(gpointer data)
+{
+    if (startup_profile) {
+        const char *name = data;
+        gdouble now = g_timer_elapsed(startup_timer, NULL) * 1000;
+        cons_show("  %-20s ready at %.1f ms", name, now);
+        log_info("Startup:  %s ready at %.1f ms", name, now);
+    }
+}
+
 static void
 _shutdown(void)
 {
+    worker_shutdown();
+    http_shutdown();
     ui_clear_win_title();
     ui_close_all_wins();
     jabber_disconnect();
     jabber_shutdown();
     roster_free();
+    cmd_history_save();
     muc_close();
+    frecency_close();
     caps_close();
     ui_close();
+    // after everything holding interned jids
+    jid_intern_clear();
 #ifdef HAVE_LIBOTR
     otr_shutdown();
 #endif
@@ -305,7 +404,13 @@ _shutdown(void)
     prefs_close();
     theme_close();
     accounts_close();
+    filewriter_shutdown();
     cmd_uninit();
+    curl_global_cleanup();
+    if (startup_timer) {
+        g_timer_destroy(startup_timer);
+        startup_timer = NULL;
+    }
     log_close();
 }
 
@@ -321,6 +426,10 @@ _create_directories(void)
     g_string_append(chatlogs_dir, "/profanity/chatlogs");
     GString *logs_dir = g_string_new(xdg_data);
     g_string_append(logs_dir, "/profanity/logs");
+    GString *history_dir = g_string_new(xdg_data);
+    g_string_append(history_dir, "/profanity/history");
+    GString *lastseen_dir = g_string_new(xdg_data);
+    g_string_append(lastseen_dir, "/profanity/lastseen");
 
     if (!mkdir_recursive(themes_dir->str)) {
         log_error("Error while creating directory %s", themes_dir->str);
@@ -331,10 +440,18 @@ _create_directories(void)
     if (!mkdir_recursive(logs_dir->str)) {
         log_error("Error while creating directory %s", logs_dir->str);
     }
+    if (!mkdir_recursive(history_dir->str)) {
+        log_error("Error while creating directory %s", history_dir->str);
+    }
+    if (!mkdir_recursive(lastseen_dir->str)) {
+        log_error("Error while creating directory %s", lastseen_dir->str);
+    }
 
     g_string_free(themes_dir, TRUE);
     g_string_free(chatlogs_dir, TRUE);
     g_string_free(logs_dir, TRUE);
+    g_string_free(history_dir, TRUE);
+    g_string_free(lastseen_dir, TRUE);
 
     g_free(xdg_config);
     g_free(xdg_data);
@@ -32,7 +32,7 @@
  *
  */
 
-
+#include <stdlib.h>
 #include <string.h>
 #include <glib.h>
 #include <assert.h>
@@ -42,6 +42,20 @@
 #include "contact.h"
 #include "jid.h"
 #include "tools/autocomplete.h"
+#include "tools/frecency.h"
+
+typedef struct roster_entry_t {
+    PContact contact;
+    gchar *collate_key;
+
+    // positions in the ordered indices
+    const char *presence;
+    GSequenceIter *all_iter;
+    GSequenceIter *presence_iter;
+    GSequenceIter *online_iter;
+    GSequenceIter *nogroup_iter;
+    GSList *group_iters;
+} RosterEntry;
 
 // nicknames
 static Autocomplete name_ac;
@@ -55,19 +69,35 @@ static Autocomplete fulljid_ac;
 // groups
 static Autocomplete groups_ac;
 
-// contacts, indexed on barejid
+// roster entries, indexed on barejid
 static GHashTable *contacts;
 
 // nickname to jid map
 static GHashTable *name_to_barejid;
 
+// entries ordered by name, updated as contacts change
+static GSequence *index_all;
+static GSequence *index_online;
+static GSequence *index_nogroup;
+static GHashTable *index_by_presence;
+static GHashTable *index_by_group;
+
 static gboolean _key_equals(void *key1, void *key2);
 static gboolean _datetimes_equal(GDateTime *dt1, GDateTime *dt2);
 static void _replace_name(const char * const current_name,
     const char * const new_name, const char * const barejid);
 static void _add_name_and_barejid(const char * const name,
     const char * const barejid);
-static gint _compare_contacts(PContact a, PContact b);
+static void _indices_create(void);
+static void _indices_destroy(void);
+static RosterEntry * _entry_new(PContact contact);
+static void _entry_free(RosterEntry *entry);
+static void _entry_index_presence(RosterEntry *entry);
+static void _entry_index_groups(RosterEntry *entry);
+static void _entry_index_name(RosterEntry *entry);
+static GSList * _index_to_list(GSequence *index);
+static gint _compare_entries(RosterEntry *a, RosterEntry *b, gpointer data);
+static int _contact_weight(const char * const name);
 
 void
 roster_clear(void)
@@ -76,9 +106,11 @@ roster_clear(void)
     autocomplete_clear(barejid_ac);
     autocomplete_clear(fulljid_ac);
     autocomplete_clear(groups_ac);
+    _indices_destroy();
     g_hash_table_destroy(contacts);
-    contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free,
-        (GDestroyNotify)p_contact_free);
+    _indices_create();
+    contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, NULL,
+        (GDestroyNotify)_entry_free);
     g_hash_table_destroy(name_to_barejid);
     name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
         g_free);
@@ -91,17 +123,19 @@ roster_update_presence(const char * const barejid, Resource *resource,
     assert(barejid != NULL);
     assert(resource != NULL);
 
-    PContact contact = g_hash_table_lookup(contacts, barejid);
-    if (contact == NULL) {
+    RosterEntry *entry = g_hash_table_lookup(contacts, barejid);
+    if (entry == NULL) {
         return FALSE;
     }
+    PContact contact = entry->contact;
     if (!_datetimes_equal(p_contact_last_activity(contact), last_activity)) {
         p_contact_set_last_activity(contact, last_activity);
     }
     p_contact_set_presence(contact, resource);
-    Jid *jid = jid_create_from_bare_and_resource(barejid, resource->name);
-    autocomplete_add(fulljid_ac, jid->fulljid);
-    jid_destroy(jid);
+    _entry_index_presence(entry);
+    char *fulljid = create_fulljid(barejid, resource->name);
+    autocomplete_add(fulljid_ac, fulljid);
+    free(fulljid);
 
     return TRUE;
 }
@@ -109,41 +143,38 @@ roster_update_presence(const char * const barejid, Resource *resource,
 PContact
 roster_get_contact(const char * const barejid)
 {
-    return g_hash_table_lookup(contacts, barejid);
+    RosterEntry *entry = g_hash_table_lookup(contacts, barejid);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    return entry->contact;
 }
 
 gboolean
 roster_contact_offline(const char * const barejid,
     const char * const resource, const char * const status)
 {
-    PContact contact = g_hash_table_lookup(contacts, barejid);
+    RosterEntry *entry = g_hash_table_lookup(contacts, barejid);
 
-    if (contact == NULL) {
+    if (entry == NULL) {
         return FALSE;
     }
     if (resource == NULL) {
         return TRUE;
     } else {
-        gboolean result = p_contact_remove_resource(contact, resource);
+        gboolean result = p_contact_remove_resource(entry->contact, resource);
         if (result == TRUE) {
-            Jid *jid = jid_create_from_bare_and_resource(barejid, resource);
-            autocomplete_remove(fulljid_ac, jid->fulljid);
-            jid_destroy(jid);
+            _entry_index_presence(entry);
+            char *fulljid = create_fulljid(barejid, resource);
+            autocomplete_remove(fulljid_ac, fulljid);
+            free(fulljid);
         }
 
         return result;
     }
 }
 
-void
-roster_reset_search_attempts(void)
-{
-    autocomplete_reset(name_ac);
-    autocomplete_reset(barejid_ac);
-    autocomplete_reset(fulljid_ac);
-    autocomplete_reset(groups_ac);
-}
-
 void
 roster_init(void)
 {
@@ -151,8 +182,10 @@ roster_init(void)
     barejid_ac = autocomplete_new();
     fulljid_ac = autocomplete_new();
     groups_ac = autocomplete_new();
-    contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, g_free,
-        (GDestroyNotify)p_contact_free);
+    _indices_create();
+    // keyed on the contacts' own interned barejids
+    contacts = g_hash_table_new_full(g_str_hash, (GEqualFunc)_key_equals, NULL,
+        (GDestroyNotify)_entry_free);
     name_to_barejid = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
         g_free);
 }
@@ -164,6 +197,11 @@ roster_free(void)
     autocomplete_free(barejid_ac);
     autocomplete_free(fulljid_ac);
     autocomplete_free(groups_ac);
+    _indices_destroy();
+    g_hash_table_destroy(contacts);
+    contacts = NULL;
+    g_hash_table_destroy(name_to_barejid);
+    name_to_barejid = NULL;
 }
 
 void
@@ -180,6 +218,11 @@ roster_change_name(PContact contact, const char * const new_name)
 
     p_contact_set_name(contact, new_name);
     _replace_name(current_name, new_name, barejid);
+
+    RosterEntry *entry = g_hash_table_lookup(contacts, barejid);
+    if (entry != NULL) {
+        _entry_index_name(entry);
+    }
 }
 
 void
@@ -204,7 +247,7 @@ roster_remove(const char * const name, const char * const barejid)
         g_list_free(resources);
     }
 
-    // remove the contact
+    // remove the contact, and its index entries
     g_hash_table_remove(contacts, barejid);
 }
 
@@ -212,8 +255,9 @@ void
 roster_update(const char * const barejid, const char * const name,
     GSList *groups, const char * const subscription, gboolean pending_out)
 {
-    PContact contact = g_hash_table_lookup(contacts, barejid);
-    assert(contact != NULL);
+    RosterEntry *entry = g_hash_table_lookup(contacts, barejid);
+    assert(entry != NULL);
+    PContact contact = entry->contact;
 
     p_contact_set_subscription(contact, subscription);
     p_contact_set_pending_out(contact, pending_out);
@@ -227,6 +271,8 @@ roster_update(const char * const barejid, const char * const name,
     p_contact_set_name(contact, new_name);
     p_contact_set_groups(contact, groups);
     _replace_name(current_name, new_name, barejid);
+    _entry_index_name(entry);
+    _entry_index_groups(entry);
 
     // add groups
     while (groups != NULL) {
@@ -239,12 +285,12 @@ gboolean
 roster_add(const char * const barejid, const char * const name, GSList *groups,
     const char * const subscription, gboolean pending_out)
 {
-    PContact contact = g_hash_table_lookup(contacts, barejid);
-    if (contact != NULL) {
+    RosterEntry *entry = g_hash_table_lookup(contacts, barejid);
+    if (entry != NULL) {
         return FALSE;
     }
 
-    contact = p_contact_new(barejid, name, groups, subscription, NULL,
+    PContact contact = p_contact_new(barejid, name, groups, subscription, NULL,
         pending_out);
 
     // add groups
@@ -253,7 +299,7 @@ roster_add(const char * const barejid, const char * const name, GSList *groups,
         groups = g_slist_next(groups);
     }
 
-    g_hash_table_insert(contacts, strdup(barejid), contact);
+    g_hash_table_insert(contacts, (gpointer)p_contact_barejid(contact), _entry_new(contact));
     autocomplete_add(barejid_ac, barejid);
     _add_name_and_barejid(name, barejid);
 
@@ -273,56 +319,19 @@ roster_barejid_from_name(const char * const name)
 GSList *
 roster_get_contacts_by_presence(const char * const presence)
 {
-    GSList *result = NULL;
-    GHashTableIter iter;
-    gpointer key;
-    gpointer value;
-
-    g_hash_table_iter_init(&iter, contacts);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        PContact contact = (PContact)value;
-        if (g_strcmp0(p_contact_presence(contact), presence) == 0) {
-            result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
-        }
-    }
-
-    // resturn all contact structs
-    return result;
+    return _index_to_list(g_hash_table_lookup(index_by_presence, presence));
 }
 
 GSList *
 roster_get_contacts(void)
 {
-    GSList *result = NULL;
-    GHashTableIter iter;
-    gpointer key;
-    gpointer value;
-
-    g_hash_table_iter_init(&iter, contacts);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
-    }
-
-    // resturn all contact structs
-    return result;
+    return _index_to_list(index_all);
 }
 
 GSList *
 roster_get_contacts_online(void)
 {
-    GSList *result = NULL;
-    GHashTableIter iter;
-    gpointer key;
-    gpointer value;
-
-    g_hash_table_iter_init(&iter, contacts);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        if(strcmp(p_contact_presence(value), "offline"))
-            result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
-    }
-
-    // resturn all contact structs
-    return result;
+    return _index_to_list(index_online);
 }
 
 gboolean
@@ -334,8 +343,8 @@ roster_has_pending_subscriptions(void)
 
     g_hash_table_iter_init(&iter, contacts);
     while (g_hash_table_iter_next(&iter, &key, &value)) {
-        PContact contact = (PContact) value;
-        if (p_contact_pending_out(contact)) {
+        RosterEntry *entry = (RosterEntry *) value;
+        if (p_contact_pending_out(entry->contact)) {
             return TRUE;
         }
     }
@@ -349,6 +358,12 @@ roster_contact_autocomplete(char *search_str)
     return autocomplete_complete(name_ac, search_str, TRUE);
 }
 
+char *
+roster_contact_fuzzy_autocomplete(char *search_str)
+{
+    return autocomplete_complete_fuzzy(name_ac, search_str, TRUE, _contact_weight);
+}
+
 char *
 roster_fulljid_autocomplete(char *search_str)
 {
@@ -358,45 +373,13 @@ roster_fulljid_autocomplete(char *search_str)
 GSList *
 roster_get_nogroup(void)
 {
-    GSList *result = NULL;
-    GHashTableIter iter;
-    gpointer key;
-    gpointer value;
-
-    g_hash_table_iter_init(&iter, contacts);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        GSList *groups = p_contact_groups(value);
-        if (groups == NULL) {
-            result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
-        }
-    }
-
-    // resturn all contact structs
-    return result;
+    return _index_to_list(index_nogroup);
 }
 
 GSList *
 roster_get_group(const char * const group)
 {
-    GSList *result = NULL;
-    GHashTableIter iter;
-    gpointer key;
-    gpointer value;
-
-    g_hash_table_iter_init(&iter, contacts);
-    while (g_hash_table_iter_next(&iter, &key, &value)) {
-        GSList *groups = p_contact_groups(value);
-        while (groups != NULL) {
-            if (strcmp(groups->data, group) == 0) {
-                result = g_slist_insert_sorted(result, value, (GCompareFunc)_compare_contacts);
-                break;
-            }
-            groups = g_slist_next(groups);
-        }
-    }
-
-    // resturn all contact structs
-    return result;
+    return _index_to_list(g_hash_table_lookup(index_by_group, group));
 }
 
 GSList *
@@ -469,30 +452,221 @@ _add_name_and_barejid(const char * const name, const char * const barejid)
     }
 }
 
-static
-gint _compare_contacts(PContact a, PContact b)
+static void
+_indices_create(void)
+{
+    index_all = g_sequence_new(NULL);
+    index_online = g_sequence_new(NULL);
+    index_nogroup = g_sequence_new(NULL);
+    index_by_presence = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        (GDestroyNotify)g_sequence_free);
+    index_by_group = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify)g_sequence_free);
+}
+
+static void
+_indices_destroy(void)
 {
-    const char * utf8_str_a = NULL;
-    const char * utf8_str_b = NULL;
+    g_sequence_free(index_all);
+    index_all = NULL;
+    g_sequence_free(index_online);
+    index_online = NULL;
+    g_sequence_free(index_nogroup);
+    index_nogroup = NULL;
+    g_hash_table_destroy(index_by_presence);
+    index_by_presence = NULL;
+    g_hash_table_destroy(index_by_group);
+    index_by_group = NULL;
+}
 
-    if (p_contact_name(a) != NULL) {
-        utf8_str_a = p_contact_name(a);
+static gchar *
+_entry_collate_key(PContact contact)
+{
+    if (p_contact_name(contact) != NULL) {
+        return g_utf8_collate_key(p_contact_name(contact), -1);
     } else {
-        utf8_str_a = p_contact_barejid(a);
+        return g_utf8_collate_key(p_contact_barejid(contact), -1);
     }
-    if (p_contact_name(b) != NULL) {
-        utf8_str_b = p_contact_name(b);
-    } else {
-        utf8_str_b = p_contact_barejid(b);
+}
+
+static RosterEntry *
+_entry_new(PContact contact)
+{
+    RosterEntry *entry = malloc(sizeof(RosterEntry));
+    entry->contact = contact;
+    entry->collate_key = _entry_collate_key(contact);
+    entry->presence = NULL;
+    entry->presence_iter = NULL;
+    entry->online_iter = NULL;
+    entry->nogroup_iter = NULL;
+    entry->group_iters = NULL;
+
+    entry->all_iter = g_sequence_insert_sorted(index_all, entry,
+        (GCompareDataFunc)_compare_entries, NULL);
+    _entry_index_presence(entry);
+    _entry_index_groups(entry);
+
+    return entry;
+}
+
+static void
+_entry_free(RosterEntry *entry)
+{
+    if (entry != NULL) {
+        // no positions to remove when the indices have gone with the whole roster
+        if (index_all != NULL) {
+            g_sequence_remove(entry->all_iter);
+            if (entry->presence_iter != NULL) {
+                g_sequence_remove(entry->presence_iter);
+            }
+            if (entry->online_iter != NULL) {
+                g_sequence_remove(entry->online_iter);
+            }
+            if (entry->nogroup_iter != NULL) {
+                g_sequence_remove(entry->nogroup_iter);
+            }
+            GSList *curr = entry->group_iters;
+            while (curr != NULL) {
+                g_sequence_remove(curr->data);
+                curr = g_slist_next(curr);
+            }
+        }
+        g_slist_free(entry->group_iters);
+        g_free(entry->collate_key);
+        p_contact_free(entry->contact);
+        free(entry);
     }
+}
 
-    gchar *key_a = g_utf8_collate_key(utf8_str_a, -1);
-    gchar *key_b = g_utf8_collate_key(utf8_str_b, -1);
+static void
+_entry_index_presence(RosterEntry *entry)
+{
+    const char *presence = p_contact_presence(entry->contact);
+    if (entry->presence_iter != NULL && g_strcmp0(presence, entry->presence) == 0) {
+        return;
+    }
 
-    gint result = g_strcmp0(key_a, key_b);
+    if (entry->presence_iter != NULL) {
+        g_sequence_remove(entry->presence_iter);
+    }
+    GSequence *presence_index = g_hash_table_lookup(index_by_presence, presence);
+    if (presence_index == NULL) {
+        presence_index = g_sequence_new(NULL);
+        g_hash_table_insert(index_by_presence, (gpointer)presence, presence_index);
+    }
+    entry->presence = presence;
+    entry->presence_iter = g_sequence_insert_sorted(presence_index, entry,
+        (GCompareDataFunc)_compare_entries, NULL);
+
+    gboolean online = g_strcmp0(presence, "offline") != 0;
+    if (online && entry->online_iter == NULL) {
+        entry->online_iter = g_sequence_insert_sorted(index_online, entry,
+            (GCompareDataFunc)_compare_entries, NULL);
+    } else if (!online && entry->online_iter != NULL) {
+        g_sequence_remove(entry->online_iter);
+        entry->online_iter = NULL;
+    }
+}
 
-    g_free(key_a);
-    g_free(key_b);
+static void
+_entry_index_groups(RosterEntry *entry)
+{
+    if (entry->nogroup_iter != NULL) {
+        g_sequence_remove(entry->nogroup_iter);
+        entry->nogroup_iter = NULL;
+    }
+    GSList *curr = entry->group_iters;
+    while (curr != NULL) {
+        g_sequence_remove(curr->data);
+        curr = g_slist_next(curr);
+    }
+    g_slist_free(entry->group_iters);
+    entry->group_iters = NULL;
+
+    GSList *groups = p_contact_groups(entry->contact);
+    if (groups == NULL) {
+        entry->nogroup_iter = g_sequence_insert_sorted(index_nogroup, entry,
+            (GCompareDataFunc)_compare_entries, NULL);
+        return;
+    }
+
+    while (groups != NULL) {
+        GSequence *group_index = g_hash_table_lookup(index_by_group, groups->data);
+        if (group_index == NULL) {
+            group_index = g_sequence_new(NULL);
+            g_hash_table_insert(index_by_group, g_strdup(groups->data), group_index);
+        }
+        GSequenceIter *iter = g_sequence_insert_sorted(group_index, entry,
+            (GCompareDataFunc)_compare_entries, NULL);
+        entry->group_iters = g_slist_prepend(entry->group_iters, iter);
+        groups = g_slist_next(groups);
+    }
+}
+
+static void
+_entry_index_name(RosterEntry *entry)
+{
+    gchar *collate_key = _entry_collate_key(entry->contact);
+    if (g_strcmp0(collate_key, entry->collate_key) == 0) {
+        g_free(collate_key);
+        return;
+    }
+    g_free(entry->collate_key);
+    entry->collate_key = collate_key;
+
+    g_sequence_sort_changed(entry->all_iter, (GCompareDataFunc)_compare_entries, NULL);
+    g_sequence_sort_changed(entry->presence_iter, (GCompareDataFunc)_compare_entries, NULL);
+    if (entry->online_iter != NULL) {
+        g_sequence_sort_changed(entry->online_iter, (GCompareDataFunc)_compare_entries, NULL);
+    }
+    if (entry->nogroup_iter != NULL) {
+        g_sequence_sort_changed(entry->nogroup_iter, (GCompareDataFunc)_compare_entries, NULL);
+    }
+    GSList *curr = entry->group_iters;
+    while (curr != NULL) {
+        g_sequence_sort_changed(curr->data, (GCompareDataFunc)_compare_entries, NULL);
+        curr = g_slist_next(curr);
+    }
+}
+
+static GSList *
+_index_to_list(GSequence *index)
+{
+    GSList *result = NULL;
+    if (index == NULL) {
+        return result;
+    }
+
+    // build from the end so each prepend is constant time
+    GSequenceIter *iter = g_sequence_get_end_iter(index);
+    while (!g_sequence_iter_is_begin(iter)) {
+        iter = g_sequence_iter_prev(iter);
+        RosterEntry *entry = g_sequence_get(iter);
+        result = g_slist_prepend(result, entry->contact);
+    }
 
     return result;
 }
+
+static gint
+_compare_entries(RosterEntry *a, RosterEntry *b, gpointer data)
+{
+    gint result = g_strcmp0(a->collate_key, b->collate_key);
+    if (result == 0) {
+        result = g_strcmp0(p_contact_barejid(a->contact), p_contact_barejid(b->contact));
+    }
+
+    return result;
+}
+
+// name autocomplete holds names, or the barejid for contacts with no name
+static int
+_contact_weight(const char * const name)
+{
+    const char *barejid = g_hash_table_lookup(name_to_barejid, name);
+    if (barejid) {
+        return frecency_score(barejid);
+    } else {
+        return frecency_score(name);
+    }
+}
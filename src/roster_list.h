@@ -46,7 +46,6 @@ gboolean roster_update_presence(const char * const barejid, Resource *resource,
 PContact roster_get_contact(const char * const barejid);
 gboolean roster_contact_offline(const char * const barejid,
     const char * const resource, const char * const status);
-void roster_reset_search_attempts(void);
 void roster_init(void);
 void roster_free(void);
 void roster_change_name(PContact contact, const char * const new_name);
@@ -60,6 +59,7 @@ GSList * roster_get_contacts(void);
 GSList * roster_get_contacts_online(void);
 gboolean roster_has_pending_subscriptions(void);
 char * roster_contact_autocomplete(char *search_str);
+char * roster_contact_fuzzy_autocomplete(char *search_str);
 char * roster_fulljid_autocomplete(char *search_str);
 GSList * roster_get_group(const char * const group);
 GSList * roster_get_groups(void);
@@ -43,6 +43,7 @@
 #include "config/preferences.h"
 #include "config/account.h"
 #include "roster_list.h"
+#include "command/command.h"
 
 #ifdef HAVE_LIBOTR
 #include "otr/otr.h"
@@ -51,6 +52,8 @@
 
 #include "ui/ui.h"
 
+static void _room_history_flush(const char * const room);
+
 void
 handle_room_join_error(const char * const room, const char * const err)
 {
@@ -104,6 +107,9 @@ handle_login_account_success(char *account_name)
     otr_on_connect(account);
 #endif
 
+    cmd_history_load(account_name);
+    muc_history_load(account_name);
+
     ui_handle_login_account_success(account);
 
     // attempt to rejoin rooms with passwords
@@ -263,6 +269,9 @@ handle_room_broadcast(const char *const room_jid,
 void
 handle_room_subject(const char * const room, const char * const nick, const char * const subject)
 {
+    // the subject follows any discussion history
+    _room_history_flush(room);
+
     muc_set_subject(room, subject);
     if (muc_roster_complete(room)) {
         ui_room_subject(room, nick, subject);
@@ -273,19 +282,34 @@ void
 handle_room_history(const char * const room_jid, const char * const nick,
     GTimeVal tv_stamp, const char * const message)
 {
-    ui_room_history(room_jid, nick, tv_stamp, message);
+    // ignore history up to the last seen, for servers that ignore since
+    GTimeVal last_seen;
+    if (muc_last_seen(room_jid, &last_seen)) {
+        gint64 stamp = ((gint64)tv_stamp.tv_sec * G_USEC_PER_SEC) + tv_stamp.tv_usec;
+        gint64 seen = ((gint64)last_seen.tv_sec * G_USEC_PER_SEC) + last_seen.tv_usec;
+        if (stamp <= seen) {
+            return;
+        }
+    }
+
+    muc_set_last_seen(room_jid, &tv_stamp);
+    muc_pending_history_add(room_jid, nick, tv_stamp, message);
+    if (muc_pending_history_count(room_jid) >= MUC_HISTORY_BATCH_MAX) {
+        _room_history_flush(room_jid);
+    }
 }
 
 void
 handle_room_message(const char * const room_jid, const char * const nick,
     const char * const message)
 {
+    _room_history_flush(room_jid);
+    muc_set_last_seen_now(room_jid);
+
     ui_room_message(room_jid, nick, message);
 
     if (prefs_get_boolean(PREF_GRLOG)) {
-        Jid *jid = jid_create(jabber_get_fulljid());
-        groupchat_log_chat(jid->barejid, room_jid, nick, message);
-        jid_destroy(jid);
+        groupchat_log_chat(jabber_get_barejid(), room_jid, nick, message);
     }
 }
 
@@ -340,18 +364,15 @@ handle_incoming_message(char *barejid, char *message)
     ui_incoming_msg(barejid, newmessage, NULL);
 
     if (prefs_get_boolean(PREF_CHLOG)) {
-        const char *jid = jabber_get_fulljid();
-        Jid *jidp = jid_create(jid);
+        const char *my_barejid = jabber_get_barejid();
 
         char *pref_otr_log = prefs_get_string(PREF_OTR_LOG);
         if (!was_decrypted || (strcmp(pref_otr_log, "on") == 0)) {
-            chat_log_chat(jidp->barejid, barejid, newmessage, PROF_IN_LOG, NULL);
+            chat_log_chat(my_barejid, barejid, newmessage, PROF_IN_LOG, NULL);
         } else if (strcmp(pref_otr_log, "redact") == 0) {
-            chat_log_chat(jidp->barejid, barejid, "[redacted]", PROF_IN_LOG, NULL);
+            chat_log_chat(my_barejid, barejid, "[redacted]", PROF_IN_LOG, NULL);
         }
         prefs_free_string(pref_otr_log);
-
-        jid_destroy(jidp);
     }
 
     otr_free_message(newmessage);
@@ -359,10 +380,7 @@ handle_incoming_message(char *barejid, char *message)
     ui_incoming_msg(barejid, message, NULL);
 
     if (prefs_get_boolean(PREF_CHLOG)) {
-        const char *jid = jabber_get_fulljid();
-        Jid *jidp = jid_create(jid);
-        chat_log_chat(jidp->barejid, barejid, message, PROF_IN_LOG, NULL);
-        jid_destroy(jidp);
+        chat_log_chat(jabber_get_barejid(), barejid, message, PROF_IN_LOG, NULL);
     }
 #endif
 }
@@ -379,10 +397,7 @@ handle_delayed_message(char *barejid, char *message, GTimeVal tv_stamp)
     ui_incoming_msg(barejid, message, &tv_stamp);
 
     if (prefs_get_boolean(PREF_CHLOG)) {
-        const char *jid = jabber_get_fulljid();
-        Jid *jidp = jid_create(jid);
-        chat_log_chat(jidp->barejid, barejid, message, PROF_IN_LOG, &tv_stamp);
-        jid_destroy(jidp);
+        chat_log_chat(jabber_get_barejid(), barejid, message, PROF_IN_LOG, &tv_stamp);
     }
 }
 
@@ -428,14 +443,14 @@ handle_subscription(const char *barejid, jabber_subscr_t type)
 }
 
 void
-handle_contact_offline(char *barejid, char *resource, char *status)
+handle_contact_offline(const char * const barejid, const char * const resource,
+    const char * const status)
 {
     gboolean updated = roster_contact_offline(barejid, resource, status);
 
     if (resource != NULL && updated) {
         char *show_console = prefs_get_string(PREF_STATUSES_CONSOLE);
         char *show_chat_win = prefs_get_string(PREF_STATUSES_CHAT);
-        Jid *jid = jid_create_from_bare_and_resource(barejid, resource);
         PContact contact = roster_get_contact(barejid);
         if (p_contact_subscription(contact) != NULL) {
             if (strcmp(p_contact_subscription(contact), "none") != 0) {
@@ -461,7 +476,6 @@ handle_contact_offline(char *barejid, char *resource, char *status)
         }
         prefs_free_string(show_console);
         prefs_free_string(show_chat_win);
-        jid_destroy(jid);
     }
 
     rosterwin_roster();
@@ -646,6 +660,20 @@ handle_autoping_cancel(void)
 {
     prefs_set_autoping(0);
     cons_show_error("Server ping not supported, autoping disabled.");
+    ui_update_ping_rtt(-1);
+}
+
+void
+handle_autoping_pong(const int millis)
+{
+    ui_update_ping_rtt(millis);
+}
+
+void
+handle_autoping_timeout(const int seconds)
+{
+    cons_show_error("Server did not respond to ping within %d seconds, closing connection.", seconds);
+    ui_update_ping_rtt(-1);
 }
 
 void
@@ -816,4 +844,14 @@ handle_muc_occupant_online(const char * const room, const char * const nick, con
         }
         occupantswin_occupants(room);
     }
-}
\ No newline at end of file
+}
+
+static void
+_room_history_flush(const char * const room)
+{
+    GList *history = muc_pending_history(room);
+    if (history != NULL) {
+        ui_room_history_batch(room, history);
+        muc_pending_history_clear(room);
+    }
+}
@@ -76,7 +76,8 @@ void handle_delayed_private_message(char *fulljid, char *message, GTimeVal tv_st
 void handle_typing(char *from);
 void handle_gone(const char * const from);
 void handle_subscription(const char *from, jabber_subscr_t type);
-void handle_contact_offline(char *contact, char *resource, char *status);
+void handle_contact_offline(const char * const contact, const char * const resource,
+    const char * const status);
 void handle_contact_online(char *contact, Resource *resource,
     GDateTime *last_activity);
 void handle_leave_room(const char * const room);
@@ -98,6 +99,8 @@ void handle_group_remove(const char * const contact,
 void handle_roster_remove(const char * const barejid);
 void handle_roster_add(const char * const barejid, const char * const name);
 void handle_autoping_cancel(void);
+void handle_autoping_pong(const int millis);
+void handle_autoping_timeout(const int seconds);
 void handle_message_error(const char * const from, const char * const type,
     const char * const err_msg);
 void handle_presence_error(const char *from, const char * const type,
@@ -40,21 +40,90 @@
 #include "tools/autocomplete.h"
 #include "tools/parser.h"
 
+// compressed radix trie node, the edge into the node is labelled with one or more bytes
+typedef struct ac_node_t {
+    char *label;
+    gboolean terminal;
+    struct ac_node_t **children;    // ordered by the first byte of their labels
+    int num_children;
+} AcNode;
+
 struct autocomplete_t {
-    GSList *items;
-    GSList *last_found;
+    AcNode *root;
+    gint length;
+    gchar *last_found;
     gchar *search_str;
+    GPtrArray *ranked;
+    guint ranked_pos;
+    guint generation;
+    // items owned elsewhere in strcmp order, used instead of the trie, NULL for a trie
+    GPtrArray *borrowed;
+    GDestroyNotify release_func;
 };
 
-static gchar * _search_from(Autocomplete ac, GSList *curr, gboolean quote);
+typedef struct ac_match_t {
+    int score;
+    int weight;
+    char *item;
+} AcMatch;
+
+// search state older than the current generation belongs to a finished search
+static guint generation = 0;
+
+static AcNode * _node_new(const char * const label, int len, gboolean terminal);
+static void _node_free(AcNode *node);
+static int _node_child_index(AcNode *node, unsigned char first);
+static void _node_insert_child(AcNode *node, AcNode *child);
+static void _node_remove_child(AcNode *node, int index);
+static void _node_merge_child(AcNode *node);
+static gboolean _trie_add(AcNode *root, const char *item);
+static gboolean _trie_remove(AcNode *node, const char *item);
+static AcNode * _trie_find(AcNode *root, const char *item);
+static gboolean _trie_next(AcNode *node, GString *key, const char * const prefix, int prefix_len,
+    const char * const after);
+static void _trie_list(AcNode *node, GString *key, GSList **list);
+static gchar * _search_from(Autocomplete ac, const char * const after, gboolean quote);
+static void _check_generation(Autocomplete ac);
+static int _fuzzy_score(const char * const item, const char * const search_str);
+static void _trie_rank(AcNode *node, GString *key, const char * const search_str,
+    autocomplete_weight_func weight_func, GArray *matches);
+static int _compare_matches(AcMatch *a, AcMatch *b);
+static gchar * _quote_item(const char * const item, gboolean quote);
+static void _rank_item(const char * const item, const char * const search_str,
+    autocomplete_weight_func weight_func, GArray *matches);
+static gboolean _borrowed_find(Autocomplete ac, const char * const item, guint *index);
+static const char * _borrowed_next(Autocomplete ac, const char * const prefix,
+    const char * const after);
+static void _borrowed_release_all(Autocomplete ac);
 
 Autocomplete
 autocomplete_new(void)
 {
     Autocomplete new = malloc(sizeof(struct autocomplete_t));
-    new->items = NULL;
+    new->root = _node_new("", 0, FALSE);
+    new->length = 0;
     new->last_found = NULL;
     new->search_str = NULL;
+    new->ranked = NULL;
+    new->ranked_pos = 0;
+    new->generation = generation;
+    new->borrowed = NULL;
+    new->release_func = NULL;
+
+    return new;
+}
+
+/*
+ * Items are not copied, each must stay valid until it is removed, release_func
+ * if any is called on an item when the autocompleter lets go of it, including
+ * an item added twice
+ */
+Autocomplete
+autocomplete_new_borrowed(GDestroyNotify release_func)
+{
+    Autocomplete new = autocomplete_new();
+    new->borrowed = g_ptr_array_new();
+    new->release_func = release_func;
 
     return new;
 }
@@ -63,8 +132,14 @@ void
 autocomplete_clear(Autocomplete ac)
 {
     if (ac) {
-        g_slist_free_full(ac->items, free);
-        ac->items = NULL;
+        if (ac->borrowed) {
+            _borrowed_release_all(ac);
+            g_ptr_array_set_size(ac->borrowed, 0);
+        } else {
+            _node_free(ac->root);
+            ac->root = _node_new("", 0, FALSE);
+        }
+        ac->length = 0;
 
         autocomplete_reset(ac);
     }
@@ -73,8 +148,25 @@ autocomplete_clear(Autocomplete ac)
 void
 autocomplete_reset(Autocomplete ac)
 {
-    ac->last_found = NULL;
+    FREE_SET_NULL(ac->last_found);
     FREE_SET_NULL(ac->search_str);
+    if (ac->ranked) {
+        g_ptr_array_free(ac->ranked, TRUE);
+        ac->ranked = NULL;
+    }
+    ac->ranked_pos = 0;
+}
+
+void
+autocomplete_reset_all(void)
+{
+    generation++;
+}
+
+guint
+autocomplete_generation(void)
+{
+    return generation;
 }
 
 void
@@ -82,6 +174,10 @@ autocomplete_free(Autocomplete ac)
 {
     if (ac) {
         autocomplete_clear(ac);
+        _node_free(ac->root);
+        if (ac->borrowed) {
+            g_ptr_array_free(ac->borrowed, TRUE);
+        }
         free(ac);
     }
 }
@@ -91,27 +187,31 @@ autocomplete_length(Autocomplete ac)
 {
     if (!ac) {
         return 0;
-    } else if (!ac->items) {
-        return 0;
     } else {
-        return g_slist_length(ac->items);
+        return ac->length;
     }
 }
 
 void
 autocomplete_add(Autocomplete ac, const char *item)
 {
-    if (ac) {
-        char *item_cpy;
-        GSList *curr = g_slist_find_custom(ac->items, item, (GCompareFunc)strcmp);
-
-        // if item already exists
-        if (curr) {
+    if (ac && ac->borrowed) {
+        guint index;
+        if (_borrowed_find(ac, item, &index)) {
+            if (ac->release_func) {
+                ac->release_func((gpointer)item);
+            }
             return;
         }
-
-        item_cpy = strdup(item);
-        ac->items = g_slist_insert_sorted(ac->items, item_cpy, (GCompareFunc)strcmp);
+        g_ptr_array_add(ac->borrowed, NULL);
+        gpointer *items = ac->borrowed->pdata;
+        memmove(&items[index + 1], &items[index], sizeof(gpointer) * (ac->borrowed->len - 1 - index));
+        items[index] = (gpointer)item;
+        ac->length++;
+    } else if (ac) {
+        if (_trie_add(ac->root, item)) {
+            ac->length++;
+        }
     }
 
     return;
@@ -121,19 +221,41 @@ void
 autocomplete_remove(Autocomplete ac, const char * const item)
 {
     if (ac) {
-        GSList *curr = g_slist_find_custom(ac->items, item, (GCompareFunc)strcmp);
-
-        if (!curr) {
+        gpointer borrowed_item = NULL;
+        if (ac->borrowed) {
+            guint index;
+            if (!_borrowed_find(ac, item, &index)) {
+                return;
+            }
+            borrowed_item = g_ptr_array_remove_index(ac->borrowed, index);
+        } else if (!_trie_remove(ac->root, item)) {
             return;
         }
+        ac->length--;
+
+        // reset last found if it is the item removed
+        if (ac->last_found && strcmp(ac->last_found, item) == 0) {
+            FREE_SET_NULL(ac->last_found);
+        }
 
-        // reset last found if it points to the item to be removed
-        if (ac->last_found == curr) {
-            ac->last_found = NULL;
+        // drop it from the ranked matches being cycled through
+        if (ac->ranked) {
+            guint i;
+            for (i = 0; i < ac->ranked->len; i++) {
+                if (strcmp(g_ptr_array_index(ac->ranked, i), item) == 0) {
+                    g_ptr_array_remove_index(ac->ranked, i);
+                    if (ac->ranked_pos > i) {
+                        ac->ranked_pos--;
+                    }
+                    break;
+                }
+            }
         }
 
-        free(curr->data);
-        ac->items = g_slist_delete_link(ac->items, curr);
+        // the item may be the one borrowed, so released last
+        if (borrowed_item && ac->release_func) {
+            ac->release_func(borrowed_item);
+        }
     }
 
     return;
@@ -143,29 +265,29 @@ GSList *
 autocomplete_create_list(Autocomplete ac)
 {
     GSList *copy = NULL;
-    GSList *curr = ac->items;
-
-    while(curr) {
-        copy = g_slist_append(copy, strdup(curr->data));
-        curr = g_slist_next(curr);
+    if (ac->borrowed) {
+        guint i;
+        for (i = 0; i < ac->borrowed->len; i++) {
+            copy = g_slist_prepend(copy, strdup(g_ptr_array_index(ac->borrowed, i)));
+        }
+    } else {
+        GString *key = g_string_new("");
+        _trie_list(ac->root, key, &copy);
+        g_string_free(key, TRUE);
     }
 
-    return copy;
+    return g_slist_reverse(copy);
 }
 
 gboolean
 autocomplete_contains(Autocomplete ac, const char *value)
 {
-    GSList *curr = ac->items;
-
-    while(curr) {
-        if (strcmp(curr->data, value) == 0) {
-            return TRUE;
-        }
-        curr = g_slist_next(curr);
+    if (ac->borrowed) {
+        guint index;
+        return _borrowed_find(ac, value, &index);
     }
 
-    return FALSE;
+    return (_trie_find(ac->root, value) != NULL);
 }
 
 gchar *
@@ -178,8 +300,10 @@ autocomplete_complete(Autocomplete ac, gchar *search_str, gboolean quote)
         return NULL;
     }
 
+    _check_generation(ac);
+
     // no items to search
-    if (!ac->items) {
+    if (ac->length == 0) {
         return NULL;
     }
 
@@ -190,20 +314,20 @@ autocomplete_complete(Autocomplete ac, gchar *search_str, gboolean quote)
         }
 
         ac->search_str = strdup(search_str);
-        found = _search_from(ac, ac->items, quote);
+        found = _search_from(ac, NULL, quote);
 
         return found;
 
     // subsequent search attempt
     } else {
-        // search from here+1 to end
-        found = _search_from(ac, g_slist_next(ac->last_found), quote);
+        // search from after the last found item to the end
+        found = _search_from(ac, ac->last_found, quote);
         if (found) {
             return found;
         }
 
         // search from beginning
-        found = _search_from(ac, ac->items, quote);
+        found = _search_from(ac, NULL, quote);
         if (found) {
             return found;
         }
@@ -215,6 +339,63 @@ autocomplete_complete(Autocomplete ac, gchar *search_str, gboolean quote)
     }
 }
 
+gchar *
+autocomplete_complete_fuzzy(Autocomplete ac, gchar *search_str, gboolean quote,
+    autocomplete_weight_func weight_func)
+{
+    // no autocomplete to search
+    if (!ac) {
+        return NULL;
+    }
+
+    _check_generation(ac);
+
+    // no items to search
+    if (ac->length == 0) {
+        return NULL;
+    }
+
+    // first search attempt, rank every match once
+    if (!ac->ranked) {
+        GArray *matches = g_array_new(FALSE, FALSE, sizeof(AcMatch));
+        if (ac->borrowed) {
+            guint i;
+            for (i = 0; i < ac->borrowed->len; i++) {
+                _rank_item(g_ptr_array_index(ac->borrowed, i), search_str, weight_func, matches);
+            }
+        } else {
+            GString *key = g_string_new("");
+            _trie_rank(ac->root, key, search_str, weight_func, matches);
+            g_string_free(key, TRUE);
+        }
+
+        g_array_sort(matches, (GCompareFunc)_compare_matches);
+
+        ac->ranked = g_ptr_array_new_with_free_func(free);
+        guint i;
+        for (i = 0; i < matches->len; i++) {
+            g_ptr_array_add(ac->ranked, g_array_index(matches, AcMatch, i).item);
+        }
+        g_array_free(matches, TRUE);
+        ac->ranked_pos = 0;
+    }
+
+    // we found nothing, reset search
+    if (ac->ranked->len == 0) {
+        autocomplete_reset(ac);
+        return NULL;
+    }
+
+    // subsequent search attempts cycle through the ranked matches
+    if (ac->ranked_pos >= ac->ranked->len) {
+        ac->ranked_pos = 0;
+    }
+    char *found = g_ptr_array_index(ac->ranked, ac->ranked_pos);
+    ac->ranked_pos++;
+
+    return _quote_item(found, quote);
+}
+
 char *
 autocomplete_param_with_func(char *input, int *size, char *command,
     autocomplete_func func)
@@ -319,36 +500,464 @@ autocomplete_param_no_with_func(char *input, int *size, char *command,
     return NULL;
 }
 
+static void
+_check_generation(Autocomplete ac)
+{
+    if (ac->generation != generation) {
+        autocomplete_reset(ac);
+        ac->generation = generation;
+    }
+}
+
+// first item in order prefixed with the search string and after the given item, NULL for from the start
+static gchar *
+_search_from(Autocomplete ac, const char * const after, gboolean quote)
+{
+    if (ac->borrowed) {
+        const char *found = _borrowed_next(ac, ac->search_str, after);
+        if (found == NULL) {
+            return NULL;
+        }
+
+        // copied, the item may go before the search moves on
+        free(ac->last_found);
+        ac->last_found = strdup(found);
+
+        return _quote_item(found, quote);
+    }
+
+    GString *key = g_string_new("");
+    gboolean matched = _trie_next(ac->root, key, ac->search_str, strlen(ac->search_str), after);
+    if (!matched) {
+        g_string_free(key, TRUE);
+        return NULL;
+    }
+
+    // set last found
+    free(ac->last_found);
+    ac->last_found = strdup(key->str);
+
+    gchar *result = _quote_item(key->str, quote);
+    g_string_free(key, TRUE);
+
+    return result;
+}
+
+// if contains space, quote before returning
 static gchar *
-_search_from(Autocomplete ac, GSList *curr, gboolean quote)
+_quote_item(const char * const item, gboolean quote)
+{
+    if (quote && strchr(item, ' ')) {
+        GString *quoted = g_string_new("\"");
+        g_string_append(quoted, item);
+        g_string_append(quoted, "\"");
+        gchar *result = strdup(quoted->str);
+        g_string_free(quoted, TRUE);
+
+        return result;
+    } else {
+        return strdup(item);
+    }
+}
+
+/*
+ * Score the item if it contains the characters of the search string in
+ * order, ignoring case, -1 otherwise. Runs of consecutive characters, matches
+ * at the start of words and whole prefixes score higher.
+ */
+static int
+_fuzzy_score(const char * const item, const char * const search_str)
+{
+    int score = 0;
+    int last_match = -2;
+    int i = 0;
+    const char *curr_search = search_str;
+
+    while (*curr_search && item[i]) {
+        if (g_ascii_tolower(item[i]) == g_ascii_tolower(*curr_search)) {
+            score++;
+            if (last_match == i - 1) {
+                score += 3;
+            }
+            if (i == 0 || strchr(" .@-_/", item[i - 1])) {
+                score += 5;
+            }
+            last_match = i;
+            curr_search++;
+        }
+        i++;
+    }
+
+    if (*curr_search) {
+        return -1;
+    }
+
+    if (g_ascii_strncasecmp(item, search_str, strlen(search_str)) == 0) {
+        score += 20;
+    }
+
+    return score;
+}
+
+static void
+_trie_rank(AcNode *node, GString *key, const char * const search_str,
+    autocomplete_weight_func weight_func, GArray *matches)
+{
+    gsize start = key->len;
+    g_string_append(key, node->label);
+
+    if (node->terminal) {
+        _rank_item(key->str, search_str, weight_func, matches);
+    }
+
+    int i;
+    for (i = 0; i < node->num_children; i++) {
+        _trie_rank(node->children[i], key, search_str, weight_func, matches);
+    }
+
+    g_string_truncate(key, start);
+}
+
+static void
+_rank_item(const char * const item, const char * const search_str,
+    autocomplete_weight_func weight_func, GArray *matches)
+{
+    int score = _fuzzy_score(item, search_str);
+    if (score != -1) {
+        AcMatch match;
+        match.score = score;
+        match.weight = weight_func ? weight_func(item) : 0;
+        match.item = strdup(item);
+        g_array_append_val(matches, match);
+    }
+}
+
+// the weight only orders equally good matches
+static int
+_compare_matches(AcMatch *a, AcMatch *b)
+{
+    if (a->score != b->score) {
+        return b->score - a->score;
+    } else if (a->weight != b->weight) {
+        return b->weight - a->weight;
+    } else {
+        return strcmp(a->item, b->item);
+    }
+}
+
+static AcNode *
+_node_new(const char * const label, int len, gboolean terminal)
+{
+    AcNode *node = malloc(sizeof(AcNode));
+    node->label = strndup(label, len);
+    node->terminal = terminal;
+    node->children = NULL;
+    node->num_children = 0;
+
+    return node;
+}
+
+static void
+_node_free(AcNode *node)
+{
+    if (node) {
+        int i;
+        for (i = 0; i < node->num_children; i++) {
+            _node_free(node->children[i]);
+        }
+        free(node->children);
+        free(node->label);
+        free(node);
+    }
+}
+
+static int
+_node_child_index(AcNode *node, unsigned char first)
+{
+    int i;
+    for (i = 0; i < node->num_children; i++) {
+        if ((unsigned char)node->children[i]->label[0] == first) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void
+_node_insert_child(AcNode *node, AcNode *child)
+{
+    unsigned char first = child->label[0];
+    int pos = 0;
+    while (pos < node->num_children && (unsigned char)node->children[pos]->label[0] < first) {
+        pos++;
+    }
+
+    node->children = realloc(node->children, sizeof(AcNode*) * (node->num_children + 1));
+    memmove(&node->children[pos + 1], &node->children[pos], sizeof(AcNode*) * (node->num_children - pos));
+    node->children[pos] = child;
+    node->num_children++;
+}
+
+static void
+_node_remove_child(AcNode *node, int index)
 {
-    while(curr) {
+    _node_free(node->children[index]);
+    memmove(&node->children[index], &node->children[index + 1],
+        sizeof(AcNode*) * (node->num_children - index - 1));
+    node->num_children--;
+    if (node->num_children == 0) {
+        FREE_SET_NULL(node->children);
+    }
+}
 
-        // match found
-        if (strncmp(curr->data, ac->search_str, strlen(ac->search_str)) == 0) {
+// fold a non terminal node's only child into it
+static void
+_node_merge_child(AcNode *node)
+{
+    AcNode *child = node->children[0];
 
-            // set pointer to last found
-            ac->last_found = curr;
+    gchar *label = g_strconcat(node->label, child->label, NULL);
+    free(node->label);
+    node->label = strdup(label);
+    g_free(label);
 
-            // if contains space, quote before returning
-            if (quote && g_strrstr(curr->data, " ")) {
-                GString *quoted = g_string_new("\"");
-                g_string_append(quoted, curr->data);
-                g_string_append(quoted, "\"");
+    free(node->children);
+    node->children = child->children;
+    node->num_children = child->num_children;
+    node->terminal = child->terminal;
 
-                gchar *result = quoted->str;
-                g_string_free(quoted, FALSE);
+    free(child->label);
+    free(child);
+}
 
-                return result;
+static gboolean
+_trie_add(AcNode *root, const char *item)
+{
+    AcNode *node = root;
+    const char *rest = item;
 
-            // otherwise just return the string
-            } else {
-                return strdup(curr->data);
+    while (TRUE) {
+        if (*rest == '\0') {
+            if (node->terminal) {
+                return FALSE;
             }
+            node->terminal = TRUE;
+            return TRUE;
         }
 
-        curr = g_slist_next(curr);
+        int index = _node_child_index(node, *rest);
+        if (index == -1) {
+            _node_insert_child(node, _node_new(rest, strlen(rest), TRUE));
+            return TRUE;
+        }
+
+        AcNode *child = node->children[index];
+        int common = 0;
+        while (child->label[common] && child->label[common] == rest[common]) {
+            common++;
+        }
+
+        // split the edge where the item leaves it
+        if (child->label[common]) {
+            AcNode *mid = _node_new(child->label, common, FALSE);
+            char *suffix = strdup(&child->label[common]);
+            free(child->label);
+            child->label = suffix;
+            _node_insert_child(mid, child);
+            node->children[index] = mid;
+            child = mid;
+        }
+
+        node = child;
+        rest = &rest[common];
+    }
+}
+
+static gboolean
+_trie_remove(AcNode *node, const char *item)
+{
+    if (*item == '\0') {
+        if (!node->terminal) {
+            return FALSE;
+        }
+        node->terminal = FALSE;
+        return TRUE;
+    }
+
+    int index = _node_child_index(node, *item);
+    if (index == -1) {
+        return FALSE;
+    }
+
+    AcNode *child = node->children[index];
+    size_t label_len = strlen(child->label);
+    if (strncmp(child->label, item, label_len) != 0) {
+        return FALSE;
+    }
+
+    if (!_trie_remove(child, &item[label_len])) {
+        return FALSE;
+    }
+
+    // keep the trie compressed
+    if (!child->terminal && child->num_children == 0) {
+        _node_remove_child(node, index);
+    } else if (!child->terminal && child->num_children == 1) {
+        _node_merge_child(child);
+    }
+
+    return TRUE;
+}
+
+static AcNode *
+_trie_find(AcNode *root, const char *item)
+{
+    AcNode *node = root;
+    const char *rest = item;
+
+    while (*rest) {
+        int index = _node_child_index(node, *rest);
+        if (index == -1) {
+            return NULL;
+        }
+        node = node->children[index];
+        size_t label_len = strlen(node->label);
+        if (strncmp(node->label, rest, label_len) != 0) {
+            return NULL;
+        }
+        rest = &rest[label_len];
+    }
+
+    if (node->terminal) {
+        return node;
+    } else {
+        return NULL;
+    }
+}
+
+/*
+ * Depth first in byte order, which is strcmp order, appending labels to key.
+ * Finds the first item starting with prefix that sorts after the given item,
+ * or any when after is NULL, leaving it in key.
+ */
+static gboolean
+_trie_next(AcNode *node, GString *key, const char * const prefix, int prefix_len,
+    const char * const after)
+{
+    gsize start = key->len;
+    g_string_append(key, node->label);
+
+    // subtree can't match the prefix
+    int cmp_len = MIN((int)key->len, prefix_len);
+    if (strncmp(key->str, prefix, cmp_len) != 0) {
+        g_string_truncate(key, start);
+        return FALSE;
+    }
+
+    const char *next_after = after;
+    if (after) {
+        int cmp = strncmp(key->str, after, key->len);
+
+        // whole subtree sorts before the item
+        if (cmp < 0) {
+            g_string_truncate(key, start);
+            return FALSE;
+
+        // whole subtree sorts after the item
+        } else if (cmp > 0) {
+            next_after = NULL;
+        }
+    }
+
+    // key is a prefix of after, or equal to it, so not after it
+    if (node->terminal && (int)key->len >= prefix_len && !next_after) {
+        return TRUE;
+    }
+
+    int i;
+    for (i = 0; i < node->num_children; i++) {
+        if (_trie_next(node->children[i], key, prefix, prefix_len, next_after)) {
+            return TRUE;
+        }
+    }
+
+    g_string_truncate(key, start);
+    return FALSE;
+}
+
+static void
+_trie_list(AcNode *node, GString *key, GSList **list)
+{
+    gsize start = key->len;
+    g_string_append(key, node->label);
+
+    if (node->terminal) {
+        *list = g_slist_prepend(*list, strdup(key->str));
+    }
+
+    int i;
+    for (i = 0; i < node->num_children; i++) {
+        _trie_list(node->children[i], key, list);
+    }
+
+    g_string_truncate(key, start);
+}
+
+// binary search, index is where the item is or would be inserted
+static gboolean
+_borrowed_find(Autocomplete ac, const char * const item, guint *index)
+{
+    guint low = 0;
+    guint high = ac->borrowed->len;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        int cmp = strcmp(g_ptr_array_index(ac->borrowed, mid), item);
+        if (cmp == 0) {
+            *index = mid;
+            return TRUE;
+        } else if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    *index = low;
+    return FALSE;
+}
+
+// first item in order prefixed with prefix and after the given item, NULL for from the start
+static const char *
+_borrowed_next(Autocomplete ac, const char * const prefix, const char * const after)
+{
+    guint index;
+    _borrowed_find(ac, prefix, &index);
+    if (after) {
+        guint after_index;
+        if (_borrowed_find(ac, after, &after_index)) {
+            after_index++;
+        }
+        index = MAX(index, after_index);
+    }
+
+    if (index < ac->borrowed->len) {
+        const char *item = g_ptr_array_index(ac->borrowed, index);
+        if (strncmp(item, prefix, strlen(prefix)) == 0) {
+            return item;
+        }
     }
 
     return NULL;
 }
+
+static void
+_borrowed_release_all(Autocomplete ac)
+{
+    if (ac->release_func) {
+        guint i;
+        for (i = 0; i < ac->borrowed->len; i++) {
+            ac->release_func(g_ptr_array_index(ac->borrowed, i));
+        }
+    }
+}
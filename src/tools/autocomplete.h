@@ -38,11 +38,16 @@
 #include <glib.h>
 
 typedef char*(*autocomplete_func)(char *);
+typedef int(*autocomplete_weight_func)(const char * const);
 typedef struct autocomplete_t *Autocomplete;
 
 // allocate new autocompleter with no items
 Autocomplete autocomplete_new(void);
 
+// allocate an autocompleter that keeps pointers to items owned elsewhere
+// instead of copying them
+Autocomplete autocomplete_new_borrowed(GDestroyNotify release_func);
+
 // Remove all items from the autocompleter
 void autocomplete_clear(Autocomplete ac);
 
@@ -55,6 +60,11 @@ void autocomplete_remove(Autocomplete ac, const char * const item);
 // find the next item prefixed with search string
 gchar * autocomplete_complete(Autocomplete ac, gchar *search_str, gboolean quote);
 
+// find the next item containing the search string characters in order,
+// best matches first, equally good matches by highest weight
+gchar * autocomplete_complete_fuzzy(Autocomplete ac, gchar *search_str, gboolean quote,
+    autocomplete_weight_func weight_func);
+
 GSList * autocomplete_create_list(Autocomplete ac);
 gint autocomplete_length(Autocomplete ac);
 
@@ -69,5 +79,11 @@ char * autocomplete_param_no_with_func(char *input, int *size, char *command,
 
 void autocomplete_reset(Autocomplete ac);
 
+// end the current search of every autocompleter, each resets on its next use
+void autocomplete_reset_all(void);
+
+// changes each time autocomplete_reset_all is called
+guint autocomplete_generation(void);
+
 gboolean autocomplete_contains(Autocomplete ac, const char *value);
 #endif
@@ -0,0 +1,342 @@
+/*
+ * filewriter.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "log.h"
+#include "tools/filewriter.h"
+
+struct filewriter_t {
+    gchar *path;
+    filewriter_func serialise;
+    gdouble delay;
+    GTimer *timer;
+    gboolean changed;
+    gchar *written;
+};
+
+typedef struct write_job_t {
+    FileWriter writer;
+    gchar *path;
+    gchar *data;
+    gsize length;
+    int error;
+} WriteJob;
+
+static GSList *writers = NULL;
+
+// jobs go to the writer thread on one queue and come back on the other
+static GThread *thread = NULL;
+static GAsyncQueue *jobs = NULL;
+static GAsyncQueue *done = NULL;
+static int queued = 0;
+
+static gpointer _writer_thread(gpointer data);
+static int _write_atomic(const char * const path, const gchar * const data, gsize length);
+static void _queue_write(FileWriter writer);
+static void _job_done(WriteJob *job);
+static void _job_free(WriteJob *job);
+
+void
+filewriter_init(void)
+{
+#if !GLIB_CHECK_VERSION(2,32,0)
+    if (!g_thread_supported()) {
+        g_thread_init(NULL);
+    }
+#endif
+    jobs = g_async_queue_new();
+    done = g_async_queue_new();
+#if GLIB_CHECK_VERSION(2,32,0)
+    thread = g_thread_try_new("filewriter", _writer_thread, NULL, NULL);
+#else
+    thread = g_thread_create(_writer_thread, NULL, TRUE, NULL);
+#endif
+    if (thread == NULL) {
+        log_error("Could not start file writer thread, writing files in place");
+        g_async_queue_unref(jobs);
+        g_async_queue_unref(done);
+        jobs = NULL;
+        done = NULL;
+    }
+}
+
+void
+filewriter_shutdown(void)
+{
+    GSList *curr = writers;
+    while (curr) {
+        filewriter_flush(curr->data);
+        curr = g_slist_next(curr);
+    }
+
+    if (thread) {
+        // a job without a path stops the thread
+        WriteJob *stop = g_new0(WriteJob, 1);
+        g_async_queue_push(jobs, stop);
+        g_thread_join(thread);
+        thread = NULL;
+
+        WriteJob *job;
+        while ((job = g_async_queue_try_pop(done)) != NULL) {
+            _job_free(job);
+        }
+        g_async_queue_unref(jobs);
+        g_async_queue_unref(done);
+        jobs = NULL;
+        done = NULL;
+        queued = 0;
+    }
+}
+
+/*
+ * The file as it is on disk is taken as already written, so nothing is
+ * written until the contents change
+ */
+FileWriter
+filewriter_new(const char * const path, filewriter_func serialise, guint delay_ms)
+{
+    FileWriter writer = malloc(sizeof(struct filewriter_t));
+    writer->path = g_strdup(path);
+    writer->serialise = serialise;
+    writer->delay = delay_ms / 1000.0;
+    writer->timer = g_timer_new();
+    writer->changed = FALSE;
+    writer->written = NULL;
+    g_file_get_contents(path, &writer->written, NULL, NULL);
+
+    writers = g_slist_append(writers, writer);
+
+    return writer;
+}
+
+void
+filewriter_free(FileWriter writer)
+{
+    if (writer) {
+        filewriter_flush(writer);
+        writers = g_slist_remove(writers, writer);
+        g_free(writer->path);
+        g_timer_destroy(writer->timer);
+        g_free(writer->written);
+        free(writer);
+    }
+}
+
+void
+filewriter_changed(FileWriter writer)
+{
+    if (writer && !writer->changed) {
+        writer->changed = TRUE;
+        g_timer_start(writer->timer);
+    }
+}
+
+void
+filewriter_flush(FileWriter writer)
+{
+    if (writer && writer->changed) {
+        _queue_write(writer);
+    }
+
+    while (queued > 0) {
+        _job_done(g_async_queue_pop(done));
+    }
+}
+
+void
+filewriter_tick(void)
+{
+    GSList *curr = writers;
+    while (curr) {
+        FileWriter writer = curr->data;
+        if (writer->changed && g_timer_elapsed(writer->timer, NULL) >= writer->delay) {
+            _queue_write(writer);
+        }
+        curr = g_slist_next(curr);
+    }
+
+    if (done) {
+        WriteJob *job;
+        while ((job = g_async_queue_try_pop(done)) != NULL) {
+            _job_done(job);
+        }
+    }
+}
+
+/*
+ * Write the contents now, in place, readable only by the user
+ */
+gboolean
+filewriter_write(const char * const path, const gchar * const data, gsize length)
+{
+    int error = _write_atomic(path, data, length);
+    if (error != 0) {
+        log_error("Could not write %s: %s", path, g_strerror(error));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+_queue_write(FileWriter writer)
+{
+    writer->changed = FALSE;
+
+    gsize length = 0;
+    gchar *data = writer->serialise(&length);
+    if (data == NULL) {
+        return;
+    }
+
+    // a change that was undone, or a setting set to what it already was
+    if (writer->written && strcmp(writer->written, data) == 0) {
+        g_free(data);
+        return;
+    }
+
+    g_free(writer->written);
+    writer->written = g_strdup(data);
+
+    WriteJob *job = g_new0(WriteJob, 1);
+    job->writer = writer;
+    job->path = g_strdup(writer->path);
+    job->data = data;
+    job->length = length;
+
+    if (thread) {
+        queued++;
+        g_async_queue_push(jobs, job);
+    } else {
+        job->error = _write_atomic(job->path, job->data, job->length);
+        _job_done(job);
+    }
+}
+
+static void
+_job_done(WriteJob *job)
+{
+    if (thread) {
+        queued--;
+    }
+
+    if (job->error != 0) {
+        log_error("Could not write %s: %s", job->path, g_strerror(job->error));
+
+        // try again with the next change
+        g_free(job->writer->written);
+        job->writer->written = NULL;
+    }
+
+    _job_free(job);
+}
+
+static void
+_job_free(WriteJob *job)
+{
+    g_free(job->path);
+    g_free(job->data);
+    g_free(job);
+}
+
+static gpointer
+_writer_thread(gpointer data)
+{
+    while (TRUE) {
+        WriteJob *job = g_async_queue_pop(jobs);
+        if (job->path == NULL) {
+            _job_free(job);
+            return NULL;
+        }
+
+        job->error = _write_atomic(job->path, job->data, job->length);
+        g_async_queue_push(done, job);
+    }
+}
+
+/*
+ * Write to a private temporary file next to the target and rename it over
+ * the target, return 0 or the errno of the failed step
+ */
+static int
+_write_atomic(const char * const path, const gchar * const data, gsize length)
+{
+    gchar *tmp_path = g_strdup_printf("%s.XXXXXX", path);
+    int fd = g_mkstemp_full(tmp_path, O_WRONLY, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        int error = errno;
+        g_free(tmp_path);
+        return error;
+    }
+
+    int error = 0;
+    gsize written = 0;
+    while (written < length) {
+        ssize_t res = write(fd, data + written, length - written);
+        if (res == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = errno;
+            break;
+        }
+        written += res;
+    }
+
+    if (error == 0 && fsync(fd) == -1) {
+        error = errno;
+    }
+    if (close(fd) == -1 && error == 0) {
+        error = errno;
+    }
+    if (error == 0 && g_rename(tmp_path, path) == -1) {
+        error = errno;
+    }
+    if (error != 0) {
+        g_unlink(tmp_path);
+    }
+
+    g_free(tmp_path);
+    return error;
+}
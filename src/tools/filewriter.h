@@ -0,0 +1,65 @@
+/*
+ * filewriter.h
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#ifndef FILEWRITER_H
+#define FILEWRITER_H
+
+#include <glib.h>
+
+typedef struct filewriter_t *FileWriter;
+
+// return the whole file contents, freed with g_free
+typedef gchar* (*filewriter_func)(gsize *length);
+
+// start and stop the background writer, without it files are written in place
+void filewriter_init(void);
+void filewriter_shutdown(void);
+
+FileWriter filewriter_new(const char * const path, filewriter_func serialise, guint delay_ms);
+void filewriter_free(FileWriter writer);
+
+// schedule a write of the current contents once the delay has passed
+void filewriter_changed(FileWriter writer);
+
+// write any scheduled contents now and wait until they are on disk
+void filewriter_flush(FileWriter writer);
+
+// called from the main loop, queue due writes and collect finished ones
+void filewriter_tick(void);
+
+// write a file now, atomically and readable only by the user
+gboolean filewriter_write(const char * const path, const gchar * const data, gsize length);
+
+#endif
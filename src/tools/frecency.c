@@ -0,0 +1,270 @@
+/*
+ * frecency.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "tools/filewriter.h"
+#include "tools/frecency.h"
+
+#define DAY_USEC ((gint64)G_USEC_PER_SEC * 60 * 60 * 24)
+#define COUNT_MAX 100
+// targets not messaged for this long are forgotten
+#define AGE_MAX (180 * DAY_USEC)
+// above this many targets the lowest scoring is forgotten
+#define TARGETS_MAX 500
+#define SAVE_DELAY_MS 5000
+
+typedef struct frecency_entry_t {
+    int count;
+    gint64 last_used;
+} FrecencyEntry;
+
+static GHashTable *targets = NULL;
+static FileWriter frecency_writer = NULL;
+
+static gint64 _now(void);
+static int _recency_weight(gint64 last_used, gint64 now);
+static int _score(FrecencyEntry *entry, gint64 now);
+static void _prune(gint64 now);
+static gchar * _serialise_frecency(gsize *length);
+static gchar * _get_frecency_file(void);
+
+void
+frecency_init(void)
+{
+    targets = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+}
+
+void
+frecency_close(void)
+{
+    // writes anything still pending
+    filewriter_free(frecency_writer);
+    frecency_writer = NULL;
+    if (targets) {
+        g_hash_table_destroy(targets);
+        targets = NULL;
+    }
+}
+
+void
+frecency_record(const char * const target)
+{
+    if (!targets || !target) {
+        return;
+    }
+
+    gint64 now = _now();
+    FrecencyEntry *entry = g_hash_table_lookup(targets, target);
+    if (!entry) {
+        if (g_hash_table_size(targets) >= TARGETS_MAX) {
+            _prune(now);
+        }
+        entry = malloc(sizeof(FrecencyEntry));
+        entry->count = 0;
+        g_hash_table_insert(targets, strdup(target), entry);
+    }
+
+    if (entry->count < COUNT_MAX) {
+        entry->count++;
+    }
+    entry->last_used = now;
+
+    filewriter_changed(frecency_writer);
+}
+
+int
+frecency_score(const char * const target)
+{
+    if (!targets || !target) {
+        return 0;
+    }
+
+    FrecencyEntry *entry = g_hash_table_lookup(targets, target);
+    if (!entry) {
+        return 0;
+    }
+
+    return _score(entry, _now());
+}
+
+void
+frecency_load(void)
+{
+    if (!targets) {
+        return;
+    }
+
+    gchar *frecency_loc = _get_frecency_file();
+    GKeyFile *frecency = g_key_file_new();
+    g_key_file_load_from_file(frecency, frecency_loc, G_KEY_FILE_NONE, NULL);
+
+    gsize len = 0;
+    gchar **saved_targets = g_key_file_get_groups(frecency, &len);
+    gsize i;
+    for (i = 0; i < len; i++) {
+        int count = g_key_file_get_integer(frecency, saved_targets[i], "count", NULL);
+        gchar *stamp = g_key_file_get_string(frecency, saved_targets[i], "last", NULL);
+        GTimeVal tv_stamp;
+        if (count > 0 && stamp != NULL && g_time_val_from_iso8601(stamp, &tv_stamp)) {
+            FrecencyEntry *entry = malloc(sizeof(FrecencyEntry));
+            entry->count = MIN(count, COUNT_MAX);
+            entry->last_used = (gint64)tv_stamp.tv_sec * G_USEC_PER_SEC + tv_stamp.tv_usec;
+            g_hash_table_replace(targets, strdup(saved_targets[i]), entry);
+        }
+        g_free(stamp);
+    }
+
+    g_strfreev(saved_targets);
+    g_key_file_free(frecency);
+    _prune(_now());
+
+    // later changes are written behind
+    filewriter_free(frecency_writer);
+    frecency_writer = filewriter_new(frecency_loc, _serialise_frecency, SAVE_DELAY_MS);
+    g_free(frecency_loc);
+}
+
+static gint64
+_now(void)
+{
+    GTimeVal tv_now;
+    g_get_current_time(&tv_now);
+
+    return (gint64)tv_now.tv_sec * G_USEC_PER_SEC + tv_now.tv_usec;
+}
+
+// recent use counts for more, older use fades but never to nothing
+static int
+_recency_weight(gint64 last_used, gint64 now)
+{
+    gint64 age = now - last_used;
+    if (age < 4 * DAY_USEC) {
+        return 100;
+    } else if (age < 14 * DAY_USEC) {
+        return 70;
+    } else if (age < 31 * DAY_USEC) {
+        return 50;
+    } else if (age < 90 * DAY_USEC) {
+        return 30;
+    } else {
+        return 10;
+    }
+}
+
+static int
+_score(FrecencyEntry *entry, gint64 now)
+{
+    return entry->count * _recency_weight(entry->last_used, now) / 10;
+}
+
+/*
+ * Forget targets not used for AGE_MAX, then the lowest scoring until there
+ * is room for a new target
+ */
+static void
+_prune(gint64 now)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, targets);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        FrecencyEntry *entry = value;
+        if (now - entry->last_used > AGE_MAX) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+
+    while (g_hash_table_size(targets) >= TARGETS_MAX) {
+        gpointer lowest = NULL;
+        int lowest_score = G_MAXINT;
+        gint64 lowest_used = G_MAXINT64;
+        g_hash_table_iter_init(&iter, targets);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            FrecencyEntry *entry = value;
+            int score = _score(entry, now);
+            if (score < lowest_score || (score == lowest_score && entry->last_used < lowest_used)) {
+                lowest = key;
+                lowest_score = score;
+                lowest_used = entry->last_used;
+            }
+        }
+        g_hash_table_remove(targets, lowest);
+    }
+}
+
+static gchar *
+_serialise_frecency(gsize *length)
+{
+    GKeyFile *frecency = g_key_file_new();
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, targets);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        FrecencyEntry *entry = value;
+        GTimeVal tv_stamp;
+        tv_stamp.tv_sec = entry->last_used / G_USEC_PER_SEC;
+        tv_stamp.tv_usec = entry->last_used % G_USEC_PER_SEC;
+        gchar *stamp_str = g_time_val_to_iso8601(&tv_stamp);
+        g_key_file_set_integer(frecency, key, "count", entry->count);
+        g_key_file_set_string(frecency, key, "last", stamp_str);
+        g_free(stamp_str);
+    }
+
+    gchar *result = g_key_file_to_data(frecency, length, NULL);
+    g_key_file_free(frecency);
+
+    return result;
+}
+
+static gchar *
+_get_frecency_file(void)
+{
+    gchar *xdg_data = xdg_get_data_home();
+    GString *frecency_file = g_string_new(xdg_data);
+    g_string_append(frecency_file, "/profanity/frecency");
+    gchar *result = strdup(frecency_file->str);
+    g_free(xdg_data);
+    g_string_free(frecency_file, TRUE);
+
+    return result;
+}
@@ -0,0 +1,380 @@
+/*
+ * highlight.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "tools/highlight.h"
+
+/*
+ * Words are matched with an Aho-Corasick automaton over the UTF-8 bytes of
+ * the lower cased text, so one pass over a message finds every word, regular
+ * expressions are only tried for kinds the words did not already match.
+ */
+
+typedef struct highlight_node_t {
+    gint child;
+    gint sibling;
+    gint fail;
+    gint pattern;   // pattern ending at this node, -1 for none
+    gint output;    // nearest node on the fail chain with a pattern, -1 for none
+    guchar byte;
+} HighlightNode;
+
+typedef struct highlight_pattern_t {
+    int kinds;
+    guint length;           // in characters
+    gboolean word_start;    // starts with a word character, needs a boundary before it
+    gboolean word_end;      // ends with a word character, needs a boundary after it
+} HighlightPattern;
+
+typedef struct highlight_regex_t {
+    GRegex *regex;
+    highlight_kind_t kind;
+} HighlightRegex;
+
+struct highlight_t {
+    GArray *nodes;
+    GArray *patterns;
+    GSList *regexes;
+    gboolean compiled;
+    int word_kinds;
+    int regex_kinds;
+    guint max_length;
+    gboolean *word_ring;    // whether each of the last max_length + 1 characters was a word character
+};
+
+static gint _highlight_node_new(Highlight hl, gint parent, guchar byte);
+static gint _highlight_child(Highlight hl, gint node, guchar byte);
+static gint _highlight_next(Highlight hl, gint node, guchar byte);
+static void _highlight_compile(Highlight hl);
+static gboolean _highlight_word_char(gunichar ch);
+static void _highlight_regex_free(HighlightRegex *hl_regex);
+
+Highlight
+highlight_new(void)
+{
+    Highlight hl = malloc(sizeof(struct highlight_t));
+    hl->nodes = g_array_new(FALSE, FALSE, sizeof(HighlightNode));
+    hl->patterns = g_array_new(FALSE, FALSE, sizeof(HighlightPattern));
+    hl->regexes = NULL;
+    hl->compiled = FALSE;
+    hl->word_kinds = HIGHLIGHT_NONE;
+    hl->regex_kinds = HIGHLIGHT_NONE;
+    hl->max_length = 0;
+    hl->word_ring = NULL;
+
+    // root
+    _highlight_node_new(hl, -1, 0);
+
+    return hl;
+}
+
+void
+highlight_free(Highlight hl)
+{
+    if (hl) {
+        g_array_free(hl->nodes, TRUE);
+        g_array_free(hl->patterns, TRUE);
+        g_slist_free_full(hl->regexes, (GDestroyNotify)_highlight_regex_free);
+        free(hl->word_ring);
+        free(hl);
+    }
+}
+
+void
+highlight_add_word(Highlight hl, const char * const word, highlight_kind_t kind)
+{
+    if (!word || !g_utf8_validate(word, -1, NULL) || word[0] == '\0') {
+        return;
+    }
+
+    gint node = 0;
+    guint length = 0;
+    gunichar first = 0;
+    gunichar last = 0;
+    const char *curr = word;
+    while (*curr) {
+        gunichar ch = g_unichar_tolower(g_utf8_get_char(curr));
+        gchar folded[6];
+        gint len = g_unichar_to_utf8(ch, folded);
+        gint i;
+        for (i = 0; i < len; i++) {
+            gint child = _highlight_child(hl, node, folded[i]);
+            if (child == -1) {
+                child = _highlight_node_new(hl, node, folded[i]);
+            }
+            node = child;
+        }
+
+        if (length == 0) {
+            first = ch;
+        }
+        last = ch;
+        length++;
+        curr = g_utf8_next_char(curr);
+    }
+
+    HighlightNode *end = &g_array_index(hl->nodes, HighlightNode, node);
+    if (end->pattern == -1) {
+        HighlightPattern pattern;
+        pattern.kinds = kind;
+        pattern.length = length;
+        pattern.word_start = _highlight_word_char(first);
+        pattern.word_end = _highlight_word_char(last);
+        g_array_append_val(hl->patterns, pattern);
+        end->pattern = hl->patterns->len - 1;
+    } else {
+        g_array_index(hl->patterns, HighlightPattern, end->pattern).kinds |= kind;
+    }
+
+    if (length > hl->max_length) {
+        hl->max_length = length;
+    }
+    hl->word_kinds |= kind;
+    hl->compiled = FALSE;
+}
+
+gboolean
+highlight_add_regex(Highlight hl, const char * const pattern, highlight_kind_t kind)
+{
+    GRegex *regex = g_regex_new(pattern, G_REGEX_CASELESS | G_REGEX_OPTIMIZE, 0, NULL);
+    if (!regex) {
+        return FALSE;
+    }
+
+    HighlightRegex *hl_regex = malloc(sizeof(HighlightRegex));
+    hl_regex->regex = regex;
+    hl_regex->kind = kind;
+    hl->regexes = g_slist_append(hl->regexes, hl_regex);
+    hl->regex_kinds |= kind;
+
+    return TRUE;
+}
+
+int
+highlight_match(Highlight hl, const char * const text)
+{
+    if (!text) {
+        return HIGHLIGHT_NONE;
+    }
+
+    if (!hl->compiled) {
+        _highlight_compile(hl);
+    }
+
+    int found = HIGHLIGHT_NONE;
+    int all_kinds = hl->word_kinds | hl->regex_kinds;
+
+    if (hl->patterns->len > 0) {
+        guint ring_size = hl->max_length + 1;
+        int pending = HIGHLIGHT_NONE;   // matched, waiting for a boundary after the word
+        guint index = 0;                // characters seen
+        gint state = 0;
+
+        const char *curr = text;
+        while (*curr && found != all_kinds) {
+            gunichar ch = g_utf8_get_char_validated(curr, -1);
+            const char *next;
+            if (ch == (gunichar)-1 || ch == (gunichar)-2) {
+                ch = (guchar)*curr;
+                next = curr + 1;
+            } else {
+                next = g_utf8_next_char(curr);
+            }
+
+            gboolean word_char = _highlight_word_char(ch);
+            if (pending && !word_char) {
+                found |= pending;
+            }
+            pending = HIGHLIGHT_NONE;
+
+            gchar folded[6];
+            gint len = g_unichar_to_utf8(g_unichar_tolower(ch), folded);
+            gint i;
+            for (i = 0; i < len; i++) {
+                state = _highlight_next(hl, state, folded[i]);
+            }
+            hl->word_ring[index % ring_size] = word_char;
+
+            HighlightNode *node = &g_array_index(hl->nodes, HighlightNode, state);
+            gint out = node->pattern != -1 ? state : node->output;
+            while (out != -1) {
+                HighlightNode *out_node = &g_array_index(hl->nodes, HighlightNode, out);
+                HighlightPattern *pattern = &g_array_index(hl->patterns, HighlightPattern, out_node->pattern);
+
+                // character before the match must not continue the word
+                gboolean start_ok = TRUE;
+                if (pattern->word_start && index >= pattern->length) {
+                    start_ok = !hl->word_ring[(index - pattern->length) % ring_size];
+                }
+
+                if (start_ok) {
+                    if (pattern->word_end) {
+                        pending |= pattern->kinds;
+                    } else {
+                        found |= pattern->kinds;
+                    }
+                }
+                out = out_node->output;
+            }
+
+            index++;
+            curr = next;
+        }
+
+        // end of text is a boundary
+        found |= pending;
+    }
+
+    GSList *curr_regex = hl->regexes;
+    while (curr_regex && found != all_kinds) {
+        HighlightRegex *hl_regex = curr_regex->data;
+        if (!(found & hl_regex->kind) && g_regex_match(hl_regex->regex, text, 0, NULL)) {
+            found |= hl_regex->kind;
+        }
+        curr_regex = g_slist_next(curr_regex);
+    }
+
+    return found;
+}
+
+static gint
+_highlight_node_new(Highlight hl, gint parent, guchar byte)
+{
+    HighlightNode node;
+    node.child = -1;
+    node.sibling = -1;
+    node.fail = 0;
+    node.pattern = -1;
+    node.output = -1;
+    node.byte = byte;
+    g_array_append_val(hl->nodes, node);
+
+    gint index = hl->nodes->len - 1;
+    if (parent != -1) {
+        HighlightNode *parent_node = &g_array_index(hl->nodes, HighlightNode, parent);
+        HighlightNode *new_node = &g_array_index(hl->nodes, HighlightNode, index);
+        new_node->sibling = parent_node->child;
+        parent_node->child = index;
+    }
+
+    return index;
+}
+
+static gint
+_highlight_child(Highlight hl, gint node, guchar byte)
+{
+    gint child = g_array_index(hl->nodes, HighlightNode, node).child;
+    while (child != -1) {
+        HighlightNode *child_node = &g_array_index(hl->nodes, HighlightNode, child);
+        if (child_node->byte == byte) {
+            return child;
+        }
+        child = child_node->sibling;
+    }
+
+    return -1;
+}
+
+static gint
+_highlight_next(Highlight hl, gint node, guchar byte)
+{
+    while (TRUE) {
+        gint child = _highlight_child(hl, node, byte);
+        if (child != -1) {
+            return child;
+        }
+        if (node == 0) {
+            return 0;
+        }
+        node = g_array_index(hl->nodes, HighlightNode, node).fail;
+    }
+}
+
+// breadth first, so every node's fail target is complete before its children are visited
+static void
+_highlight_compile(Highlight hl)
+{
+    GQueue *queue = g_queue_new();
+
+    gint child = g_array_index(hl->nodes, HighlightNode, 0).child;
+    while (child != -1) {
+        HighlightNode *child_node = &g_array_index(hl->nodes, HighlightNode, child);
+        child_node->fail = 0;
+        child_node->output = -1;
+        g_queue_push_tail(queue, GINT_TO_POINTER(child));
+        child = child_node->sibling;
+    }
+
+    while (!g_queue_is_empty(queue)) {
+        gint node = GPOINTER_TO_INT(g_queue_pop_head(queue));
+        gint node_fail = g_array_index(hl->nodes, HighlightNode, node).fail;
+
+        child = g_array_index(hl->nodes, HighlightNode, node).child;
+        while (child != -1) {
+            guchar byte = g_array_index(hl->nodes, HighlightNode, child).byte;
+            gint fail = _highlight_next(hl, node_fail, byte);
+            HighlightNode *fail_node = &g_array_index(hl->nodes, HighlightNode, fail);
+            gint output = fail_node->pattern != -1 ? fail : fail_node->output;
+
+            HighlightNode *child_node = &g_array_index(hl->nodes, HighlightNode, child);
+            child_node->fail = fail;
+            child_node->output = output;
+            g_queue_push_tail(queue, GINT_TO_POINTER(child));
+            child = child_node->sibling;
+        }
+    }
+
+    g_queue_free(queue);
+
+    free(hl->word_ring);
+    hl->word_ring = calloc(hl->max_length + 1, sizeof(gboolean));
+    hl->compiled = TRUE;
+}
+
+static gboolean
+_highlight_word_char(gunichar ch)
+{
+    return g_unichar_isalnum(ch) || ch == '_';
+}
+
+static void
+_highlight_regex_free(HighlightRegex *hl_regex)
+{
+    g_regex_unref(hl_regex->regex);
+    free(hl_regex);
+}
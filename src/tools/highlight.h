@@ -0,0 +1,63 @@
+/*
+ * highlight.h
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef HIGHLIGHT_H
+#define HIGHLIGHT_H
+
+#include <glib.h>
+
+typedef enum {
+    HIGHLIGHT_NONE      = 0,
+    HIGHLIGHT_NICK      = 1 << 0,
+    HIGHLIGHT_KEYWORD   = 1 << 1
+} highlight_kind_t;
+
+typedef struct highlight_t *Highlight;
+
+// allocate a new matcher with no patterns
+Highlight highlight_new(void);
+
+// free the matcher and its patterns
+void highlight_free(Highlight hl);
+
+// match word as a whole word, ignoring case
+void highlight_add_word(Highlight hl, const char * const word, highlight_kind_t kind);
+
+// match a case insensitive regular expression, FALSE if pattern does not compile
+gboolean highlight_add_regex(Highlight hl, const char * const pattern, highlight_kind_t kind);
+
+// return the kinds of all patterns found in text
+int highlight_match(Highlight hl, const char * const text);
+
+#endif
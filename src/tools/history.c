@@ -38,246 +38,451 @@
 #include <glib.h>
 
 #include "history.h"
+#include "tools/filewriter.h"
+
+/*
+ * Items are kept in a fixed size ring, oldest first. While navigating,
+ * edits to items are held in an overlay and only written back to the ring
+ * when a line is appended. Each item has an id, one more than the item
+ * before it, and a trigram index maps every three bytes to the ids of the
+ * items containing them, for substring search.
+ */
 
 struct history_session_t {
-    GList *items;
-    GList *sess_curr;
-    GList *sess_new;
-    GList *orig_curr;
+    gboolean active;
+    unsigned int curr;          // position being shown, length is the new item
+    char *new_item;
+    GHashTable *edits;          // position to edited text
 };
 
 struct history_t {
-    GList *items;
-    guint max_size;
+    char **items;
+    unsigned int capacity;
+    unsigned int start;
+    unsigned int length;
+    guint first_id;
+    GHashTable *trigrams;       // trigram to GArray of item ids, oldest first
+    gboolean index_stale;
     struct history_session_t session;
 };
 
-static void _replace_history_with_session(History history);
-static gboolean _adding_new(History history);
-static void _reset_session(History history);
-static gboolean _has_session(History history);
-static void _remove_first(History history);
-static void _update_current_session_item(History history, char *item);
-static void _add_to_history(History history, char *item);
-static void _remove_last_session_item(History history);
-static void _replace_current_with_original(History history);
-static void _create_session(History history);
-static void _session_previous(History history);
-static void _session_next(History history);
+static char * _item(History history, unsigned int pos);
+static void _push(History history, char *item);
+static const char * _session_current(History history);
+static void _session_set_current(History history, const char * const item);
+static void _session_commit(History history, gboolean keep_current);
+static void _session_end(History history);
+static guint32 _trigram(const char * const str);
+static void _index_item(History history, guint id, const char * const item);
+static void _unindex_item(History history, guint id, const char * const item);
+static void _index_rebuild(History history);
+static void _postings_free(GArray *postings);
 
 History
 history_new(unsigned int size)
 {
     History new_history = malloc(sizeof(struct history_t));
-    new_history->items = NULL;
-    new_history->max_size = size;
-
-    _reset_session(new_history);
+    new_history->capacity = size > 0 ? size : 1;
+    new_history->items = calloc(new_history->capacity, sizeof(char *));
+    new_history->start = 0;
+    new_history->length = 0;
+    new_history->first_id = 0;
+    new_history->trigrams = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+        (GDestroyNotify)_postings_free);
+    new_history->index_stale = FALSE;
+
+    new_history->session.active = FALSE;
+    new_history->session.curr = 0;
+    new_history->session.new_item = NULL;
+    new_history->session.edits = NULL;
 
     return new_history;
 }
 
+void
+history_free(History history)
+{
+    if (history) {
+        _session_end(history);
+        unsigned int pos;
+        for (pos = 0; pos < history->length; pos++) {
+            free(_item(history, pos));
+        }
+        free(history->items);
+        g_hash_table_destroy(history->trigrams);
+        free(history);
+    }
+}
+
 void
 history_append(History history, char *item)
 {
     char *copied = "";
     if (item != NULL) {
-        copied = strdup(item);
+        copied = item;
     }
 
-    if (history->items == NULL) {
-        _add_to_history(history, copied);
+    if (!history->session.active) {
+        _push(history, strdup(copied));
         return;
     }
 
-    if (!_has_session(history)) {
-        if (g_list_length(history->items) == history->max_size) {
-            _remove_first(history);
+    // appending the new item, keep all edits, an empty new item is dropped
+    if (history->session.curr == history->length) {
+        _session_commit(history, TRUE);
+        if (strcmp(copied, "") != 0) {
+            _push(history, strdup(copied));
         }
 
-        _add_to_history(history, copied);
-
+    // appending an earlier item, it keeps its original text and the edit is added as new
     } else {
-        _update_current_session_item(history, copied);
-
-        if (_adding_new(history)) {
-            if (strcmp(history->session.sess_curr->data, "") == 0) {
-                _remove_last_session_item(history);
-            }
-
-            _replace_history_with_session(history);
-
-        } else {
-            _remove_last_session_item(history);
-
-            char *new = strdup(history->session.sess_curr->data);
-            history->session.items = g_list_append(history->session.items, new);
-
-            _replace_current_with_original(history);
-            _replace_history_with_session(history);
-        }
+        _session_commit(history, FALSE);
+        _push(history, strdup(copied));
     }
+
+    _session_end(history);
 }
 
 char *
 history_previous(History history, char *item)
 {
     // no history
-    if (history->items == NULL) {
+    if (history->length == 0) {
         return NULL;
     }
 
     char *copied = "";
     if (item != NULL) {
-        copied = strdup(item);
+        copied = item;
     }
 
-    if (!_has_session(history)) {
-        _create_session(history);
-
-        // add the new item
-        history->session.items = g_list_append(history->session.items, copied);
-        history->session.sess_new = g_list_last(history->session.items);
-
-        char *result = strdup(history->session.sess_curr->data);
-        return result;
+    if (!history->session.active) {
+        history->session.active = TRUE;
+        history->session.new_item = strdup(copied);
+        history->session.edits = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+        history->session.curr = history->length - 1;
     } else {
-        _update_current_session_item(history, copied);
-        _session_previous(history);
+        _session_set_current(history, copied);
+        if (history->session.curr > 0) {
+            history->session.curr--;
+        }
     }
 
-    char *result = strdup(history->session.sess_curr->data);
-    return result;
+    return strdup(_session_current(history));
 }
 
 char *
 history_next(History history, char *item)
 {
     // no history, or no session, return NULL
-    if ((history->items == NULL) || (history->session.items == NULL)) {
+    if ((history->length == 0) || (!history->session.active)) {
         return NULL;
     }
 
-    if (g_list_next(history->session.sess_curr) == NULL) {
+    if (history->session.curr == history->length) {
         return NULL;
     }
 
     char *copied = "";
     if (item != NULL) {
-        copied = strdup(item);
+        copied = item;
     }
 
-    _update_current_session_item(history, copied);
-    _session_next(history);
+    _session_set_current(history, copied);
+    history->session.curr++;
 
-    char *result = strdup(history->session.sess_curr->data);
-    return result;
+    return strdup(_session_current(history));
 }
 
-static void
-_replace_history_with_session(History history)
+unsigned int
+history_length(History history)
 {
-    g_list_free(history->items);
-    history->items = g_list_copy(history->session.items);
+    return history->length;
+}
 
-    if (g_list_length(history->items) > history->max_size) {
-        _remove_first(history);
+const char *
+history_get(History history, unsigned int index)
+{
+    if (index >= history->length) {
+        return NULL;
     }
 
-    _reset_session(history);
+    return _item(history, index);
 }
 
-static gboolean
-_adding_new(History history)
+int
+history_search(History history, const char * const search_str, int before)
 {
-    return (history->session.sess_curr ==
-        g_list_last(history->session.items));
+    if (search_str == NULL || search_str[0] == '\0') {
+        return -1;
+    }
+
+    if (before < 0) {
+        return -1;
+    }
+    if ((unsigned int)before > history->length) {
+        before = history->length;
+    }
+
+    // too short to use the index
+    size_t search_len = strlen(search_str);
+    if (search_len < 3) {
+        int pos;
+        for (pos = before - 1; pos >= 0; pos--) {
+            if (strstr(_item(history, pos), search_str)) {
+                return pos;
+            }
+        }
+        return -1;
+    }
+
+    if (history->index_stale) {
+        _index_rebuild(history);
+    }
+
+    // only items with the rarest trigram of the search string can match
+    GArray *candidates = NULL;
+    size_t i;
+    for (i = 0; i + 3 <= search_len; i++) {
+        GArray *postings = g_hash_table_lookup(history->trigrams,
+            GUINT_TO_POINTER(_trigram(&search_str[i])));
+        if (postings == NULL) {
+            return -1;
+        }
+        if (candidates == NULL || postings->len < candidates->len) {
+            candidates = postings;
+        }
+    }
+
+    int j;
+    for (j = candidates->len - 1; j >= 0; j--) {
+        unsigned int pos = g_array_index(candidates, guint, j) - history->first_id;
+        if (pos >= (unsigned int)before) {
+            continue;
+        }
+        if (strstr(_item(history, pos), search_str)) {
+            return pos;
+        }
+    }
+
+    return -1;
 }
 
-static void
-_reset_session(History history)
+gboolean
+history_load(History history, const char * const filename)
 {
-    history->session.items = NULL;
-    history->session.sess_curr = NULL;
-    history->session.sess_new = NULL;
-    history->session.orig_curr = NULL;
+    gchar *contents = NULL;
+    if (!g_file_get_contents(filename, &contents, NULL, NULL)) {
+        return FALSE;
+    }
+
+    _session_end(history);
+
+    // loaded items go before any already in the history
+    GPtrArray *current = g_ptr_array_new();
+    unsigned int pos;
+    for (pos = 0; pos < history->length; pos++) {
+        g_ptr_array_add(current, _item(history, pos));
+    }
+    history->start = 0;
+    history->length = 0;
+    g_hash_table_remove_all(history->trigrams);
+    history->index_stale = FALSE;
+
+    gchar **lines = g_strsplit(contents, "\n", -1);
+    g_free(contents);
+    gchar **line;
+    for (line = lines; *line != NULL; line++) {
+        if (**line != '\0') {
+            gchar *item = g_strcompress(*line);
+            _push(history, strdup(item));
+            g_free(item);
+        }
+    }
+    g_strfreev(lines);
+
+    for (pos = 0; pos < current->len; pos++) {
+        _push(history, g_ptr_array_index(current, pos));
+    }
+    g_ptr_array_free(current, TRUE);
+
+    return TRUE;
 }
 
-static gboolean
-_has_session(History history)
+gboolean
+history_save(History history, const char * const filename)
 {
-    return (history->session.items != NULL);
+    GString *contents = g_string_new("");
+    unsigned int pos;
+    for (pos = 0; pos < history->length; pos++) {
+        gchar *escaped = g_strescape(_item(history, pos), NULL);
+        g_string_append(contents, escaped);
+        g_string_append(contents, "\n");
+        g_free(escaped);
+    }
+
+    // created private, the file is never readable by others even briefly
+    gboolean result = filewriter_write(filename, contents->str, contents->len);
+    g_string_free(contents, TRUE);
+
+    return result;
 }
 
-static void
-_remove_first(History history)
+static char *
+_item(History history, unsigned int pos)
 {
-    GList *first = g_list_first(history->items);
-    char *first_item = first->data;
-    history->items = g_list_remove(history->items, first_item);
+    return history->items[(history->start + pos) % history->capacity];
 }
 
 static void
-_update_current_session_item(History history, char *item)
+_push(History history, char *item)
 {
-    history->session.sess_curr->data = item;
+    // full, drop the oldest
+    if (history->length == history->capacity) {
+        char *oldest = history->items[history->start];
+        if (!history->index_stale) {
+            _unindex_item(history, history->first_id, oldest);
+        }
+        free(oldest);
+        history->start = (history->start + 1) % history->capacity;
+        history->length--;
+        history->first_id++;
+    }
+
+    history->items[(history->start + history->length) % history->capacity] = item;
+    history->length++;
+
+    if (!history->index_stale) {
+        _index_item(history, history->first_id + history->length - 1, item);
+    }
 }
 
-static void
-_add_to_history(History history, char *item)
+static const char *
+_session_current(History history)
 {
-    history->items = g_list_append(history->items, item);
+    if (history->session.curr == history->length) {
+        return history->session.new_item;
+    }
+
+    char *edited = g_hash_table_lookup(history->session.edits,
+        GUINT_TO_POINTER(history->session.curr));
+    if (edited) {
+        return edited;
+    } else {
+        return _item(history, history->session.curr);
+    }
 }
 
 static void
-_remove_last_session_item(History history)
+_session_set_current(History history, const char * const item)
 {
-    history->session.items = g_list_reverse(history->session.items);
-    GList *first = g_list_first(history->session.items);
-    history->session.items =
-        g_list_remove(history->session.items, first->data);
-    history->session.items = g_list_reverse(history->session.items);
+    if (history->session.curr == history->length) {
+        free(history->session.new_item);
+        history->session.new_item = strdup(item);
+
+    // only keep edits that change the item
+    } else if (strcmp(_item(history, history->session.curr), item) != 0) {
+        g_hash_table_replace(history->session.edits, GUINT_TO_POINTER(history->session.curr),
+            strdup(item));
+    } else {
+        g_hash_table_remove(history->session.edits, GUINT_TO_POINTER(history->session.curr));
+    }
 }
 
+// write edits back to the items, except the current one unless keep_current
 static void
-_replace_current_with_original(History history)
+_session_commit(History history, gboolean keep_current)
 {
-    history->session.sess_curr->data = strdup(history->session.orig_curr->data);
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, history->session.edits);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        unsigned int pos = GPOINTER_TO_UINT(key);
+        if (!keep_current && pos == history->session.curr) {
+            continue;
+        }
+        unsigned int slot = (history->start + pos) % history->capacity;
+        free(history->items[slot]);
+        history->items[slot] = strdup(value);
+        history->index_stale = TRUE;
+    }
 }
 
 static void
-_create_session(History history)
+_session_end(History history)
+{
+    if (history->session.edits) {
+        g_hash_table_destroy(history->session.edits);
+        history->session.edits = NULL;
+    }
+    free(history->session.new_item);
+    history->session.new_item = NULL;
+    history->session.active = FALSE;
+    history->session.curr = 0;
+}
+
+static guint32
+_trigram(const char * const str)
 {
-    history->session.items = g_list_copy(history->items);
-    history->session.sess_curr = g_list_last(history->session.items);
-    history->session.orig_curr = g_list_last(history->items);
+    return ((guint32)(guchar)str[0] << 16) | ((guint32)(guchar)str[1] << 8) | (guint32)(guchar)str[2];
 }
 
 static void
-_session_previous(History history)
+_index_item(History history, guint id, const char * const item)
 {
-    history->session.sess_curr =
-        g_list_previous(history->session.sess_curr);
-    if (history->session.orig_curr == NULL)
-        history->session.orig_curr = g_list_last(history->items);
-    else
-        history->session.orig_curr =
-            g_list_previous(history->session.orig_curr);
-
-    if (history->session.sess_curr == NULL) {
-        history->session.sess_curr = g_list_first(history->session.items);
-        history->session.orig_curr = g_list_first(history->items);
+    size_t len = strlen(item);
+    size_t i;
+    for (i = 0; i + 3 <= len; i++) {
+        gpointer key = GUINT_TO_POINTER(_trigram(&item[i]));
+        GArray *postings = g_hash_table_lookup(history->trigrams, key);
+        if (postings == NULL) {
+            postings = g_array_new(FALSE, FALSE, sizeof(guint));
+            g_hash_table_insert(history->trigrams, key, postings);
+        }
+
+        // trigram repeated in the item
+        if (postings->len > 0 && g_array_index(postings, guint, postings->len - 1) == id) {
+            continue;
+        }
+        g_array_append_val(postings, id);
     }
 }
 
+// the oldest item is first in each of its postings
 static void
-_session_next(History history)
+_unindex_item(History history, guint id, const char * const item)
 {
-    history->session.sess_curr = g_list_next(history->session.sess_curr);
-    history->session.orig_curr = g_list_next(history->session.orig_curr);
+    size_t len = strlen(item);
+    size_t i;
+    for (i = 0; i + 3 <= len; i++) {
+        gpointer key = GUINT_TO_POINTER(_trigram(&item[i]));
+        GArray *postings = g_hash_table_lookup(history->trigrams, key);
+        if (postings == NULL || g_array_index(postings, guint, 0) != id) {
+            continue;
+        }
+        if (postings->len == 1) {
+            g_hash_table_remove(history->trigrams, key);
+        } else {
+            g_array_remove_index(postings, 0);
+        }
+    }
+}
 
-    if (history->session.sess_curr == NULL) {
-        history->session.sess_curr = g_list_last(history->session.items);
-        history->session.orig_curr = NULL;
+static void
+_index_rebuild(History history)
+{
+    g_hash_table_remove_all(history->trigrams);
+    unsigned int pos;
+    for (pos = 0; pos < history->length; pos++) {
+        _index_item(history, history->first_id + pos, _item(history, pos));
     }
+    history->index_stale = FALSE;
+}
+
+static void
+_postings_free(GArray *postings)
+{
+    g_array_free(postings, TRUE);
 }
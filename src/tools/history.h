@@ -35,11 +35,26 @@
 #ifndef HISTORY_H
 #define HISTORY_H
 
+#include <glib.h>
+
 typedef struct history_t  *History;
 
 History history_new(unsigned int size);
+void history_free(History history);
 char * history_previous(History history, char *item);
 char * history_next(History history, char *item);
 void history_append(History history, char *item);
 
+unsigned int history_length(History history);
+
+// item at index, oldest first, owned by the history
+const char * history_get(History history, unsigned int index);
+
+// index of the newest item before the given index containing search_str, -1 if none
+int history_search(History history, const char * const search_str, int before);
+
+// loaded items are placed before those already in the history
+gboolean history_load(History history, const char * const filename);
+gboolean history_save(History history, const char * const filename);
+
 #endif
@@ -0,0 +1,361 @@
+/*
+ * http.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <curl/curl.h>
+#include <glib.h>
+
+#include "log.h"
+#include "tools/http.h"
+
+#define HTTP_CONNECT_TIMEOUT_SECS 10
+#define HTTP_MAX_CONNECTS 4
+#define HTTP_MAX_BODY (1024 * 1024)
+#define HTTP_CACHE_MAX 64
+
+typedef struct http_callback_t {
+    http_func func;
+    void *userdata;
+    GDestroyNotify free_func;
+} HttpCallback;
+
+typedef struct http_request_t {
+    char *url;
+    CURL *handle;
+    GString *body;
+    int cache_secs;
+    GSList *callbacks;
+    char error[CURL_ERROR_SIZE];
+} HttpRequest;
+
+typedef struct http_cached_t {
+    char *body;
+    GTimer *age;
+    int max_age;
+} HttpCached;
+
+// the multi handle keeps connections open between requests to the same host
+static CURLM *multi = NULL;
+
+// requests in flight and recent responses, keyed on url
+static GHashTable *requests = NULL;
+static GHashTable *cache = NULL;
+
+static HttpRequest* _request_new(const char * const url, int cache_secs, long timeout_secs);
+static void _request_done(HttpRequest *request, CURLcode result);
+static void _request_free(HttpRequest *request);
+static HttpCallback* _callback_new(http_func func, void *userdata, GDestroyNotify free_func);
+static void _callback_free(HttpCallback *callback);
+static const char* _cache_find(const char * const url);
+static void _cache_add(const char * const url, const char * const body, int max_age);
+static void _cache_free(HttpCached *cached);
+static size_t _data_callback(void *ptr, size_t size, size_t nmemb, void *data);
+
+void
+http_init(void)
+{
+    cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_cache_free);
+    requests = g_hash_table_new(g_str_hash, g_str_equal);
+
+    multi = curl_multi_init();
+    if (multi == NULL) {
+        log_error("Could not create HTTP transfer handle, requests will block");
+        return;
+    }
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)HTTP_MAX_CONNECTS);
+}
+
+void
+http_shutdown(void)
+{
+    if (requests != NULL) {
+        GList *in_flight = g_hash_table_get_values(requests);
+        GList *curr = in_flight;
+        while (curr) {
+            HttpRequest *request = curr->data;
+            curl_multi_remove_handle(multi, request->handle);
+            _request_free(request);
+            curr = g_list_next(curr);
+        }
+        g_list_free(in_flight);
+        g_hash_table_destroy(requests);
+        requests = NULL;
+    }
+
+    if (multi != NULL) {
+        curl_multi_cleanup(multi);
+        multi = NULL;
+    }
+
+    if (cache != NULL) {
+        g_hash_table_destroy(cache);
+        cache = NULL;
+    }
+}
+
+void
+http_get(const char * const url, long timeout_secs, int cache_secs,
+    http_func func, void *userdata, GDestroyNotify free_func)
+{
+    const char *cached = _cache_find(url);
+    if (cached != NULL) {
+        log_debug("HTTP cached response for %s", url);
+        func(cached, userdata);
+        if (free_func) {
+            free_func(userdata);
+        }
+        return;
+    }
+
+    HttpCallback *callback = _callback_new(func, userdata, free_func);
+
+    // already being fetched, answer both from the one response
+    HttpRequest *request = requests ? g_hash_table_lookup(requests, url) : NULL;
+    if (request != NULL) {
+        request->callbacks = g_slist_append(request->callbacks, callback);
+        return;
+    }
+
+    request = _request_new(url, cache_secs, timeout_secs);
+    if (request == NULL) {
+        func(NULL, userdata);
+        _callback_free(callback);
+        return;
+    }
+    request->callbacks = g_slist_append(request->callbacks, callback);
+
+    if (multi == NULL) {
+        CURLcode result = curl_easy_perform(request->handle);
+        _request_done(request, result);
+        return;
+    }
+
+    log_debug("HTTP request %s", url);
+    g_hash_table_insert(requests, request->url, request);
+    curl_multi_add_handle(multi, request->handle);
+}
+
+void
+http_process(void)
+{
+    if (multi == NULL || g_hash_table_size(requests) == 0) {
+        return;
+    }
+
+    int running = 0;
+    curl_multi_perform(multi, &running);
+
+    CURLMsg *msg = NULL;
+    int remaining = 0;
+    while ((msg = curl_multi_info_read(multi, &remaining)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        HttpRequest *request = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&request);
+        CURLcode result = msg->data.result;
+
+        curl_multi_remove_handle(multi, request->handle);
+        g_hash_table_remove(requests, request->url);
+        _request_done(request, result);
+    }
+}
+
+static HttpRequest*
+_request_new(const char * const url, int cache_secs, long timeout_secs)
+{
+    CURL *handle = curl_easy_init();
+    if (handle == NULL) {
+        log_error("Could not create HTTP request for %s", url);
+        return NULL;
+    }
+
+    HttpRequest *request = malloc(sizeof(HttpRequest));
+    request->url = strdup(url);
+    request->handle = handle;
+    request->body = g_string_new("");
+    request->cache_secs = cache_secs;
+    request->callbacks = NULL;
+    request->error[0] = '\0';
+
+    curl_easy_setopt(handle, CURLOPT_URL, request->url);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, _data_callback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, (void *)request);
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, (void *)request);
+    curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, request->error);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, timeout_secs);
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, MIN(timeout_secs, (long)HTTP_CONNECT_TIMEOUT_SECS));
+    // resolver timeouts must not use signals outside the main thread's control
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+
+    return request;
+}
+
+static void
+_request_done(HttpRequest *request, CURLcode result)
+{
+    long status = 0;
+    curl_easy_getinfo(request->handle, CURLINFO_RESPONSE_CODE, &status);
+
+    const char *body = NULL;
+    if (result != CURLE_OK) {
+        const char *reason = request->error[0] != '\0' ? request->error : curl_easy_strerror(result);
+        log_error("HTTP request %s failed: %s", request->url, reason);
+    } else if (status < 200 || status > 299) {
+        log_error("HTTP request %s failed with status %ld", request->url, status);
+    } else {
+        body = request->body->str;
+        if (request->cache_secs > 0) {
+            _cache_add(request->url, body, request->cache_secs);
+        }
+    }
+
+    GSList *curr = request->callbacks;
+    while (curr) {
+        HttpCallback *callback = curr->data;
+        callback->func(body, callback->userdata);
+        curr = g_slist_next(curr);
+    }
+
+    _request_free(request);
+}
+
+static void
+_request_free(HttpRequest *request)
+{
+    curl_easy_cleanup(request->handle);
+    g_slist_free_full(request->callbacks, (GDestroyNotify)_callback_free);
+    g_string_free(request->body, TRUE);
+    free(request->url);
+    free(request);
+}
+
+static HttpCallback*
+_callback_new(http_func func, void *userdata, GDestroyNotify free_func)
+{
+    HttpCallback *callback = malloc(sizeof(HttpCallback));
+    callback->func = func;
+    callback->userdata = userdata;
+    callback->free_func = free_func;
+
+    return callback;
+}
+
+static void
+_callback_free(HttpCallback *callback)
+{
+    if (callback->free_func) {
+        callback->free_func(callback->userdata);
+    }
+    free(callback);
+}
+
+static const char*
+_cache_find(const char * const url)
+{
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    HttpCached *cached = g_hash_table_lookup(cache, url);
+    if (cached == NULL) {
+        return NULL;
+    }
+
+    if (g_timer_elapsed(cached->age, NULL) >= cached->max_age) {
+        g_hash_table_remove(cache, url);
+        return NULL;
+    }
+
+    return cached->body;
+}
+
+static void
+_cache_add(const char * const url, const char * const body, int max_age)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    // make room by dropping the oldest response
+    if (g_hash_table_size(cache) >= HTTP_CACHE_MAX) {
+        GHashTableIter iter;
+        gpointer key, value;
+        gpointer oldest = NULL;
+        gdouble oldest_age = -1;
+        g_hash_table_iter_init(&iter, cache);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            gdouble age = g_timer_elapsed(((HttpCached*)value)->age, NULL);
+            if (age > oldest_age) {
+                oldest_age = age;
+                oldest = key;
+            }
+        }
+        g_hash_table_remove(cache, oldest);
+    }
+
+    HttpCached *cached = malloc(sizeof(HttpCached));
+    cached->body = strdup(body);
+    cached->age = g_timer_new();
+    cached->max_age = max_age;
+    g_hash_table_replace(cache, g_strdup(url), cached);
+}
+
+static void
+_cache_free(HttpCached *cached)
+{
+    free(cached->body);
+    g_timer_destroy(cached->age);
+    free(cached);
+}
+
+static size_t
+_data_callback(void *ptr, size_t size, size_t nmemb, void *data)
+{
+    size_t realsize = size * nmemb;
+    HttpRequest *request = data;
+
+    // returning short makes curl fail the transfer
+    if (request->body->len + realsize > HTTP_MAX_BODY) {
+        return 0;
+    }
+
+    g_string_append_len(request->body, ptr, realsize);
+
+    return realsize;
+}
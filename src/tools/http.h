@@ -0,0 +1,57 @@
+/*
+ * http.h
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <glib.h>
+
+// body is NULL when the request failed or did not return 2xx
+typedef void (*http_func)(const char * const body, void *userdata);
+
+// start and stop the transfer handle, without it requests block in place
+void http_init(void);
+void http_shutdown(void);
+
+// fetch url, calling func then free_func on userdata from the main loop,
+// a response younger than cache_secs is answered straight away,
+// at shutdown free_func is called for requests still in flight
+void http_get(const char * const url, long timeout_secs, int cache_secs,
+    http_func func, void *userdata, GDestroyNotify free_func);
+
+// called from the main loop, move transfers on and run finished callbacks
+void http_process(void);
+
+#endif
@@ -37,7 +37,9 @@
 
 #include <glib.h>
 
+#include "tools/http.h"
+
 gboolean tinyurl_valid(char *url);
-char * tinyurl_get(char *url);
+void tinyurl_get(char *url, http_func func, void *userdata, GDestroyNotify free_func);
 
 #endif
@@ -0,0 +1,178 @@
+/*
+ * worker.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "log.h"
+#include "tools/worker.h"
+
+#define WORKER_THREADS 2
+
+typedef struct worker_job_t {
+    worker_func func;
+    worker_func done;
+    gpointer data;
+    GAsyncQueue *finished;
+} WorkerJob;
+
+static GThreadPool *pool = NULL;
+static GAsyncQueue *finished = NULL;
+
+static void _worker_thread(gpointer job_data, gpointer user_data);
+static gpointer _detached_thread(gpointer data);
+static void _job_done(WorkerJob *job);
+
+void
+worker_init(void)
+{
+#if !GLIB_CHECK_VERSION(2,32,0)
+    if (!g_thread_supported()) {
+        g_thread_init(NULL);
+    }
+#endif
+    finished = g_async_queue_new();
+    pool = g_thread_pool_new(_worker_thread, NULL, WORKER_THREADS, FALSE, NULL);
+    if (pool == NULL) {
+        log_error("Could not start worker threads, running background work in place");
+        g_async_queue_unref(finished);
+        finished = NULL;
+    }
+}
+
+/*
+ * Waits for queued work to finish, so nothing runs after the modules it
+ * uses have been closed
+ */
+void
+worker_shutdown(void)
+{
+    if (pool) {
+        g_thread_pool_free(pool, FALSE, TRUE);
+        pool = NULL;
+        worker_poll();
+        g_async_queue_unref(finished);
+        finished = NULL;
+    }
+}
+
+void
+worker_run(worker_func func, worker_func done, gpointer data)
+{
+    WorkerJob *job = malloc(sizeof(WorkerJob));
+    job->func = func;
+    job->done = done;
+    job->data = data;
+    job->finished = finished;
+
+    if (pool) {
+        g_thread_pool_push(pool, job, NULL);
+    } else {
+        func(data);
+        _job_done(job);
+    }
+}
+
+void
+worker_run_detached(worker_func func, worker_func done, gpointer data)
+{
+    WorkerJob *job = malloc(sizeof(WorkerJob));
+    job->func = func;
+    job->done = done;
+    job->data = data;
+    job->finished = finished;
+
+    if (pool) {
+        // the thread keeps its own reference, it may outlive worker_shutdown
+        g_async_queue_ref(job->finished);
+#if GLIB_CHECK_VERSION(2,32,0)
+        GThread *thread = g_thread_try_new("worker", _detached_thread, job, NULL);
+        if (thread) {
+            g_thread_unref(thread);
+            return;
+        }
+#else
+        if (g_thread_create(_detached_thread, job, FALSE, NULL)) {
+            return;
+        }
+#endif
+        g_async_queue_unref(job->finished);
+        log_error("Could not start worker thread, running work in place");
+    }
+
+    func(data);
+    _job_done(job);
+}
+
+void
+worker_poll(void)
+{
+    if (finished) {
+        WorkerJob *job;
+        while ((job = g_async_queue_try_pop(finished)) != NULL) {
+            _job_done(job);
+        }
+    }
+}
+
+static void
+_worker_thread(gpointer job_data, gpointer user_data)
+{
+    WorkerJob *job = job_data;
+    job->func(job->data);
+    g_async_queue_push(job->finished, job);
+}
+
+static gpointer
+_detached_thread(gpointer data)
+{
+    WorkerJob *job = data;
+    GAsyncQueue *queue = job->finished;
+    job->func(job->data);
+    g_async_queue_push(queue, job);
+    g_async_queue_unref(queue);
+
+    return NULL;
+}
+
+static void
+_job_done(WorkerJob *job)
+{
+    if (job->done) {
+        job->done(job->data);
+    }
+    free(job);
+}
@@ -0,0 +1,57 @@
+/*
+ * worker.h
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <glib.h>
+
+typedef void (*worker_func)(gpointer data);
+
+// start and stop the background threads, without them work runs in place
+void worker_init(void);
+void worker_shutdown(void);
+
+// run func on a background thread, then done with the same data on the main loop
+void worker_run(worker_func func, worker_func done, gpointer data);
+
+// as worker_run on a thread of its own that shutdown does not wait for,
+// done is never called if the work is still running at shutdown
+void worker_run_detached(worker_func func, worker_func done, gpointer data);
+
+// called from the main loop, run done for finished work
+void worker_poll(void);
+
+#endif
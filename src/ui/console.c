@@ -61,6 +61,8 @@
 #endif
 
 static void _cons_splash_logo(void);
+static void _show_latest_release(const char * const latest_release, void *userdata);
+static void _cons_show_latency_histogram(IqStats *stats);
 void _show_roster_contacts(GSList *list, gboolean show_groups);
 
 void
@@ -194,11 +196,20 @@ cons_about(void)
     cons_alert();
 }
 
+/*
+ * The release is fetched in the background and shown when it arrives
+ */
 void
 cons_check_version(gboolean not_available_msg)
 {
+    release_get_latest(_show_latest_release, GINT_TO_POINTER(not_available_msg), NULL);
+}
+
+static void
+_show_latest_release(const char * const latest_release, void *userdata)
+{
+    gboolean not_available_msg = GPOINTER_TO_INT(userdata);
     ProfWin *console = wins_get_console();
-    char *latest_release = release_get_latest();
 
     if (latest_release != NULL) {
         gboolean relase_valid = g_regex_match_simple("^\\d+\\.\\d+\\.\\d+$", latest_release, 0, 0);
@@ -217,7 +228,6 @@ cons_check_version(gboolean not_available_msg)
 
             cons_alert();
         }
-        free(latest_release);
     }
 }
 
@@ -524,6 +534,69 @@ cons_show_disco_info(const char *jid, GSList *identities, GSList *features)
     }
 }
 
+void
+cons_show_ping_stats(IqStats *rtt_stats, int interval, int last_millis)
+{
+    cons_show("");
+    if (interval == 0) {
+        cons_show("Autoping is OFF.");
+    } else {
+        cons_show("Autoping interval: %d seconds", interval);
+    }
+
+    if (rtt_stats == NULL || rtt_stats->sent == 0) {
+        cons_show("No server pings sent.");
+        cons_alert();
+        return;
+    }
+
+    cons_show("Sent: %d, answered: %d, missed: %d",
+        rtt_stats->sent, rtt_stats->results, rtt_stats->timeouts);
+    if (rtt_stats->results > 0) {
+        if (last_millis >= 0) {
+            cons_show("Round trip last: %dms, average: %dms, max: %dms", last_millis,
+                (int)(rtt_stats->total_millis / rtt_stats->results), rtt_stats->max_millis);
+        } else {
+            cons_show("Round trip average: %dms, max: %dms",
+                (int)(rtt_stats->total_millis / rtt_stats->results), rtt_stats->max_millis);
+        }
+        _cons_show_latency_histogram(rtt_stats);
+    }
+
+    cons_alert();
+}
+
+void
+cons_show_iq_stats(GList *stats, int outstanding)
+{
+    cons_show("");
+    if (stats == NULL) {
+        cons_show("No IQ requests sent (%d outstanding).", outstanding);
+        cons_alert();
+        return;
+    }
+
+    cons_show("IQ request statistics (%d outstanding):", outstanding);
+    while (stats != NULL) {
+        IqStats *ns_stats = stats->data;
+        cons_show("  %s", ns_stats->ns);
+        cons_show("    Sent: %d, results: %d, errors: %d, timeouts: %d",
+            ns_stats->sent, ns_stats->results, ns_stats->errors, ns_stats->timeouts);
+
+        int answered = ns_stats->results + ns_stats->errors;
+        if (answered > 0) {
+            cons_show("    Average: %dms, max: %dms",
+                (int)(ns_stats->total_millis / answered), ns_stats->max_millis);
+
+            _cons_show_latency_histogram(ns_stats);
+        }
+
+        stats = g_list_next(stats);
+    }
+
+    cons_alert();
+}
+
 void
 cons_show_disco_items(GSList *items, const char * const jid)
 {
@@ -886,6 +959,12 @@ cons_occupants_setting(void)
 
     int size = prefs_get_occupants_size();
     cons_show("Occupants size (/occupants)   : %d", size);
+
+    int compact = prefs_get_occupants_compact();
+    if (compact == 0)
+        cons_show("Occupants compact (/occupants): OFF");
+    else
+        cons_show("Occupants compact (/occupants): %d", compact);
 }
 
 void
@@ -900,6 +979,18 @@ cons_autoconnect_setting(void)
     prefs_free_string(pref_connect_account);
 }
 
+void
+cons_complete_setting(void)
+{
+    char *pref_complete = prefs_get_string(PREF_COMPLETE);
+    if (g_strcmp0(pref_complete, "fuzzy") == 0)
+        cons_show("Completion (/complete)        : fuzzy");
+    else
+        cons_show("Completion (/complete)        : prefix");
+
+    prefs_free_string(pref_complete);
+}
+
 void
 cons_time_setting(void)
 {
@@ -932,6 +1023,15 @@ cons_mouse_setting(void)
         cons_show("Mouse handling (/mouse)       : OFF");
 }
 
+void
+cons_multiline_setting(void)
+{
+    if (prefs_get_boolean(PREF_MULTILINE))
+        cons_show("Multi-line paste (/multiline) : send");
+    else
+        cons_show("Multi-line paste (/multiline) : join");
+}
+
 void
 cons_statuses_setting(void)
 {
@@ -991,8 +1091,10 @@ cons_show_ui_prefs(void)
     cons_splash_setting();
     cons_wrap_setting();
     cons_time_setting();
+    cons_complete_setting();
     cons_vercheck_setting();
     cons_mouse_setting();
+    cons_multiline_setting();
     cons_statuses_setting();
     cons_occupants_setting();
     cons_roster_setting();
@@ -1400,6 +1502,7 @@ cons_navigation_help(void)
     cons_show("Alt-LEFT, Alt-RIGHT              : Previous/next chat window");
     cons_show("UP, DOWN                         : Navigate input history.");
     cons_show("Ctrl-n, Ctrl-p                   : Navigate input history.");
+    cons_show("Ctrl-r                           : Search input history, again for older matches.");
     cons_show("LEFT, RIGHT, HOME, END           : Move cursor.");
     cons_show("Ctrl-b, Ctrl-f, Ctrl-a, Ctrl-e   : Move cursor.");
     cons_show("Ctrl-LEFT, Ctrl-RIGHT            : Jump word.");
@@ -1460,7 +1563,7 @@ cons_show_contact_online(PContact contact, Resource *resource, GDateTime *last_a
 }
 
 void
-cons_show_contact_offline(PContact contact, char *resource, char *status)
+cons_show_contact_offline(PContact contact, const char * const resource, const char * const status)
 {
     char *display_str = p_contact_create_display_string(contact, resource);
 
@@ -1629,3 +1732,21 @@ _show_roster_contacts(GSList *list, gboolean show_groups)
         curr = g_slist_next(curr);
     }
 }
+
+static void
+_cons_show_latency_histogram(IqStats *stats)
+{
+    GString *histogram = g_string_new("   ");
+    int i;
+    for (i = 0; i < IQ_LATENCY_BUCKETS; i++) {
+        int limit = iq_stats_bucket_limit(i);
+        if (limit == -1) {
+            g_string_append_printf(histogram, " >%dms: %d",
+                iq_stats_bucket_limit(i - 1), stats->buckets[i]);
+        } else {
+            g_string_append_printf(histogram, " <=%dms: %d", limit, stats->buckets[i]);
+        }
+    }
+    cons_show(histogram->str);
+    g_string_free(histogram, TRUE);
+}
@@ -80,10 +80,29 @@ static Display *display;
 
 static GTimer *ui_idle_time;
 
+#define MENTIONS_MAX 1000
+
+typedef struct muc_mention_t {
+    char *roomjid;
+    char *nick;
+    GTimeVal tv_stamp;
+    char *message;
+} MucMention;
+
+// most recent room messages that matched a highlight, oldest first
+static GQueue *mentions = NULL;
+
+// bumped when the highlight words change, rooms rebuild their matcher on next use
+static unsigned int highlight_version = 1;
+
 static void _win_handle_switch(const wint_t * const ch);
 static void _win_handle_page(const wint_t * const ch, const int result);
 static void _win_show_history(int win_index, const char * const contact);
 static void _ui_draw_term_title(void);
+static Highlight _mucwin_highlight(ProfMucWin *mucwin, const char * const my_nick);
+static void _mention_add(const char * const roomjid, const char * const nick, const char * const message);
+static void _mention_print(ProfWin *window, MucMention *mention);
+static void _mention_free(MucMention *mention);
 
 void
 ui_init(void)
@@ -115,11 +134,24 @@ ui_init(void)
 void
 ui_update(void)
 {
+    // edits to the theme file are shown without /theme set
+    if (theme_reload_changed()) {
+        ui_load_colours();
+        ui_redraw();
+    }
+
     ProfWin *current = wins_get_current();
     if (current->layout->paged == 0) {
         win_move_to_end(current);
     }
 
+    // panels are rebuilt once per update, and only while shown
+    if (current->type == WIN_CONSOLE) {
+        rosterwin_draw();
+    } else if (current->type == WIN_MUC) {
+        occupantswin_draw((ProfMucWin*)current);
+    }
+
     win_update_virtual(current);
 
     if (prefs_get_boolean(PREF_TITLEBAR)) {
@@ -171,7 +203,12 @@ ui_close(void)
 {
     notifier_uninit();
     wins_destroy();
+    inp_close();
     endwin();
+    if (mentions) {
+        g_queue_free_full(mentions, (GDestroyNotify)_mention_free);
+        mentions = NULL;
+    }
 }
 
 wint_t
@@ -219,6 +256,8 @@ ui_resize(void)
 void
 ui_redraw(void)
 {
+    // colours may have changed under rows that haven't
+    wins_sub_invalidate_all();
     title_bar_resize();
     wins_resize_all();
     status_bar_resize();
@@ -668,11 +707,19 @@ ui_invalid_command_usage(const char * const usage, void (*setting_func)(void))
     }
 }
 
+void
+ui_update_ping_rtt(const int millis)
+{
+    status_bar_set_rtt(millis);
+    status_bar_update_virtual();
+}
+
 void
 ui_disconnected(void)
 {
     wins_lost_connection();
     title_bar_set_presence(CONTACT_OFFLINE);
+    status_bar_set_rtt(-1);
     status_bar_clear_message();
     status_bar_update_virtual();
     ui_hide_roster();
@@ -1780,30 +1827,40 @@ ui_room_nick_change(const char * const roomjid, const char * const nick)
     }
 }
 
+/*
+ * Render the discussion history received on joining a room, history is a list
+ * of MucHistory, oldest first
+ */
 void
-ui_room_history(const char * const roomjid, const char * const nick,
-    GTimeVal tv_stamp, const char * const message)
+ui_room_history_batch(const char * const roomjid, GList *history)
 {
     ProfWin *window = (ProfWin*)wins_get_muc(roomjid);
     if (window == NULL) {
-        log_error("Room history message received from %s, but no window open for %s", nick, roomjid);
-    } else {
-        GString *line = g_string_new("");
+        log_error("Room history received for %s, but no window open", roomjid);
+        return;
+    }
+
+    GString *line = g_string_new("");
+    GList *curr = history;
+    while (curr) {
+        MucHistory *entry = curr->data;
+        g_string_truncate(line, 0);
 
-        if (strncmp(message, "/me ", 4) == 0) {
+        if (strncmp(entry->message, "/me ", 4) == 0) {
             g_string_append(line, "*");
-            g_string_append(line, nick);
+            g_string_append(line, entry->nick);
             g_string_append(line, " ");
-            g_string_append(line, message + 4);
+            g_string_append(line, entry->message + 4);
         } else {
-            g_string_append(line, nick);
+            g_string_append(line, entry->nick);
             g_string_append(line, ": ");
-            g_string_append(line, message);
+            g_string_append(line, entry->message);
         }
 
-        win_save_print(window, '-', &tv_stamp, NO_COLOUR_DATE, 0, "", line->str);
-        g_string_free(line, TRUE);
+        win_save_print(window, '-', &entry->tv_stamp, NO_COLOUR_DATE, 0, "", line->str);
+        curr = g_list_next(curr);
     }
+    g_string_free(line, TRUE);
 }
 
 void
@@ -1818,9 +1875,12 @@ ui_room_message(const char * const roomjid, const char * const nick,
         int num = wins_get_num(window);
         char *my_nick = muc_nick(roomjid);
 
+        int highlight = HIGHLIGHT_NONE;
         if (g_strcmp0(nick, my_nick) != 0) {
-            if (g_strrstr(message, my_nick) != NULL) {
+            highlight = highlight_match(_mucwin_highlight(mucwin, my_nick), message);
+            if (highlight != HIGHLIGHT_NONE) {
                 win_save_print(window, '-', NULL, NO_ME, THEME_ROOMMENTION, nick, message);
+                _mention_add(roomjid, nick, message);
             } else {
                 win_save_print(window, '-', NULL, NO_ME, THEME_TEXT_THEM, nick, message);
             }
@@ -1861,14 +1921,8 @@ ui_room_message(const char * const roomjid, const char * const nick,
             if (g_strcmp0(room_setting, "on") == 0) {
                 notify = TRUE;
             }
-            if (g_strcmp0(room_setting, "mention") == 0) {
-                char *message_lower = g_utf8_strdown(message, -1);
-                char *nick_lower = g_utf8_strdown(nick, -1);
-                if (g_strrstr(message_lower, nick_lower) != NULL) {
-                    notify = TRUE;
-                }
-                g_free(message_lower);
-                g_free(nick_lower);
+            if (g_strcmp0(room_setting, "mention") == 0 && highlight != HIGHLIGHT_NONE) {
+                notify = TRUE;
             }
             prefs_free_string(room_setting);
 
@@ -1888,6 +1942,52 @@ ui_room_message(const char * const roomjid, const char * const nick,
     }
 }
 
+/*
+ * Highlight words or regular expressions were changed
+ */
+void
+ui_highlights_changed(void)
+{
+    highlight_version++;
+}
+
+/*
+ * Open the mentions window, listing the room messages that matched a highlight
+ */
+void
+ui_show_mentions(void)
+{
+    ProfMentionsWin *mentionswin = wins_get_mentions();
+    if (mentionswin) {
+        int num = wins_get_num((ProfWin*)mentionswin);
+        ui_switch_win(num);
+        return;
+    }
+
+    ProfWin *window = wins_new_mentions();
+    if (!mentions || g_queue_is_empty(mentions)) {
+        win_save_print(window, '-', NULL, 0, 0, "", "No mentions.");
+    } else {
+        GList *curr = mentions->head;
+        while (curr) {
+            _mention_print(window, curr->data);
+            curr = g_list_next(curr);
+        }
+    }
+
+    int num = wins_get_num(window);
+    ui_switch_win(num);
+}
+
+void
+ui_clear_mentions(void)
+{
+    if (mentions) {
+        g_queue_free_full(mentions, (GDestroyNotify)_mention_free);
+        mentions = NULL;
+    }
+}
+
 void
 ui_room_requires_config(const char * const roomjid)
 {
@@ -2236,7 +2336,7 @@ ui_chat_win_contact_online(PContact contact, Resource *resource, GDateTime *last
 }
 
 void
-ui_chat_win_contact_offline(PContact contact, char *resource, char *status)
+ui_chat_win_contact_offline(PContact contact, const char * const resource, const char * const status)
 {
     char *display_str = p_contact_create_display_string(contact, resource);
     const char *barejid = p_contact_barejid(contact);
@@ -2985,6 +3085,10 @@ _win_handle_page(const wint_t * const ch, const int result)
             else if (*sub_y_pos >= sub_y)
                 *sub_y_pos = sub_y - page_space - 1;
 
+            // panel shorter than a page, nothing to scroll
+            if (*sub_y_pos < 0)
+                *sub_y_pos = 0;
+
             win_update_virtual(current);
         }
     }
@@ -3027,3 +3131,88 @@ _win_show_history(int win_index, const char * const contact)
     }
 }
 
+// the room's matcher for its current nick and the highlight preferences, rebuilt only when either changed
+static Highlight
+_mucwin_highlight(ProfMucWin *mucwin, const char * const my_nick)
+{
+    if (mucwin->highlight && mucwin->highlight_version == highlight_version &&
+            g_strcmp0(mucwin->highlight_nick, my_nick) == 0) {
+        return mucwin->highlight;
+    }
+
+    highlight_free(mucwin->highlight);
+    free(mucwin->highlight_nick);
+
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, my_nick, HIGHLIGHT_NICK);
+
+    GList *words = prefs_get_highlights(FALSE);
+    GList *curr = words;
+    while (curr) {
+        highlight_add_word(hl, curr->data, HIGHLIGHT_KEYWORD);
+        curr = g_list_next(curr);
+    }
+    g_list_free_full(words, g_free);
+
+    GList *regexes = prefs_get_highlights(TRUE);
+    curr = regexes;
+    while (curr) {
+        if (!highlight_add_regex(hl, curr->data, HIGHLIGHT_KEYWORD)) {
+            log_warning("Invalid highlight regular expression: %s", (char *)curr->data);
+        }
+        curr = g_list_next(curr);
+    }
+    g_list_free_full(regexes, g_free);
+
+    mucwin->highlight = hl;
+    mucwin->highlight_nick = my_nick ? strdup(my_nick) : NULL;
+    mucwin->highlight_version = highlight_version;
+
+    return hl;
+}
+
+static void
+_mention_add(const char * const roomjid, const char * const nick, const char * const message)
+{
+    if (!mentions) {
+        mentions = g_queue_new();
+    }
+
+    MucMention *mention = malloc(sizeof(MucMention));
+    mention->roomjid = strdup(roomjid);
+    mention->nick = strdup(nick);
+    g_get_current_time(&mention->tv_stamp);
+    mention->message = strdup(message);
+    g_queue_push_tail(mentions, mention);
+
+    if (g_queue_get_length(mentions) > MENTIONS_MAX) {
+        _mention_free(g_queue_pop_head(mentions));
+    }
+
+    ProfMentionsWin *mentionswin = wins_get_mentions();
+    if (mentionswin) {
+        ProfWin *window = (ProfWin*)mentionswin;
+        _mention_print(window, mention);
+        if (!wins_is_current(window)) {
+            status_bar_new(wins_get_num(window));
+        }
+    }
+}
+
+static void
+_mention_print(ProfWin *window, MucMention *mention)
+{
+    win_save_vprint(window, '-', &mention->tv_stamp, 0, THEME_ROOMMENTION, "", "%s %s: %s",
+        mention->roomjid, mention->nick, mention->message);
+}
+
+static void
+_mention_free(MucMention *mention)
+{
+    if (mention) {
+        free(mention->roomjid);
+        free(mention->nick);
+        free(mention->message);
+        free(mention);
+    }
+}
@@ -67,15 +67,35 @@
 #define KEY_CTRL_D 0004
 #define KEY_CTRL_E 0005
 #define KEY_CTRL_F 0006
+#define KEY_CTRL_G 0007
 #define KEY_CTRL_N 0016
 #define KEY_CTRL_P 0020
+#define KEY_CTRL_R 0022
 #define KEY_CTRL_U 0025
 #define KEY_CTRL_W 0027
 
+// used when the terminfo entry does not already name the paste sequences
+#define KEY_PASTE_START (KEY_MAX + 1000)
+#define KEY_PASTE_END (KEY_MAX + 1001)
+
+// give up on a paste whose end sequence never arrives
+#define PASTE_TIMEOUT_MS 5000
+#define PASTE_END "\033[201~"
+
 static WINDOW *inp_win;
 static int pad_start = 0;
 static int rows, cols;
 
+// reverse incremental history search
+static gboolean searching = FALSE;
+static GString *search_str = NULL;
+static int search_match = -1;
+static char *search_saved = NULL;
+
+// key codes reported for the bracketed paste start and end sequences
+static int paste_start_key = KEY_PASTE_START;
+static int paste_end_key = KEY_PASTE_END;
+
 static int _handle_edit(int result, const wint_t ch, char *input, int *size);
 static int _handle_alt_key(char *input, int *size, int key);
 static void _handle_backspace(int display_size, int inp_x, int *size, char *input);
@@ -83,6 +103,12 @@ static int _printable(const wint_t ch);
 static void _clear_input(void);
 static void _go_to_end(int display_size);
 static void _delete_previous_word(char *input, int *size);
+static int _handle_search(int result, const wint_t ch, char *input, int *size);
+static void _search_start(char *input, int *size);
+static void _search_update(char *input, int *size, int before);
+static void _search_end(char *input, int *size, gboolean accept);
+static int _paste_key(const char * const sequence, int fallback);
+static gboolean _handle_paste(char *input, int *size);
 
 void
 create_input_window(void)
@@ -98,6 +124,19 @@ create_input_window(void)
     keypad(inp_win, TRUE);
     wmove(inp_win, 0, 0);
     _inp_win_update_virtual();
+
+    // have the terminal wrap pasted text so it can be inserted in one go
+    paste_start_key = _paste_key("\033[200~", KEY_PASTE_START);
+    paste_end_key = _paste_key("\033[201~", KEY_PASTE_END);
+    putp("\033[?2004h");
+    fflush(stdout);
+}
+
+void
+inp_close(void)
+{
+    putp("\033[?2004l");
+    fflush(stdout);
 }
 
 void
@@ -164,6 +203,17 @@ inp_get_char(char *input, int *size, int *result)
         }
     }
 
+    if (*result == KEY_CODE_YES && ch == paste_start_key) {
+        if (searching) {
+            _search_end(input, size, TRUE);
+        }
+        if (_handle_paste(input, size)) {
+            ch = '\n';
+        }
+        echo();
+        return ch;
+    }
+
     // if it wasn't an arrow key etc
     if (!_handle_edit(*result, ch, input, size)) {
         if (_printable(ch) && *result != KEY_CODE_YES) {
@@ -257,7 +307,7 @@ void
 inp_replace_input(char *input, const char * const new_input, int *size)
 {
     int display_size;
-    strncpy(input, new_input, INP_WIN_MAX);
+    g_strlcpy(input, new_input, INP_WIN_MAX);
     *size = strlen(input);
     display_size = g_utf8_strlen(input, *size);
     inp_win_reset();
@@ -295,6 +345,10 @@ _handle_edit(int result, const wint_t ch, char *input, int *size)
     int next_ch;
     int display_size = 0;
 
+    if (searching && _handle_search(result, ch, input, size)) {
+        return 1;
+    }
+
     if (*size != 0) {
         display_size = g_utf8_strlen(input, *size);
     }
@@ -506,6 +560,7 @@ _handle_edit(int result, const wint_t ch, char *input, int *size)
             prev = cmd_history_previous(input, size);
             if (prev) {
                 inp_replace_input(input, prev, size);
+                free(prev);
             }
             return 1;
 
@@ -517,6 +572,7 @@ _handle_edit(int result, const wint_t ch, char *input, int *size)
             next = cmd_history_next(input, size);
             if (next) {
                 inp_replace_input(input, next, size);
+                free(next);
             } else if (*size != 0) {
                 input[*size] = '\0';
                 cmd_history_append(input);
@@ -564,6 +620,10 @@ _handle_edit(int result, const wint_t ch, char *input, int *size)
             return 1;
             break;
 
+        case KEY_CTRL_R:
+            _search_start(input, size);
+            return 1;
+
         default:
             return 0;
         }
@@ -573,7 +633,7 @@ _handle_edit(int result, const wint_t ch, char *input, int *size)
 static void
 _handle_backspace(int display_size, int inp_x, int *size, char *input)
 {
-    roster_reset_search_attempts();
+    cmd_reset_autocomplete();
     if (display_size > 0) {
 
         // if at end, delete last char
@@ -764,3 +824,237 @@ _printable(const wint_t ch)
     gunichar unichar = g_utf8_get_char(bytes);
     return g_unichar_isprint(unichar) && (ch != KEY_MOUSE);
 }
+
+/*
+ * Keys while searching history, return 1 if handled, otherwise the search
+ * ends on the current match and the key is handled as usual
+ */
+static int
+_handle_search(int result, const wint_t ch, char *input, int *size)
+{
+    if (result == ERR) {
+        return 1;
+    }
+
+    // next older match
+    if (result != KEY_CODE_YES && ch == KEY_CTRL_R) {
+        _search_update(input, size, search_match);
+        return 1;
+    }
+
+    // cancel, back to the input before searching
+    if (result != KEY_CODE_YES && (ch == KEY_CTRL_G || ch == 27)) {
+        _search_end(input, size, FALSE);
+        return 1;
+    }
+
+    if (ch == 127 || (result == KEY_CODE_YES && ch == KEY_BACKSPACE)) {
+        if (search_str->len > 0) {
+            gchar *last = g_utf8_find_prev_char(search_str->str, search_str->str + search_str->len);
+            g_string_truncate(search_str, last - search_str->str);
+        }
+        _search_update(input, size, cmd_history_length());
+        return 1;
+    }
+
+    // the current match is searched again, it may still match
+    if (result != KEY_CODE_YES && _printable(ch)) {
+        char bytes[MB_CUR_MAX+1];
+        size_t utf_len = wcrtomb(bytes, ch, NULL);
+        if (utf_len < MB_CUR_MAX + 1) {
+            g_string_append_len(search_str, bytes, utf_len);
+        }
+        if (search_match == -1) {
+            _search_update(input, size, cmd_history_length());
+        } else {
+            _search_update(input, size, search_match + 1);
+        }
+        return 1;
+    }
+
+    _search_end(input, size, TRUE);
+    return 0;
+}
+
+static void
+_search_start(char *input, int *size)
+{
+    input[*size] = '\0';
+    searching = TRUE;
+    search_str = g_string_new("");
+    search_match = -1;
+    search_saved = strdup(input);
+    _search_update(input, size, cmd_history_length());
+}
+
+// show the newest match before the given history index, keep the last match if none
+static void
+_search_update(char *input, int *size, int before)
+{
+    gboolean failed = FALSE;
+    if (search_str->len == 0) {
+        search_match = -1;
+        g_strlcpy(input, search_saved, INP_WIN_MAX);
+    } else {
+        int index = cmd_history_search(search_str->str, before);
+        if (index == -1) {
+            failed = TRUE;
+        } else {
+            search_match = index;
+            g_strlcpy(input, cmd_history_get(index), INP_WIN_MAX);
+        }
+    }
+    *size = strlen(input);
+
+    _clear_input();
+    pad_start = 0;
+    if (failed) {
+        waddstr(inp_win, "(failed reverse-i-search)`");
+    } else {
+        waddstr(inp_win, "(reverse-i-search)`");
+    }
+    waddstr(inp_win, search_str->str);
+    waddstr(inp_win, "': ");
+    waddstr(inp_win, input);
+    _inp_win_update_virtual();
+}
+
+static void
+_search_end(char *input, int *size, gboolean accept)
+{
+    if (accept) {
+        input[*size] = '\0';
+        char *match = strdup(input);
+        inp_replace_input(input, match, size);
+        free(match);
+    } else {
+        inp_replace_input(input, search_saved, size);
+    }
+
+    searching = FALSE;
+    g_string_free(search_str, TRUE);
+    search_str = NULL;
+    search_match = -1;
+    free(search_saved);
+    search_saved = NULL;
+}
+
+static int
+_paste_key(const char * const sequence, int fallback)
+{
+    int code = key_defined(sequence);
+    if (code > 0) {
+        return code;
+    }
+
+    define_key(sequence, fallback);
+    return fallback;
+}
+
+/*
+ * Read pasted text up to the end of the bracketed paste and insert it at the
+ * cursor with a single redraw, return TRUE if the input should be sent as a
+ * multi-line message instead
+ */
+static gboolean
+_handle_paste(char *input, int *size)
+{
+    GString *paste = g_string_new("");
+    gboolean after_cr = FALSE;
+    // how much of the end sequence has arrived as plain characters
+    int end_matched = 0;
+    wint_t ch;
+    int result;
+
+    // a large paste can arrive in pieces, so only stop early at the end sequence
+    wtimeout(inp_win, PASTE_TIMEOUT_MS);
+    while ((result = wget_wch(inp_win, &ch)) != ERR) {
+        if (result == KEY_CODE_YES) {
+            if (ch == paste_end_key) {
+                break;
+            }
+            continue;
+        }
+
+        // the end sequence split across reads is not recognised as a key
+        if (ch == PASTE_END[end_matched]) {
+            end_matched++;
+        } else {
+            end_matched = (ch == PASTE_END[0]) ? 1 : 0;
+        }
+        if (end_matched == (int)strlen(PASTE_END)) {
+            // the escape was never appended
+            g_string_truncate(paste, paste->len - (strlen(PASTE_END) - 1));
+            break;
+        }
+
+        if (ch == '\r' || (ch == '\n' && !after_cr)) {
+            g_string_append_c(paste, '\n');
+        } else if (ch == '\t') {
+            g_string_append_c(paste, ' ');
+        } else if (ch != '\n' && _printable(ch)) {
+            char bytes[MB_CUR_MAX+1];
+            size_t utf_len = wcrtomb(bytes, ch, NULL);
+            if (utf_len != (size_t) -1) {
+                g_string_append_len(paste, bytes, utf_len);
+            }
+        }
+        after_cr = (ch == '\r');
+    }
+    inp_non_block();
+
+    while (paste->len > 0 && paste->str[paste->len - 1] == '\n') {
+        g_string_truncate(paste, paste->len - 1);
+    }
+
+    // keep what fits, without splitting a character
+    int space = INP_WIN_MAX - 1 - *size;
+    if (space < 0) {
+        space = 0;
+    }
+    if (paste->len > space) {
+        const gchar *end = NULL;
+        g_utf8_validate(paste->str, space, &end);
+        g_string_truncate(paste, end - paste->str);
+    }
+
+    if (paste->len == 0) {
+        g_string_free(paste, TRUE);
+        return FALSE;
+    }
+
+    input[*size] = '\0';
+    int inp_x = getcurx(inp_win);
+    char *next_ch = g_utf8_offset_to_pointer(input, inp_x);
+    memmove(next_ch + paste->len, next_ch, strlen(next_ch) + 1);
+    memcpy(next_ch, paste->str, paste->len);
+    *size += paste->len;
+
+    // commands are never sent with line breaks
+    gboolean send = strchr(paste->str, '\n') != NULL
+        && prefs_get_boolean(PREF_MULTILINE)
+        && input[0] != '/';
+    if (send) {
+        g_string_free(paste, TRUE);
+        return TRUE;
+    }
+
+    char *nl;
+    for (nl = strchr(input, '\n'); nl != NULL; nl = strchr(nl, '\n')) {
+        *nl = ' ';
+    }
+
+    int cursor = inp_x + g_utf8_strlen(paste->str, -1);
+    g_string_free(paste, TRUE);
+
+    _clear_input();
+    waddstr(inp_win, input);
+    wmove(inp_win, 0, cursor);
+    if (cursor - pad_start > cols - 2) {
+        pad_start = cursor - cols + 2;
+    }
+    _inp_win_update_virtual();
+    cmd_reset_autocomplete();
+
+    return FALSE;
+}
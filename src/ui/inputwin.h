@@ -36,6 +36,7 @@
 #define UI_INPUTWIN_H
 
 void create_input_window(void);
+void inp_close(void);
 wint_t inp_get_char(char *input, int *size, int *result);
 void inp_win_reset(void);
 void inp_win_resize(void);
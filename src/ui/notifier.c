@@ -48,13 +48,28 @@
 #include "log.h"
 #include "muc.h"
 #include "ui/ui.h"
-
-static void _notify(const char * const message, int timeout,
+#include "ui/notify_queue.h"
+#include "tools/worker.h"
+
+typedef struct notify_job_t {
+    char *message;
+    int timeout;
+    const char *category;
+    char *error;
+} NotifyJob;
+
+static gboolean showing = FALSE;
+
+static gint64 _now(void);
+static void _notify_job(gpointer data);
+static void _notify_done(gpointer data);
+static char* _notify(const char * const message, int timeout,
     const char * const category);
 
 void
 notifier_uninit(void)
 {
+    notify_queue_clear();
 #ifdef HAVE_LIBNOTIFY
     if (notify_is_initted()) {
         notify_uninit();
@@ -62,13 +77,38 @@ notifier_uninit(void)
 #endif
 }
 
+/*
+ * Notifications are queued and shown one at a time from a worker thread,
+ * as showing one may block on D-Bus
+ */
 void
-notify_typing(const char * const handle)
+notifier_tick(void)
 {
-    char message[strlen(handle) + 1 + 11];
-    sprintf(message, "%s: typing...", handle);
+    if (showing) {
+        return;
+    }
 
-    _notify(message, 10000, "Incoming message");
+    NotifyQueueItem *item = notify_queue_next(_now());
+    if (item == NULL) {
+        return;
+    }
+
+    NotifyJob *job = malloc(sizeof(NotifyJob));
+    job->message = g_strdup(item->message);
+    job->timeout = item->timeout;
+    job->category = item->category;
+    job->error = NULL;
+    notify_queue_item_free(item);
+
+    log_debug("Attempting notification: %s", job->message);
+    showing = TRUE;
+    worker_run(_notify_job, _notify_done, job);
+}
+
+void
+notify_typing(const char * const handle)
+{
+    notify_queue_typing(handle, _now());
 }
 
 void
@@ -83,7 +123,7 @@ notify_invite(const char * const from, const char * const room,
         g_string_append_printf(message, "\n\"%s\"", reason);
     }
 
-    _notify(message->str, 10000, "Incoming message");
+    notify_queue_add(NULL, message->str, NULL, NULL, 10000, 0, "Incoming message", _now());
 
     g_string_free(message, TRUE);
 }
@@ -91,29 +131,13 @@ notify_invite(const char * const from, const char * const room,
 void
 notify_message(const char * const handle, int win, const char * const text)
 {
-    GString *message = g_string_new("");
-    g_string_append_printf(message, "%s (win %d)", handle, win);
-    if (text != NULL) {
-        g_string_append_printf(message, "\n%s", text);
-    }
-
-    _notify(message->str, 10000, "incoming message");
-
-    g_string_free(message, TRUE);
+    notify_queue_message(handle, win, text, _now());
 }
 
 void
 notify_room_message(const char * const handle, const char * const room, int win, const char * const text)
 {
-    GString *message = g_string_new("");
-    g_string_append_printf(message, "%s in %s (win %d)", handle, room, win);
-    if (text != NULL) {
-        g_string_append_printf(message, "\n%s", text);
-    }
-
-    _notify(message->str, 10000, "incoming message");
-
-    g_string_free(message, TRUE);
+    notify_queue_room_message(handle, room, win, text, _now());
 }
 
 void
@@ -121,7 +145,7 @@ notify_subscription(const char * const from)
 {
     GString *message = g_string_new("Subscription request: \n");
     g_string_append(message, from);
-    _notify(message->str, 10000, "Incoming message");
+    notify_queue_add(NULL, message->str, NULL, NULL, 10000, 0, "Incoming message", _now());
     g_string_free(message, TRUE);
 }
 
@@ -164,26 +188,58 @@ notify_remind(void)
     }
 
     if ((unread > 0) || (open > 0) || (subs > 0)) {
-        _notify(text->str, 5000, "Incoming message");
+        notify_queue_add("remind", text->str, NULL, NULL, 5000, 0, "Incoming message", _now());
     }
 
     g_string_free(text, TRUE);
 }
 
+static gint64
+_now(void)
+{
+    return g_get_monotonic_time() / 1000;
+}
+
+static void
+_notify_job(gpointer data)
+{
+    NotifyJob *job = data;
+    job->error = _notify(job->message, job->timeout, job->category);
+}
+
 static void
+_notify_done(gpointer data)
+{
+    NotifyJob *job = data;
+    if (job->error != NULL) {
+        log_error("Error sending desktop notification:");
+        log_error("  -> Message : %s", job->message);
+        log_error("  -> Error   : %s", job->error);
+    } else {
+        log_debug("Notification sent.");
+    }
+
+    showing = FALSE;
+
+    g_free(job->message);
+    g_free(job->error);
+    free(job);
+}
+
+/*
+ * Runs on a worker thread, so returns any error to be logged rather than
+ * logging it
+ */
+static char*
 _notify(const char * const message, int timeout,
     const char * const category)
 {
+    char *error = NULL;
 #ifdef HAVE_LIBNOTIFY
-    log_debug("Attempting notification: %s", message);
     if (notify_is_initted()) {
-        log_debug("Reinitialising libnotify");
         notify_uninit();
-        notify_init("Profanity");
-    } else {
-        log_debug("Initialising libnotify");
-        notify_init("Profanity");
     }
+    notify_init("Profanity");
     if (notify_is_initted()) {
         NotifyNotification *notification;
         notification = notify_notification_new("Profanity", message, NULL);
@@ -191,18 +247,16 @@ _notify(const char * const message, int timeout,
         notify_notification_set_category(notification, category);
         notify_notification_set_urgency(notification, NOTIFY_URGENCY_NORMAL);
 
-        GError *error = NULL;
-        gboolean notify_success = notify_notification_show(notification, &error);
+        GError *show_error = NULL;
+        gboolean notify_success = notify_notification_show(notification, &show_error);
 
         if (!notify_success) {
-            log_error("Error sending desktop notification:");
-            log_error("  -> Message : %s", message);
-            log_error("  -> Error   : %s", error->message);
-        } else {
-	    log_debug("Notification sent.");
-	}
+            error = g_strdup(show_error->message);
+            g_error_free(show_error);
+        }
+        g_object_unref(G_OBJECT(notification));
     } else {
-        log_error("Libnotify not initialised.");
+        error = g_strdup("Libnotify not initialised.");
     }
 #endif
 #ifdef PLATFORM_CYGWIN
@@ -267,9 +321,11 @@ _notify(const char * const message, int timeout,
 
     int res = system(notify_command->str);
     if (res == -1) {
-        log_error("Could not send desktop notificaion.");
+        error = g_strdup("Could not run terminal-notifier.");
     }
 
     g_string_free(notify_command, TRUE);
 #endif
+
+    return error;
 }
\ No newline at end of file
@@ -0,0 +1,356 @@
+/*
+ * notify_queue.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "log.h"
+#include "ui/notify_queue.h"
+
+typedef struct notification_t {
+    // queued notifications with the same key are merged
+    char *key;
+    char *message;
+    // how merged notifications are described, NULL to show only the latest
+    char *merged;
+    char *latest;
+    int count;
+    int timeout;
+    int interval;
+    const char *category;
+    gint64 queued;
+} Notification;
+
+// when a key was last shown, kept only while it holds back repeats
+typedef struct shown_t {
+    gint64 at;
+    int interval;
+} Shown;
+
+static GList *queue = NULL;
+static GHashTable *shown = NULL;
+static gint64 last_shown = 0;
+static gboolean any_shown = FALSE;
+
+static void _unqueue(const char * const key);
+static gboolean _recently_shown(const char * const key, int interval, gint64 now);
+static void _prune_shown(gint64 now);
+static NotifyQueueItem* _item_new(Notification *notification);
+static void _notification_free(Notification *notification);
+
+void
+notify_queue_add(const char * const key, const char * const message,
+    const char * const merged, const char * const latest, int timeout,
+    int interval, const char * const category, gint64 now)
+{
+    if (key != NULL) {
+        GList *curr = queue;
+        while (curr) {
+            Notification *notification = curr->data;
+            if (g_strcmp0(notification->key, key) == 0) {
+                notification->count++;
+                free(notification->message);
+                notification->message = strdup(message);
+                free(notification->latest);
+                notification->latest = latest ? strdup(latest) : NULL;
+                return;
+            }
+            curr = g_list_next(curr);
+        }
+    }
+
+    if (g_list_length(queue) >= NOTIFY_QUEUE_MAX) {
+        Notification *oldest = queue->data;
+        log_debug("Notification queue full, dropping: %s", oldest->message);
+        queue = g_list_delete_link(queue, queue);
+        _notification_free(oldest);
+    }
+
+    Notification *notification = malloc(sizeof(Notification));
+    notification->key = key ? strdup(key) : NULL;
+    notification->message = strdup(message);
+    notification->merged = merged ? strdup(merged) : NULL;
+    notification->latest = latest ? strdup(latest) : NULL;
+    notification->count = 1;
+    notification->timeout = timeout;
+    notification->interval = interval;
+    notification->category = category;
+    notification->queued = now;
+
+    queue = g_list_append(queue, notification);
+}
+
+void
+notify_queue_typing(const char * const handle, gint64 now)
+{
+    GString *key = g_string_new("typing:");
+    g_string_append(key, handle);
+
+    // still showing from last time
+    if (!_recently_shown(key->str, NOTIFY_TYPING_MS, now)) {
+        char message[strlen(handle) + 1 + 11];
+        sprintf(message, "%s: typing...", handle);
+
+        notify_queue_add(key->str, message, NULL, NULL, NOTIFY_TYPING_MS, NOTIFY_TYPING_MS,
+            "Incoming message", now);
+    }
+
+    g_string_free(key, TRUE);
+}
+
+void
+notify_queue_message(const char * const handle, int win, const char * const text, gint64 now)
+{
+    GString *message = g_string_new("");
+    g_string_append_printf(message, "%s (win %d)", handle, win);
+    if (text != NULL) {
+        g_string_append_printf(message, "\n%s", text);
+    }
+    GString *merged = g_string_new("");
+    g_string_append_printf(merged, "from %s (win %d)", handle, win);
+    GString *key = g_string_new("");
+    g_string_append_printf(key, "win:%d", win);
+
+    // the message says more than the typing notification before it
+    GString *typing_key = g_string_new("typing:");
+    g_string_append(typing_key, handle);
+    _unqueue(typing_key->str);
+    g_string_free(typing_key, TRUE);
+
+    notify_queue_add(key->str, message->str, merged->str, text, 10000, NOTIFY_WIN_INTERVAL_MS,
+        "incoming message", now);
+
+    g_string_free(key, TRUE);
+    g_string_free(merged, TRUE);
+    g_string_free(message, TRUE);
+}
+
+void
+notify_queue_room_message(const char * const handle, const char * const room, int win,
+    const char * const text, gint64 now)
+{
+    GString *message = g_string_new("");
+    g_string_append_printf(message, "%s in %s (win %d)", handle, room, win);
+    if (text != NULL) {
+        g_string_append_printf(message, "\n%s", text);
+    }
+    GString *merged = g_string_new("");
+    g_string_append_printf(merged, "in %s (win %d)", room, win);
+    GString *latest = NULL;
+    if (text != NULL) {
+        latest = g_string_new("");
+        g_string_append_printf(latest, "%s: %s", handle, text);
+    }
+    GString *key = g_string_new("");
+    g_string_append_printf(key, "win:%d", win);
+
+    notify_queue_add(key->str, message->str, merged->str, latest ? latest->str : NULL,
+        10000, NOTIFY_WIN_INTERVAL_MS, "incoming message", now);
+
+    g_string_free(key, TRUE);
+    if (latest != NULL) {
+        g_string_free(latest, TRUE);
+    }
+    g_string_free(merged, TRUE);
+    g_string_free(message, TRUE);
+}
+
+/*
+ * Take the first notification that has waited long enough for more of the
+ * same and whose key was not shown too recently, at most one per
+ * NOTIFY_MIN_INTERVAL_MS
+ */
+NotifyQueueItem*
+notify_queue_next(gint64 now)
+{
+    _prune_shown(now);
+
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    if (any_shown && now - last_shown < NOTIFY_MIN_INTERVAL_MS) {
+        return NULL;
+    }
+
+    GList *curr = queue;
+    while (curr) {
+        Notification *notification = curr->data;
+        if (now - notification->queued >= NOTIFY_COALESCE_MS &&
+                !_recently_shown(notification->key, notification->interval, now)) {
+            queue = g_list_delete_link(queue, curr);
+
+            if (notification->key != NULL && notification->interval > 0) {
+                if (shown == NULL) {
+                    shown = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+                }
+                Shown *last = malloc(sizeof(Shown));
+                last->at = now;
+                last->interval = notification->interval;
+                g_hash_table_replace(shown, strdup(notification->key), last);
+            }
+            last_shown = now;
+            any_shown = TRUE;
+
+            NotifyQueueItem *item = _item_new(notification);
+            _notification_free(notification);
+
+            return item;
+        }
+        curr = g_list_next(curr);
+    }
+
+    return NULL;
+}
+
+void
+notify_queue_item_free(NotifyQueueItem *item)
+{
+    if (item) {
+        g_free(item->message);
+        free(item);
+    }
+}
+
+guint
+notify_queue_length(void)
+{
+    return g_list_length(queue);
+}
+
+guint
+notify_queue_shown_count(void)
+{
+    if (shown == NULL) {
+        return 0;
+    }
+
+    return g_hash_table_size(shown);
+}
+
+void
+notify_queue_clear(void)
+{
+    g_list_free_full(queue, (GDestroyNotify)_notification_free);
+    queue = NULL;
+    if (shown != NULL) {
+        g_hash_table_destroy(shown);
+        shown = NULL;
+    }
+    last_shown = 0;
+    any_shown = FALSE;
+}
+
+static void
+_unqueue(const char * const key)
+{
+    GList *curr = queue;
+    while (curr) {
+        Notification *notification = curr->data;
+        if (g_strcmp0(notification->key, key) == 0) {
+            queue = g_list_delete_link(queue, curr);
+            _notification_free(notification);
+            return;
+        }
+        curr = g_list_next(curr);
+    }
+}
+
+static gboolean
+_recently_shown(const char * const key, int interval, gint64 now)
+{
+    if (key == NULL || shown == NULL) {
+        return FALSE;
+    }
+
+    Shown *last = g_hash_table_lookup(shown, key);
+    if (last == NULL) {
+        return FALSE;
+    }
+
+    return (now - last->at < interval);
+}
+
+// keys no longer holding anything back are forgotten
+static void
+_prune_shown(gint64 now)
+{
+    if (shown == NULL) {
+        return;
+    }
+
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, shown);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        Shown *last = value;
+        if (now - last->at >= last->interval) {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+}
+
+static NotifyQueueItem*
+_item_new(Notification *notification)
+{
+    NotifyQueueItem *item = malloc(sizeof(NotifyQueueItem));
+    if (notification->count > 1 && notification->merged != NULL) {
+        GString *message = g_string_new("");
+        g_string_append_printf(message, "%d new messages %s", notification->count, notification->merged);
+        if (notification->latest != NULL) {
+            g_string_append_printf(message, "\n%s", notification->latest);
+        }
+        item->message = g_string_free(message, FALSE);
+    } else {
+        item->message = g_strdup(notification->message);
+    }
+    item->timeout = notification->timeout;
+    item->category = notification->category;
+
+    return item;
+}
+
+static void
+_notification_free(Notification *notification)
+{
+    free(notification->key);
+    free(notification->message);
+    free(notification->merged);
+    free(notification->latest);
+    free(notification);
+}
@@ -0,0 +1,76 @@
+/*
+ * notify_queue.h
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef UI_NOTIFY_QUEUE_H
+#define UI_NOTIFY_QUEUE_H
+
+#include <glib.h>
+
+// wait this long for more of the same before showing anything
+#define NOTIFY_COALESCE_MS 500
+// at most one notification this often
+#define NOTIFY_MIN_INTERVAL_MS 1000
+// at most one notification per window this often
+#define NOTIFY_WIN_INTERVAL_MS 5000
+// a typing notification stays up this long, repeats are dropped until then
+#define NOTIFY_TYPING_MS 10000
+#define NOTIFY_QUEUE_MAX 32
+
+// a notification ready to be shown
+typedef struct notify_queue_item_t {
+    char *message;
+    int timeout;
+    const char *category;
+} NotifyQueueItem;
+
+// queue a notification, one with the same key still queued is merged into it,
+// times are in milliseconds from any fixed point
+void notify_queue_add(const char * const key, const char * const message,
+    const char * const merged, const char * const latest, int timeout,
+    int interval, const char * const category, gint64 now);
+
+void notify_queue_typing(const char * const handle, gint64 now);
+void notify_queue_message(const char * const handle, int win, const char * const text, gint64 now);
+void notify_queue_room_message(const char * const handle, const char * const room, int win,
+    const char * const text, gint64 now);
+
+// the next notification due, or NULL, freed with notify_queue_item_free
+NotifyQueueItem* notify_queue_next(gint64 now);
+void notify_queue_item_free(NotifyQueueItem *item);
+
+guint notify_queue_length(void);
+guint notify_queue_shown_count(void);
+void notify_queue_clear(void);
+
+#endif
@@ -40,81 +40,69 @@
 #include "config/preferences.h"
 
 static void
-_occuptantswin_occupant(ProfLayoutSplit *layout, Occupant *occupant)
+_occuptantswin_occupant(GPtrArray *rows, Occupant *occupant)
 {
     const char *presence_str = string_from_resource_presence(occupant->presence);
     theme_item_t presence_colour = theme_main_presence_attrs(presence_str);
-    wattron(layout->subwin, theme_attrs(presence_colour));
+    win_sub_rows_add(rows, presence_colour, "   ", occupant->nick);
+}
 
-    GString *msg = g_string_new("   ");
-    g_string_append(msg, occupant->nick);
-    win_printline_nowrap(layout->subwin, msg->str);
-    g_string_free(msg, TRUE);
+static void
+_occupantswin_role(GPtrArray *rows, const char * const roomjid, muc_role_t role, char *title)
+{
+    win_sub_rows_add(rows, THEME_OCCUPANTS_HEADER, "", title);
 
-    wattroff(layout->subwin, theme_attrs(presence_colour));
+    GSList *occupants = muc_occupants_by_role(roomjid, role);
+    GSList *curr = occupants;
+    while (curr) {
+        _occuptantswin_occupant(rows, curr->data);
+        curr = g_slist_next(curr);
+    }
+    g_slist_free(occupants);
 }
 
+/*
+ * Mark the room's occupants panel as changed, it is rebuilt once on the next
+ * ui update in which the room is shown
+ */
 void
 occupantswin_occupants(const char * const roomjid)
 {
     ProfMucWin *mucwin = wins_get_muc(roomjid);
     if (mucwin) {
-        GList *occupants = muc_roster(roomjid);
-        if (occupants) {
-            ProfLayoutSplit *layout = (ProfLayoutSplit*)mucwin->window.layout;
-            assert(layout->memcheck == LAYOUT_SPLIT_MEMCHECK);
+        ProfLayoutSplit *layout = (ProfLayoutSplit*)mucwin->window.layout;
+        assert(layout->memcheck == LAYOUT_SPLIT_MEMCHECK);
+        layout->sub_dirty = TRUE;
+    }
+}
 
-            werase(layout->subwin);
+void
+occupantswin_draw(ProfMucWin *mucwin)
+{
+    ProfLayoutSplit *layout = (ProfLayoutSplit*)mucwin->window.layout;
+    assert(layout->memcheck == LAYOUT_SPLIT_MEMCHECK);
 
-            if (prefs_get_boolean(PREF_MUC_PRIVILEGES)) {
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_printline_nowrap(layout->subwin, " -Moderators");
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                GList *roster_curr = occupants;
-                while (roster_curr) {
-                    Occupant *occupant = roster_curr->data;
-                    if (occupant->role == MUC_ROLE_MODERATOR) {
-                        _occuptantswin_occupant(layout, occupant);
-                    }
-                    roster_curr = g_list_next(roster_curr);
-                }
+    if (!layout->subwin || !layout->sub_dirty) {
+        return;
+    }
 
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_printline_nowrap(layout->subwin, " -Participants");
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                roster_curr = occupants;
-                while (roster_curr) {
-                    Occupant *occupant = roster_curr->data;
-                    if (occupant->role == MUC_ROLE_PARTICIPANT) {
-                        _occuptantswin_occupant(layout, occupant);
-                    }
-                    roster_curr = g_list_next(roster_curr);
-                }
+    const char *roomjid = mucwin->roomjid;
+    GPtrArray *rows = win_sub_rows_new();
 
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_printline_nowrap(layout->subwin, " -Visitors");
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                roster_curr = occupants;
-                while (roster_curr) {
-                    Occupant *occupant = roster_curr->data;
-                    if (occupant->role == MUC_ROLE_VISITOR) {
-                        _occuptantswin_occupant(layout, occupant);
-                    }
-                    roster_curr = g_list_next(roster_curr);
-                }
-            } else {
-                wattron(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                win_printline_nowrap(layout->subwin, " -Occupants\n");
-                wattroff(layout->subwin, theme_attrs(THEME_OCCUPANTS_HEADER));
-                GList *roster_curr = occupants;
-                while (roster_curr) {
-                    Occupant *occupant = roster_curr->data;
-                    _occuptantswin_occupant(layout, occupant);
-                    roster_curr = g_list_next(roster_curr);
-                }
-            }
+    if (prefs_get_boolean(PREF_MUC_PRIVILEGES)) {
+        _occupantswin_role(rows, roomjid, MUC_ROLE_MODERATOR, " -Moderators");
+        _occupantswin_role(rows, roomjid, MUC_ROLE_PARTICIPANT, " -Participants");
+        _occupantswin_role(rows, roomjid, MUC_ROLE_VISITOR, " -Visitors");
+    } else {
+        win_sub_rows_add(rows, THEME_OCCUPANTS_HEADER, "", " -Occupants");
+        GList *occupants = muc_roster(roomjid);
+        GList *roster_curr = occupants;
+        while (roster_curr) {
+            _occuptantswin_occupant(rows, roster_curr->data);
+            roster_curr = g_list_next(roster_curr);
         }
-
         g_list_free(occupants);
     }
-}
\ No newline at end of file
+
+    win_sub_render(layout, rows);
+}
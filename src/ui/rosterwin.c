@@ -43,7 +43,7 @@
 #include "roster_list.h"
 
 static void
-_rosterwin_contact(ProfLayoutSplit *layout, PContact contact)
+_rosterwin_contact(GPtrArray *rows, PContact contact)
 {
     if (p_contact_subscribed(contact)) {
         const char *name = p_contact_name_or_jid(contact);
@@ -52,13 +52,7 @@ _rosterwin_contact(ProfLayoutSplit *layout, PContact contact)
         if ((g_strcmp0(presence, "offline") != 0) || ((g_strcmp0(presence, "offline") == 0) &&
                 (prefs_get_boolean(PREF_ROSTER_OFFLINE)))) {
             theme_item_t presence_colour = theme_main_presence_attrs(presence);
-
-            wattron(layout->subwin, theme_attrs(presence_colour));
-            GString *msg = g_string_new("   ");
-            g_string_append(msg, name);
-            win_printline_nowrap(layout->subwin, msg->str);
-            g_string_free(msg, TRUE);
-            wattroff(layout->subwin, theme_attrs(presence_colour));
+            win_sub_rows_add(rows, presence_colour, "   ", name);
 
             if (prefs_get_boolean(PREF_ROSTER_RESOURCE)) {
                 GList *resources = p_contact_get_available_resources(contact);
@@ -67,13 +61,7 @@ _rosterwin_contact(ProfLayoutSplit *layout, PContact contact)
                     Resource *resource = curr_resource->data;
                     const char *resource_presence = string_from_resource_presence(resource->presence);
                     theme_item_t resource_presence_colour = theme_main_presence_attrs(resource_presence);
-
-                    wattron(layout->subwin, theme_attrs(resource_presence_colour));
-                    GString *msg = g_string_new("     ");
-                    g_string_append(msg, resource->name);
-                    win_printline_nowrap(layout->subwin, msg->str);
-                    g_string_free(msg, TRUE);
-                    wattroff(layout->subwin, theme_attrs(resource_presence_colour));
+                    win_sub_rows_add(rows, resource_presence_colour, "     ", resource->name);
 
                     curr_resource = g_list_next(curr_resource);
                 }
@@ -84,18 +72,16 @@ _rosterwin_contact(ProfLayoutSplit *layout, PContact contact)
 }
 
 static void
-_rosterwin_contacts_by_presence(ProfLayoutSplit *layout, const char * const presence, char *title)
+_rosterwin_contacts_by_presence(GPtrArray *rows, const char * const presence, char *title)
 {
-    wattron(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
-    win_printline_nowrap(layout->subwin, title);
-    wattroff(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
+    win_sub_rows_add(rows, THEME_ROSTER_HEADER, "", title);
 
     GSList *contacts = roster_get_contacts_by_presence(presence);
     if (contacts) {
         GSList *curr_contact = contacts;
         while (curr_contact) {
             PContact contact = curr_contact->data;
-            _rosterwin_contact(layout, contact);
+            _rosterwin_contact(rows, contact);
             curr_contact = g_slist_next(curr_contact);
         }
     }
@@ -103,21 +89,16 @@ _rosterwin_contacts_by_presence(ProfLayoutSplit *layout, const char * const pres
 }
 
 static void
-_rosterwin_contacts_by_group(ProfLayoutSplit *layout, char *group)
+_rosterwin_contacts_by_group(GPtrArray *rows, char *group)
 {
-    wattron(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
-    GString *title = g_string_new(" -");
-    g_string_append(title, group);
-    win_printline_nowrap(layout->subwin, title->str);
-    g_string_free(title, TRUE);
-    wattroff(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
+    win_sub_rows_add(rows, THEME_ROSTER_HEADER, " -", group);
 
     GSList *contacts = roster_get_group(group);
     if (contacts) {
         GSList *curr_contact = contacts;
         while (curr_contact) {
             PContact contact = curr_contact->data;
-            _rosterwin_contact(layout, contact);
+            _rosterwin_contact(rows, contact);
             curr_contact = g_slist_next(curr_contact);
         }
     }
@@ -125,24 +106,26 @@ _rosterwin_contacts_by_group(ProfLayoutSplit *layout, char *group)
 }
 
 static void
-_rosterwin_contacts_by_no_group(ProfLayoutSplit *layout)
+_rosterwin_contacts_by_no_group(GPtrArray *rows)
 {
     GSList *contacts = roster_get_nogroup();
     if (contacts) {
-        wattron(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
-        win_printline_nowrap(layout->subwin, " -no group");
-        wattroff(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
+        win_sub_rows_add(rows, THEME_ROSTER_HEADER, "", " -no group");
 
         GSList *curr_contact = contacts;
         while (curr_contact) {
             PContact contact = curr_contact->data;
-            _rosterwin_contact(layout, contact);
+            _rosterwin_contact(rows, contact);
             curr_contact = g_slist_next(curr_contact);
         }
     }
     g_slist_free(contacts);
 }
 
+/*
+ * Mark the roster panel as changed, it is rebuilt once on the next ui update
+ * however many changes arrive before it
+ */
 void
 rosterwin_roster(void)
 {
@@ -150,46 +133,59 @@ rosterwin_roster(void)
     if (console) {
         ProfLayoutSplit *layout = (ProfLayoutSplit*)console->layout;
         assert(layout->memcheck == LAYOUT_SPLIT_MEMCHECK);
+        layout->sub_dirty = TRUE;
+    }
+}
 
-       char *by = prefs_get_string(PREF_ROSTER_BY);
+void
+rosterwin_draw(void)
+{
+    ProfWin *console = wins_get_console();
+    if (console) {
+        ProfLayoutSplit *layout = (ProfLayoutSplit*)console->layout;
+        assert(layout->memcheck == LAYOUT_SPLIT_MEMCHECK);
+
+        if (!layout->subwin || !layout->sub_dirty) {
+            return;
+        }
+
+        GPtrArray *rows = win_sub_rows_new();
+
+        char *by = prefs_get_string(PREF_ROSTER_BY);
         if (g_strcmp0(by, "presence") == 0) {
-            werase(layout->subwin);
-            _rosterwin_contacts_by_presence(layout, "chat", " -Available for chat");
-            _rosterwin_contacts_by_presence(layout, "online", " -Online");
-            _rosterwin_contacts_by_presence(layout, "away", " -Away");
-            _rosterwin_contacts_by_presence(layout, "xa", " -Extended Away");
-            _rosterwin_contacts_by_presence(layout, "dnd", " -Do not disturb");
+            _rosterwin_contacts_by_presence(rows, "chat", " -Available for chat");
+            _rosterwin_contacts_by_presence(rows, "online", " -Online");
+            _rosterwin_contacts_by_presence(rows, "away", " -Away");
+            _rosterwin_contacts_by_presence(rows, "xa", " -Extended Away");
+            _rosterwin_contacts_by_presence(rows, "dnd", " -Do not disturb");
             if (prefs_get_boolean(PREF_ROSTER_OFFLINE)) {
-                _rosterwin_contacts_by_presence(layout, "offline", " -Offline");
+                _rosterwin_contacts_by_presence(rows, "offline", " -Offline");
             }
         } else if (g_strcmp0(by, "group") == 0) {
-            werase(layout->subwin);
             GSList *groups = roster_get_groups();
             GSList *curr_group = groups;
             while (curr_group) {
-                _rosterwin_contacts_by_group(layout, curr_group->data);
+                _rosterwin_contacts_by_group(rows, curr_group->data);
                 curr_group = g_slist_next(curr_group);
             }
             g_slist_free_full(groups, free);
-            _rosterwin_contacts_by_no_group(layout);
+            _rosterwin_contacts_by_no_group(rows);
         } else {
             GSList *contacts = roster_get_contacts();
             if (contacts) {
-                werase(layout->subwin);
-
-                wattron(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
-                win_printline_nowrap(layout->subwin, " -Roster");
-                wattroff(layout->subwin, theme_attrs(THEME_ROSTER_HEADER));
+                win_sub_rows_add(rows, THEME_ROSTER_HEADER, "", " -Roster");
 
                 GSList *curr_contact = contacts;
                 while (curr_contact) {
                     PContact contact = curr_contact->data;
-                    _rosterwin_contact(layout, contact);
+                    _rosterwin_contact(rows, contact);
                     curr_contact = g_slist_next(curr_contact);
                 }
             }
             g_slist_free(contacts);
         }
         free(by);
+
+        win_sub_render(layout, rows);
     }
-}
\ No newline at end of file
+}
@@ -35,6 +35,7 @@
 #include "config.h"
 
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -50,6 +51,7 @@
 #include "ui/inputwin.h"
 
 #define TIME_CHECK 60000000
+#define RTT_WIDTH 9
 
 static WINDOW *status_bar;
 static char *message = NULL;
@@ -62,12 +64,15 @@ static int is_new[12];
 static GHashTable *remaining_new;
 static GDateTime *last_time;
 static int current;
+static int rtt = -1;
+static int rtt_width = 0;
 
 static void _update_win_statuses(void);
 static void _mark_new(int num);
 static void _mark_active(int num);
 static void _mark_inactive(int num);
 static void _status_bar_draw(void);
+static void _status_bar_draw_rtt(void);
 
 void
 create_status_bar(void)
@@ -348,6 +353,12 @@ status_bar_clear_message(void)
     _status_bar_draw();
 }
 
+void
+status_bar_set_rtt(const int millis)
+{
+    rtt = millis;
+}
+
 static void
 _update_win_statuses(void)
 {
@@ -430,7 +441,50 @@ _status_bar_draw(void)
     wattroff(status_bar, bracket_attrs);
     g_free(date_fmt);
 
+    _status_bar_draw_rtt();
+
     _update_win_statuses();
     wnoutrefresh(status_bar);
     inp_put_back();
 }
+
+/*
+ * Last autoping round trip, right aligned to the left of the window
+ * indicators, drawn only when known and clear of the message
+ */
+static void
+_status_bar_draw_rtt(void)
+{
+    int cols = getmaxx(stdscr);
+    int rtt_end = cols - 35;
+    int message_end = message == NULL ? 8 : 10 + strlen(message);
+
+    // clear the last round trip drawn, unless a message now covers it
+    if (rtt_width > 0 && rtt_end - rtt_width > message_end) {
+        mvwprintw(status_bar, 0, rtt_end - rtt_width, "%*s", rtt_width, "");
+    }
+    rtt_width = 0;
+
+    if (rtt < 0) {
+        return;
+    }
+
+    char rtt_str[RTT_WIDTH + 1];
+    snprintf(rtt_str, sizeof(rtt_str), "%dms", MIN(rtt, 99999));
+    int width = strlen(rtt_str) + 2;
+    int rtt_pos = rtt_end - width;
+    if (rtt_pos <= message_end) {
+        return;
+    }
+
+    int bracket_attrs = theme_attrs(THEME_STATUS_BRACKET);
+    wattron(status_bar, bracket_attrs);
+    mvwaddch(status_bar, 0, rtt_pos, '[');
+    wattroff(status_bar, bracket_attrs);
+    mvwprintw(status_bar, 0, rtt_pos + 1, "%s", rtt_str);
+    wattron(status_bar, bracket_attrs);
+    mvwaddch(status_bar, 0, rtt_pos + width - 1, ']');
+    wattroff(status_bar, bracket_attrs);
+
+    rtt_width = width;
+}
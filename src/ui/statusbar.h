@@ -47,5 +47,6 @@ void status_bar_active(const int win);
 void status_bar_new(const int win);
 void status_bar_set_all_inactive(void);
 void status_bar_current(int i);
+void status_bar_set_rtt(const int millis);
 
 #endif
\ No newline at end of file
@@ -120,6 +120,7 @@ void ui_incoming_msg(const char * const from, const char * const message, GTimeV
 void ui_incoming_private_msg(const char * const fulljid, const char * const message, GTimeVal *tv_stamp);
 
 void ui_disconnected(void);
+void ui_update_ping_rtt(const int millis);
 void ui_recipient_gone(const char * const barejid);
 
 void ui_outgoing_chat_msg(const char * const from, const char * const barejid,
@@ -143,8 +144,7 @@ void ui_room_occupant_affiliation_change(const char * const roomjid, const char
 void ui_room_occupant_role_and_affiliation_change(const char * const roomjid, const char * const nick, const char * const role,
     const char * const affiliation, const char * const actor, const char * const reason);
 void ui_room_roster(const char * const roomjid, GList *occupants, const char * const presence);
-void ui_room_history(const char * const roomjid, const char * const nick,
-    GTimeVal tv_stamp, const char * const message);
+void ui_room_history_batch(const char * const roomjid, GList *history);
 void ui_room_message(const char * const roomjid, const char * const nick,
     const char * const message);
 void ui_room_subject(const char * const roomjid, const char * const nick, const char * const subject);
@@ -185,7 +185,7 @@ void ui_contact_not_in_group(const char * const contact, const char * const grou
 void ui_group_added(const char * const contact, const char * const group);
 void ui_group_removed(const char * const contact, const char * const group);
 void ui_chat_win_contact_online(PContact contact, Resource *resource, GDateTime *last_activity);
-void ui_chat_win_contact_offline(PContact contact, char *resource, char *status);
+void ui_chat_win_contact_offline(PContact contact, const char * const resource, const char * const status);
 void ui_handle_recipient_not_found(const char * const recipient, const char * const err_msg);
 void ui_handle_recipient_error(const char * const recipient, const char * const err_msg);
 void ui_handle_error(const char * const err_msg);
@@ -235,6 +235,9 @@ void ui_replace_input(char *input, const char * const new_input, int *size);
 void ui_invalid_command_usage(const char * const usage, void (*setting_func)(void));
 
 void ui_create_xmlconsole_win(void);
+void ui_show_mentions(void);
+void ui_clear_mentions(void);
+void ui_highlights_changed(void);
 gboolean ui_xmlconsole_exists(void);
 void ui_open_xmlconsole_win(void);
 
@@ -276,6 +279,8 @@ void cons_show_room_list(GSList *room, const char * const conference_node);
 void cons_show_bookmarks(const GList *list);
 void cons_show_disco_items(GSList *items, const char * const jid);
 void cons_show_disco_info(const char *from, GSList *identities, GSList *features);
+void cons_show_iq_stats(GList *stats, int outstanding);
+void cons_show_ping_stats(IqStats *rtt_stats, int interval, int last_millis);
 void cons_show_room_invite(const char * const invitor, const char * const room,
     const char * const reason);
 void cons_check_version(gboolean not_available_msg);
@@ -296,7 +301,9 @@ void cons_roster_setting(void);
 void cons_presence_setting(void);
 void cons_wrap_setting(void);
 void cons_time_setting(void);
+void cons_complete_setting(void);
 void cons_mouse_setting(void);
+void cons_multiline_setting(void);
 void cons_statuses_setting(void);
 void cons_titlebar_setting(void);
 void cons_notify_setting(void);
@@ -316,17 +323,20 @@ void cons_priority_setting(void);
 void cons_autoconnect_setting(void);
 void cons_inpblock_setting(void);
 void cons_show_contact_online(PContact contact, Resource *resource, GDateTime *last_activity);
-void cons_show_contact_offline(PContact contact, char *resource, char *status);
+void cons_show_contact_offline(PContact contact, const char * const resource, const char * const status);
 void cons_theme_colours(void);
 
-// roster window
+// roster window, marks it changed, drawn on the next ui update
 void rosterwin_roster(void);
+void rosterwin_draw(void);
 
-// occupants window
+// occupants window, marks it changed, drawn on the next ui update
 void occupantswin_occupants(const char * const room);
+void occupantswin_draw(ProfMucWin *mucwin);
 
 // desktop notifier actions
 void notifier_uninit(void);
+void notifier_tick(void);
 
 void notify_typing(const char * const handle);
 void notify_message(const char * const handle, int win, const char * const text);
@@ -47,6 +47,7 @@
 
 #include "config/theme.h"
 #include "config/preferences.h"
+#include "jid.h"
 #include "roster_list.h"
 #include "ui/ui.h"
 #include "ui/window.h"
@@ -54,12 +55,16 @@
 
 #define CONS_WIN_TITLE "Profanity. Type /help for help information."
 #define XML_WIN_TITLE "XML Console"
+#define MENTIONS_WIN_TITLE "Mentions"
 
 #define CEILING(X) (X-(int)(X) > 0 ? (int)(X+1) : (int)(X))
 
 static void _win_print(ProfWin *window, const char show_char, GDateTime *time,
     int flags, theme_item_t theme_item, const char * const from, const char * const message);
 static void _win_print_wrapped(WINDOW *win, const char * const message);
+static void _win_sub_rows_reset(ProfLayoutSplit *layout);
+static void _win_sub_row_free(ProfSubRow *row);
+static char* _win_account(void);
 
 int
 win_roster_cols(void)
@@ -109,6 +114,9 @@ _win_create_split_layout(void)
     scrollok(layout->base.win, TRUE);
     layout->subwin = NULL;
     layout->sub_y_pos = 0;
+    layout->sub_rows = NULL;
+    layout->sub_dirty = FALSE;
+    _win_sub_rows_reset(layout);
     layout->memcheck = LAYOUT_SPLIT_MEMCHECK;
 
     return &layout->base;
@@ -120,6 +128,7 @@ win_create_console(void)
     ProfConsoleWin *new_win = malloc(sizeof(ProfConsoleWin));
     new_win->window.type = WIN_CONSOLE;
     new_win->window.layout = _win_create_split_layout();
+    new_win->window.account = NULL;
 
     return &new_win->window;
 }
@@ -130,8 +139,10 @@ win_create_chat(const char * const barejid)
     ProfChatWin *new_win = malloc(sizeof(ProfChatWin));
     new_win->window.type = WIN_CHAT;
     new_win->window.layout = _win_create_simple_layout();
+    new_win->window.account = _win_account();
 
-    new_win->barejid = strdup(barejid);
+    // shared with the roster, released in win_free
+    new_win->barejid = (char *)jid_intern(barejid);
     new_win->resource = NULL;
     new_win->is_otr = FALSE;
     new_win->is_trusted = FALSE;
@@ -150,6 +161,7 @@ win_create_muc(const char * const roomjid)
     int cols = getmaxx(stdscr);
 
     new_win->window.type = WIN_MUC;
+    new_win->window.account = _win_account();
 
     ProfLayoutSplit *layout = malloc(sizeof(ProfLayoutSplit));
     layout->base.type = LAYOUT_SPLIT;
@@ -166,6 +178,9 @@ win_create_muc(const char * const roomjid)
         layout->subwin = NULL;
     }
     layout->sub_y_pos = 0;
+    layout->sub_rows = NULL;
+    layout->sub_dirty = FALSE;
+    _win_sub_rows_reset(layout);
     layout->memcheck = LAYOUT_SPLIT_MEMCHECK;
     layout->base.buffer = buffer_create();
     layout->base.y_pos = 0;
@@ -173,8 +188,12 @@ win_create_muc(const char * const roomjid)
     scrollok(layout->base.win, TRUE);
     new_win->window.layout = (ProfLayout*)layout;
 
-    new_win->roomjid = strdup(roomjid);
+    // shared with the room, released in win_free
+    new_win->roomjid = (char *)jid_intern(roomjid);
     new_win->unread = 0;
+    new_win->highlight = NULL;
+    new_win->highlight_nick = NULL;
+    new_win->highlight_version = 0;
 
     new_win->memcheck = PROFMUCWIN_MEMCHECK;
 
@@ -187,8 +206,9 @@ win_create_muc_config(const char * const roomjid, DataForm *form)
     ProfMucConfWin *new_win = malloc(sizeof(ProfMucConfWin));
     new_win->window.type = WIN_MUC_CONFIG;
     new_win->window.layout = _win_create_simple_layout();
+    new_win->window.account = _win_account();
 
-    new_win->roomjid = strdup(roomjid);
+    new_win->roomjid = (char *)jid_intern(roomjid);
     new_win->form = form;
 
     new_win->memcheck = PROFCONFWIN_MEMCHECK;
@@ -202,6 +222,7 @@ win_create_private(const char * const fulljid)
     ProfPrivateWin *new_win = malloc(sizeof(ProfPrivateWin));
     new_win->window.type = WIN_PRIVATE;
     new_win->window.layout = _win_create_simple_layout();
+    new_win->window.account = _win_account();
 
     new_win->fulljid = strdup(fulljid);
     new_win->unread = 0;
@@ -217,12 +238,26 @@ win_create_xmlconsole(void)
     ProfXMLWin *new_win = malloc(sizeof(ProfXMLWin));
     new_win->window.type = WIN_XML;
     new_win->window.layout = _win_create_simple_layout();
+    new_win->window.account = NULL;
 
     new_win->memcheck = PROFXMLWIN_MEMCHECK;
 
     return &new_win->window;
 }
 
+ProfWin*
+win_create_mentions(void)
+{
+    ProfMentionsWin *new_win = malloc(sizeof(ProfMentionsWin));
+    new_win->window.type = WIN_MENTIONS;
+    new_win->window.layout = _win_create_simple_layout();
+    new_win->window.account = NULL;
+
+    new_win->memcheck = PROFMENTIONSWIN_MEMCHECK;
+
+    return &new_win->window;
+}
+
 char *
 win_get_title(ProfWin *window)
 {
@@ -268,6 +303,9 @@ win_get_title(ProfWin *window)
     if (window->type == WIN_XML) {
         return strdup(XML_WIN_TITLE);
     }
+    if (window->type == WIN_MENTIONS) {
+        return strdup(MENTIONS_WIN_TITLE);
+    }
 
     return NULL;
 }
@@ -282,6 +320,8 @@ win_hide_subwin(ProfWin *window)
         }
         layout->subwin = NULL;
         layout->sub_y_pos = 0;
+        _win_sub_rows_reset(layout);
+        layout->sub_dirty = TRUE;
         int cols = getmaxx(stdscr);
         wresize(layout->base.win, PAD_SIZE, cols);
         win_redraw(window);
@@ -311,6 +351,8 @@ win_show_subwin(ProfWin *window)
     ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
     layout->subwin = newpad(PAD_SIZE, subwin_cols);
     wbkgd(layout->subwin, theme_attrs(THEME_TEXT));
+    _win_sub_rows_reset(layout);
+    layout->sub_dirty = TRUE;
     wresize(layout->base.win, PAD_SIZE, cols - subwin_cols);
     win_redraw(window);
 }
@@ -323,6 +365,7 @@ win_free(ProfWin* window)
         if (layout->subwin) {
             delwin(layout->subwin);
         }
+        _win_sub_rows_reset(layout);
         buffer_free(layout->base.buffer);
         delwin(layout->base.win);
     } else {
@@ -332,18 +375,20 @@ win_free(ProfWin* window)
 
     if (window->type == WIN_CHAT) {
         ProfChatWin *chatwin = (ProfChatWin*)window;
-        free(chatwin->barejid);
+        jid_intern_release(chatwin->barejid);
         free(chatwin->resource);
     }
 
     if (window->type == WIN_MUC) {
         ProfMucWin *mucwin = (ProfMucWin*)window;
-        free(mucwin->roomjid);
+        jid_intern_release(mucwin->roomjid);
+        highlight_free(mucwin->highlight);
+        free(mucwin->highlight_nick);
     }
 
     if (window->type == WIN_MUC_CONFIG) {
         ProfMucConfWin *mucconf = (ProfMucConfWin*)window;
-        free(mucconf->roomjid);
+        jid_intern_release(mucconf->roomjid);
         form_destroy(mucconf->form);
     }
 
@@ -352,6 +397,7 @@ win_free(ProfWin* window)
         free(privatewin->fulljid);
     }
 
+    free(window->account);
     free(window);
 }
 
@@ -941,6 +987,21 @@ win_unread(ProfWin *window)
     }
 }
 
+/*
+ * Whether the window was opened with an account other than the one last
+ * connected, such windows are left alone by lookups and don't send
+ */
+gboolean
+win_other_account(ProfWin *window)
+{
+    char *account = jabber_get_account_name();
+    if (window->account == NULL || account == NULL) {
+        return FALSE;
+    }
+
+    return (g_strcmp0(window->account, account) != 0);
+}
+
 void
 win_printline_nowrap(WINDOW *win, char *msg)
 {
@@ -950,4 +1011,139 @@ win_printline_nowrap(WINDOW *win, char *msg)
     waddnstr(win, msg, maxx);
 
     wmove(win, cury+1, 0);
-}
\ No newline at end of file
+}
+
+/*
+ * Forget the rows last drawn to the window's sub window, so the next render
+ * repaints every row, for when the colours change but the rows don't
+ */
+void
+win_sub_invalidate(ProfWin *window)
+{
+    if (window->layout->type == LAYOUT_SPLIT) {
+        ProfLayoutSplit *layout = (ProfLayoutSplit*)window->layout;
+        _win_sub_rows_reset(layout);
+        layout->sub_dirty = TRUE;
+    }
+}
+
+/*
+ * Create an empty row model for a sub window, see win_sub_render
+ */
+GPtrArray*
+win_sub_rows_new(void)
+{
+    return g_ptr_array_new_with_free_func((GDestroyNotify)_win_sub_row_free);
+}
+
+void
+win_sub_rows_add(GPtrArray *rows, theme_item_t theme_item, const char * const indent,
+    const char * const text)
+{
+    ProfSubRow *row = malloc(sizeof(ProfSubRow));
+    row->text = g_strconcat(indent, text, NULL);
+    row->attrs = theme_attrs(theme_item);
+    g_ptr_array_add(rows, row);
+}
+
+/*
+ * Draw rows to the layout's sub window, repainting only those that differ
+ * from the last render, the layout takes ownership of rows
+ */
+void
+win_sub_render(ProfLayoutSplit *layout, GPtrArray *rows)
+{
+    WINDOW *subwin = layout->subwin;
+    if (!subwin) {
+        g_ptr_array_free(rows, TRUE);
+        return;
+    }
+
+    int cols = getmaxx(subwin);
+    int lines = getmaxy(subwin);
+
+    // pad resized since the last render, nothing on it can be trusted
+    gboolean full = (layout->sub_rows == NULL) || (layout->sub_rows_cols != cols) ||
+        (layout->sub_rows_lines != lines);
+    if (full) {
+        werase(subwin);
+    }
+
+    // grow the pad when the rows don't fit, growing keeps its content
+    if ((int)rows->len >= lines) {
+        lines = rows->len + 1;
+        wresize(subwin, lines, cols);
+    }
+
+    int i;
+    for (i = 0; i < (int)rows->len; i++) {
+        ProfSubRow *row = g_ptr_array_index(rows, i);
+        if (!full && i < (int)layout->sub_rows->len) {
+            ProfSubRow *prev = g_ptr_array_index(layout->sub_rows, i);
+            if ((prev->attrs == row->attrs) && (strcmp(prev->text, row->text) == 0)) {
+                continue;
+            }
+        }
+
+        wmove(subwin, i, 0);
+        wclrtoeol(subwin);
+        wattron(subwin, row->attrs);
+        waddnstr(subwin, row->text, cols);
+        wattroff(subwin, row->attrs);
+    }
+
+    // fewer rows than last time, clear the ones left over
+    if (!full) {
+        for (i = rows->len; i < (int)layout->sub_rows->len; i++) {
+            wmove(subwin, i, 0);
+            wclrtoeol(subwin);
+        }
+    }
+
+    // leave the cursor after the last row, paging uses it as the content height
+    wmove(subwin, rows->len, 0);
+
+    int page_space = getmaxy(stdscr) - 4;
+    int max_y_pos = rows->len - page_space;
+    if (max_y_pos < 0) {
+        max_y_pos = 0;
+    }
+    if (layout->sub_y_pos > max_y_pos) {
+        layout->sub_y_pos = max_y_pos;
+    }
+
+    _win_sub_rows_reset(layout);
+    layout->sub_rows = rows;
+    layout->sub_rows_cols = cols;
+    layout->sub_rows_lines = lines;
+    layout->sub_dirty = FALSE;
+}
+
+static void
+_win_sub_rows_reset(ProfLayoutSplit *layout)
+{
+    if (layout->sub_rows) {
+        g_ptr_array_free(layout->sub_rows, TRUE);
+    }
+    layout->sub_rows = NULL;
+    layout->sub_rows_cols = 0;
+    layout->sub_rows_lines = 0;
+}
+
+static void
+_win_sub_row_free(ProfSubRow *row)
+{
+    free(row->text);
+    free(row);
+}
+
+static char*
+_win_account(void)
+{
+    char *account = jabber_get_account_name();
+    if (account) {
+        return strdup(account);
+    } else {
+        return NULL;
+    }
+}
@@ -46,6 +46,7 @@
 #include "contact.h"
 #include "muc.h"
 #include "ui/buffer.h"
+#include "tools/highlight.h"
 #include "xmpp/xmpp.h"
 
 #define NO_ME           1
@@ -62,6 +63,7 @@
 #define PROFPRIVATEWIN_MEMCHECK     77437483
 #define PROFCONFWIN_MEMCHECK        64334685
 #define PROFXMLWIN_MEMCHECK         87333463
+#define PROFMENTIONSWIN_MEMCHECK    43298771
 
 typedef enum {
     LAYOUT_SIMPLE,
@@ -80,10 +82,19 @@ typedef struct prof_layout_simple_t {
     ProfLayout base;
 } ProfLayoutSimple;
 
+typedef struct prof_sub_row_t {
+    char *text;
+    int attrs;
+} ProfSubRow;
+
 typedef struct prof_layout_split_t {
     ProfLayout base;
     WINDOW *subwin;
     int sub_y_pos;
+    GPtrArray *sub_rows;
+    int sub_rows_cols;
+    int sub_rows_lines;
+    gboolean sub_dirty; // rows changed since the last render
     unsigned long memcheck;
 } ProfLayoutSplit;
 
@@ -93,12 +104,14 @@ typedef enum {
     WIN_MUC,
     WIN_MUC_CONFIG,
     WIN_PRIVATE,
-    WIN_XML
+    WIN_XML,
+    WIN_MENTIONS
 } win_type_t;
 
 typedef struct prof_win_t {
     win_type_t type;
     ProfLayout *layout;
+    char *account; // account the window was opened with, NULL when not tied to one
 } ProfWin;
 
 typedef struct prof_console_win_t {
@@ -120,6 +133,9 @@ typedef struct prof_muc_win_t {
     ProfWin window;
     char *roomjid;
     int unread;
+    Highlight highlight;
+    char *highlight_nick;
+    unsigned int highlight_version;
     unsigned long memcheck;
 } ProfMucWin;
 
@@ -142,12 +158,18 @@ typedef struct prof_xml_win_t {
     unsigned long memcheck;
 } ProfXMLWin;
 
+typedef struct prof_mentions_win_t {
+    ProfWin window;
+    unsigned long memcheck;
+} ProfMentionsWin;
+
 ProfWin* win_create_console(void);
 ProfWin* win_create_chat(const char * const barejid);
 ProfWin* win_create_muc(const char * const roomjid);
 ProfWin* win_create_muc_config(const char * const title, DataForm *form);
 ProfWin* win_create_private(const char * const fulljid);
 ProfWin* win_create_xmlconsole(void);
+ProfWin* win_create_mentions(void);
 
 char *win_get_title(ProfWin *window);
 
@@ -174,8 +196,14 @@ void win_show_subwin(ProfWin *window);
 int win_roster_cols(void);
 int win_occpuants_cols(void);
 void win_printline_nowrap(WINDOW *win, char *msg);
+GPtrArray* win_sub_rows_new(void);
+void win_sub_rows_add(GPtrArray *rows, theme_item_t theme_item, const char * const indent,
+    const char * const text);
+void win_sub_render(ProfLayoutSplit *layout, GPtrArray *rows);
+void win_sub_invalidate(ProfWin *window);
 
 int win_unread(ProfWin *window);
+gboolean win_other_account(ProfWin *window);
 gboolean win_has_active_subwin(ProfWin *window);
 
 #endif
@@ -85,7 +85,7 @@ wins_get_chat(const char * const barejid)
 
     while (curr != NULL) {
         ProfWin *window = curr->data;
-        if (window->type == WIN_CHAT) {
+        if (window->type == WIN_CHAT && !win_other_account(window)) {
             ProfChatWin *chatwin = (ProfChatWin*)window;
             if (g_strcmp0(chatwin->barejid, barejid) == 0) {
                 g_list_free(values);
@@ -107,7 +107,7 @@ wins_get_muc_conf(const char * const roomjid)
 
     while (curr != NULL) {
         ProfWin *window = curr->data;
-        if (window->type == WIN_MUC_CONFIG) {
+        if (window->type == WIN_MUC_CONFIG && !win_other_account(window)) {
             ProfMucConfWin *confwin = (ProfMucConfWin*)window;
             if (g_strcmp0(confwin->roomjid, roomjid) == 0) {
                 g_list_free(values);
@@ -129,9 +129,10 @@ wins_get_muc(const char * const roomjid)
 
     while (curr != NULL) {
         ProfWin *window = curr->data;
-        if (window->type == WIN_MUC) {
+        if (window->type == WIN_MUC && !win_other_account(window)) {
             ProfMucWin *mucwin = (ProfMucWin*)window;
             if (g_strcmp0(mucwin->roomjid, roomjid) == 0) {
+                g_list_free(values);
                 return mucwin;
             }
         }
@@ -150,9 +151,10 @@ wins_get_private(const char * const fulljid)
 
     while (curr != NULL) {
         ProfWin *window = curr->data;
-        if (window->type == WIN_PRIVATE) {
+        if (window->type == WIN_PRIVATE && !win_other_account(window)) {
             ProfPrivateWin *privatewin = (ProfPrivateWin*)window;
             if (g_strcmp0(privatewin->fulljid, fulljid) == 0) {
+                g_list_free(values);
                 return privatewin;
             }
         }
@@ -414,6 +416,17 @@ wins_new_xmlconsole(void)
     return newwin;
 }
 
+ProfWin *
+wins_new_mentions(void)
+{
+    GList *keys = g_hash_table_get_keys(windows);
+    int result = get_next_available_win_num(keys);
+    ProfWin *newwin = win_create_mentions();
+    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    g_list_free(keys);
+    return newwin;
+}
+
 ProfWin *
 wins_new_chat(const char * const barejid)
 {
@@ -495,7 +508,8 @@ wins_resize_all(void)
                 }
                 wresize(layout->base.win, PAD_SIZE, cols - subwin_cols);
                 wresize(layout->subwin, PAD_SIZE, subwin_cols);
-                rosterwin_roster();
+                // redrawn in full on the next ui update
+                layout->sub_dirty = TRUE;
             } else {
                 wresize(layout->base.win, PAD_SIZE, cols);
             }
@@ -512,6 +526,18 @@ wins_resize_all(void)
     win_update_virtual(current_win);
 }
 
+void
+wins_sub_invalidate_all(void)
+{
+    GList *values = g_hash_table_get_values(windows);
+    GList *curr = values;
+    while (curr != NULL) {
+        win_sub_invalidate(curr->data);
+        curr = g_list_next(curr);
+    }
+    g_list_free(values);
+}
+
 void
 wins_hide_subwin(ProfWin *window)
 {
@@ -570,6 +596,27 @@ wins_get_xmlconsole(void)
     return NULL;
 }
 
+ProfMentionsWin *
+wins_get_mentions(void)
+{
+    GList *values = g_hash_table_get_values(windows);
+    GList *curr = values;
+
+    while (curr != NULL) {
+        ProfWin *window = curr->data;
+        if (window->type == WIN_MENTIONS) {
+            ProfMentionsWin *mentionswin = (ProfMentionsWin*)window;
+            assert(mentionswin->memcheck == PROFMENTIONSWIN_MEMCHECK);
+            g_list_free(values);
+            return mentionswin;
+        }
+        curr = g_list_next(curr);
+    }
+
+    g_list_free(values);
+    return NULL;
+}
+
 GSList *
 wins_get_chat_recipients(void)
 {
@@ -602,6 +649,7 @@ wins_get_prune_wins(void)
                 window->type != WIN_MUC &&
                 window->type != WIN_MUC_CONFIG &&
                 window->type != WIN_XML &&
+                window->type != WIN_MENTIONS &&
                 window->type != WIN_CONSOLE) {
             result = g_slist_append(result, window);
         }
@@ -758,6 +806,7 @@ wins_create_summary(void)
         GString *muc_string;
         GString *muc_config_string;
         GString *xml_string;
+        GString *mentions_string;
 
         switch (window->type)
         {
@@ -844,9 +893,27 @@ wins_create_summary(void)
 
                 break;
 
+            case WIN_MENTIONS:
+                mentions_string = g_string_new("");
+                g_string_printf(mentions_string, "%d: Mentions", ui_index);
+                result = g_slist_append(result, strdup(mentions_string->str));
+                g_string_free(mentions_string, TRUE);
+
+                break;
+
             default:
                 break;
         }
+
+        // windows left from another account say which
+        if (win_other_account(window)) {
+            GSList *last = g_slist_last(result);
+            GString *tagged = g_string_new(last->data);
+            g_string_append_printf(tagged, " (%s)", window->account);
+            free(last->data);
+            last->data = strdup(tagged->str);
+            g_string_free(tagged, TRUE);
+        }
         curr = g_list_next(curr);
     }
 
@@ -38,6 +38,7 @@
 void wins_init(void);
 
 ProfWin * wins_new_xmlconsole(void);
+ProfWin * wins_new_mentions(void);
 ProfWin * wins_new_chat(const char * const barejid);
 ProfWin * wins_new_muc(const char * const roomjid);
 ProfWin * wins_new_muc_config(const char * const roomjid, DataForm *form);
@@ -49,6 +50,7 @@ ProfMucWin * wins_get_muc(const char * const roomjid);
 ProfMucConfWin * wins_get_muc_conf(const char * const roomjid);
 ProfPrivateWin *wins_get_private(const char * const fulljid);
 ProfXMLWin * wins_get_xmlconsole(void);
+ProfMentionsWin * wins_get_mentions(void);
 
 ProfWin * wins_get_current(void);
 ProfChatWin * wins_get_current_chat(void);
@@ -70,6 +72,7 @@ void wins_clear_current(void);
 gboolean wins_is_current(ProfWin *window);
 int wins_get_total_unread(void);
 void wins_resize_all(void);
+void wins_sub_invalidate_all(void);
 GSList * wins_get_chat_recipients(void);
 GSList * wins_get_prune_wins(void);
 void wins_lost_connection(void);
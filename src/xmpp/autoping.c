@@ -0,0 +1,143 @@
+/*
+ * autoping.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <glib.h>
+
+#include "xmpp/autoping.h"
+
+// interval adapted from missed pongs, 0 when the preference applies
+static int adapted = 0;
+static int successes = 0;
+static int misses = 0;
+
+/*
+ * Forget the adapted interval, on an explicit setting or a new connection
+ */
+void
+autoping_reset(void)
+{
+    adapted = 0;
+    successes = 0;
+    misses = 0;
+}
+
+/*
+ * A new connection starts without misses but keeps the adapted interval
+ */
+void
+autoping_connected(void)
+{
+    successes = 0;
+    misses = 0;
+}
+
+/*
+ * Interval in seconds, shorter than configured when missed pongs have
+ * shown the connection is dropped when idle, 0 if off
+ */
+int
+autoping_interval(int configured)
+{
+    if (configured == 0) {
+        return 0;
+    }
+    if (adapted == 0 || adapted > configured) {
+        return configured;
+    }
+
+    return adapted;
+}
+
+int
+autoping_timeout(int configured)
+{
+    return MIN(AUTOPING_TIMEOUT_SECS, autoping_interval(configured));
+}
+
+/*
+ * Any response shows the connection is alive, an adapted interval grows
+ * back towards the preference. Returns TRUE when the interval changed.
+ */
+gboolean
+autoping_pong(int configured)
+{
+    misses = 0;
+
+    if (adapted == 0) {
+        return FALSE;
+    }
+
+    successes++;
+    if (successes < AUTOPING_GROW_AFTER) {
+        return FALSE;
+    }
+
+    successes = 0;
+    adapted += AUTOPING_GROW_STEP_SECS;
+    if (adapted >= configured) {
+        adapted = 0;
+    }
+
+    return TRUE;
+}
+
+/*
+ * A missed pong shortens the interval, the connection is only taken as
+ * dead after consecutive misses, the follow up ping is sent straight away.
+ * Returns TRUE when it is.
+ */
+gboolean
+autoping_missed(int configured)
+{
+    successes = 0;
+    misses++;
+
+    int current = autoping_interval(configured);
+    if (current > AUTOPING_MIN_INTERVAL_SECS) {
+        adapted = MAX(current / 2, AUTOPING_MIN_INTERVAL_SECS);
+    }
+
+    if (misses < AUTOPING_MAX_MISSES) {
+        return FALSE;
+    }
+
+    misses = 0;
+    return TRUE;
+}
+
+int
+autoping_misses(void)
+{
+    return misses;
+}
@@ -42,6 +42,7 @@
 #include "common.h"
 #include "log.h"
 #include "muc.h"
+#include "tools/frecency.h"
 #include "server_events.h"
 #include "xmpp/connection.h"
 #include "xmpp/stanza.h"
@@ -225,12 +226,10 @@ bookmark_find(char *search_str)
     return autocomplete_complete(bookmark_ac, search_str, TRUE);
 }
 
-void
-bookmark_autocomplete_reset(void)
+char *
+bookmark_fuzzy_find(char *search_str)
 {
-    if (bookmark_ac != NULL) {
-        autocomplete_reset(bookmark_ac);
-    }
+    return autocomplete_complete_fuzzy(bookmark_ac, search_str, TRUE, frecency_score);
 }
 
 static int
@@ -55,6 +55,10 @@
 static gchar *cache_loc;
 static GKeyFile *cache;
 
+// the cache file is parsed once, by caps_preload or by its first user
+static gboolean cache_loaded;
+G_LOCK_DEFINE_STATIC(cache_lock);
+
 static GHashTable *jid_to_ver;
 static GHashTable *jid_to_caps;
 
@@ -62,6 +66,7 @@ static char *my_sha1;
 
 static gchar* _get_cache_file(void);
 static void _save_cache(void);
+static void _wait_cache(void);
 static Capabilities * _caps_by_ver(const char * const ver);
 static Capabilities * _caps_by_jid(const char * const jid);
 Capabilities * _caps_copy(Capabilities *caps);
@@ -76,9 +81,8 @@ caps_init(void)
         g_chmod(cache_loc, S_IRUSR | S_IWUSR);
     }
 
-    cache = g_key_file_new();
-    g_key_file_load_from_file(cache, cache_loc, G_KEY_FILE_KEEP_COMMENTS,
-        NULL);
+    cache = NULL;
+    cache_loaded = FALSE;
 
     jid_to_ver = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
     jid_to_caps = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)caps_destroy);
@@ -86,9 +90,19 @@ caps_init(void)
     my_sha1 = NULL;
 }
 
+/*
+ * Parse the cache file now, safe to call from a worker thread
+ */
+void
+caps_preload(void)
+{
+    _wait_cache();
+}
+
 void
 caps_add_by_ver(const char * const ver, Capabilities *caps)
 {
+    _wait_cache();
     gboolean cached = g_key_file_has_group(cache, ver);
     if (!cached) {
         if (caps->name) {
@@ -143,12 +157,14 @@ caps_map_jid_to_ver(const char * const jid, const char * const ver)
 gboolean
 caps_contains(const char * const ver)
 {
+    _wait_cache();
     return (g_key_file_has_group(cache, ver));
 }
 
 static Capabilities *
 _caps_by_ver(const char * const ver)
 {
+    _wait_cache();
     if (g_key_file_has_group(cache, ver)) {
         Capabilities *new_caps = malloc(sizeof(struct capabilities_t));
 
@@ -626,6 +642,7 @@ caps_create_query_response_stanza(xmpp_ctx_t * const ctx)
 void
 caps_close(void)
 {
+    _wait_cache();
     g_key_file_free(cache);
     cache = NULL;
     g_hash_table_destroy(jid_to_ver);
@@ -671,4 +688,17 @@ _save_cache(void)
     g_file_set_contents(cache_loc, g_cache_data, g_data_size, NULL);
     g_chmod(cache_loc, S_IRUSR | S_IWUSR);
     g_free(g_cache_data);
-}
\ No newline at end of file
+}
+
+static void
+_wait_cache(void)
+{
+    G_LOCK(cache_lock);
+    if (!cache_loaded) {
+        GKeyFile *loaded = g_key_file_new();
+        g_key_file_load_from_file(loaded, cache_loc, G_KEY_FILE_KEEP_COMMENTS, NULL);
+        cache = loaded;
+        cache_loaded = TRUE;
+    }
+    G_UNLOCK(cache_lock);
+}
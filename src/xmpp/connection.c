@@ -65,6 +65,7 @@ static struct _jabber_conn_t {
     int priority;
     int tls_disabled;
     char *domain;
+    Jid *jid;
 } jabber_conn;
 
 static GHashTable *available_resources;
@@ -114,6 +115,7 @@ jabber_init(const int disable_tls)
     jabber_conn.ctx = NULL;
     jabber_conn.tls_disabled = disable_tls;
     jabber_conn.domain = NULL;
+    jabber_conn.jid = NULL;
     presence_sub_requests_init();
     caps_init();
     available_resources = g_hash_table_new_full(g_str_hash, g_str_equal, free,
@@ -212,6 +214,8 @@ jabber_disconnect(void)
     jabber_conn.conn_status = JABBER_STARTED;
     FREE_SET_NULL(jabber_conn.presence_message);
     FREE_SET_NULL(jabber_conn.domain);
+    jid_destroy(jabber_conn.jid);
+    jabber_conn.jid = NULL;
 }
 
 void
@@ -220,6 +224,7 @@ jabber_shutdown(void)
     _connection_free_saved_account();
     _connection_free_saved_details();
     _connection_free_session_data();
+    iq_stats_reset();
     xmpp_shutdown();
     free(jabber_conn.log);
 }
@@ -280,6 +285,19 @@ jabber_get_fulljid(void)
     return xmpp_conn_get_jid(jabber_conn.conn);
 }
 
+/*
+ * Our own barejid, parsed once per connection
+ */
+const char *
+jabber_get_barejid(void)
+{
+    if (jabber_conn.jid == NULL) {
+        return NULL;
+    }
+
+    return jabber_conn.jid->barejid;
+}
+
 const char *
 jabber_get_domain(void)
 {
@@ -325,6 +343,19 @@ connection_remove_available_resource(const char * const resource)
     g_hash_table_remove(available_resources, resource);
 }
 
+/*
+ * Close a connection that has stopped responding, the connection handler
+ * then treats it as lost and reconnects when configured to
+ */
+void
+connection_force_disconnect(void)
+{
+    if (jabber_conn.conn_status == JABBER_CONNECTED && jabber_conn.conn != NULL) {
+        log_info("Connection not responding, closing");
+        xmpp_disconnect(jabber_conn.conn);
+    }
+}
+
 void
 _connection_free_saved_account(void)
 {
@@ -347,6 +378,7 @@ _connection_free_session_data(void)
     g_hash_table_remove_all(available_resources);
     chat_sessions_clear();
     presence_clear_sub_requests();
+    iq_requests_clear();
 }
 
 static jabber_conn_status_t
@@ -453,9 +485,10 @@ _connection_handler(xmpp_conn_t * const conn,
             _connection_free_saved_details();
         }
 
-        Jid *my_jid = jid_create(jabber_get_fulljid());
-        jabber_conn.domain = strdup(my_jid->domainpart);
-        jid_destroy(my_jid);
+        jid_destroy(jabber_conn.jid);
+        jabber_conn.jid = jid_create(jabber_get_fulljid());
+        FREE_SET_NULL(jabber_conn.domain);
+        jabber_conn.domain = strdup(jabber_conn.jid->domainpart);
 
         chat_sessions_init();
 
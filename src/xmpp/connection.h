@@ -45,5 +45,6 @@ void connection_set_priority(int priority);
 void connection_set_presence_message(const char * const message);
 void connection_add_available_resource(Resource *resource);
 void connection_remove_available_resource(const char * const resource);
+void connection_force_disconnect(void);
 
 #endif
@@ -702,16 +702,4 @@ form_get_value_ac(DataForm *form, const char * const tag)
         }
     }
     return NULL;
-}
-
-void
-form_reset_autocompleters(DataForm *form)
-{
-    autocomplete_reset(form->tag_ac);
-    GSList *curr_field = form->fields;
-    while (curr_field) {
-        FormField *field = curr_field->data;
-        autocomplete_reset(field->value_ac);
-        curr_field = g_slist_next(curr_field);
-    }
 }
\ No newline at end of file
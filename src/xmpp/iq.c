@@ -44,6 +44,7 @@
 #include <glib.h>
 #include <strophe.h>
 
+#include "common.h"
 #include "log.h"
 #include "muc.h"
 #include "profanity.h"
@@ -53,11 +54,60 @@
 #include "xmpp/connection.h"
 #include "xmpp/stanza.h"
 #include "xmpp/form.h"
+#include "xmpp/autoping.h"
+#include "xmpp/iq.h"
+#include "xmpp/iq_tracker.h"
 #include "roster_list.h"
 #include "xmpp/xmpp.h"
 
 #define HANDLE(ns, type, func) xmpp_handler_add(conn, func, ns, STANZA_NAME_IQ, type, ctx)
 
+#define IQ_TIMEOUT_SECS 30
+#define IQ_TIMEOUT_SWEEP_MILLIS 1000
+#define IQ_MAX_OUTSTANDING 256
+
+
+// round trip times of autopings
+static IqStats autoping_stats;
+static int autoping_last_millis = -1;
+
+static gboolean _iq_id_handler_add(xmpp_conn_t * const conn, const char * const id,
+    const char * const ns, const char * const to, xmpp_handler func,
+    ProfIqTimeoutCallback timeout_func, void * const userdata,
+    GDestroyNotify free_func);
+static void _iq_id_handler_add_with_timeout(xmpp_conn_t * const conn, const char * const id,
+    const char * const ns, const char * const to, int timeout_secs, xmpp_handler func,
+    ProfIqTimeoutCallback timeout_func, void * const userdata,
+    GDestroyNotify free_func);
+static int _iq_response_handler(xmpp_conn_t * const conn,
+    xmpp_stanza_t * const stanza, void * const userdata);
+static int _iq_timeout_timed_handler(xmpp_conn_t * const conn,
+    void * const userdata);
+static gint64 _iq_now_millis(void);
+static void _iq_request_expire(xmpp_conn_t * const conn, ProfIqRequest *request);
+
+static void _disco_info_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _room_config_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _room_config_submit_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _room_affiliation_list_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _room_affiliation_set_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _room_role_list_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _room_role_set_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _room_kick_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _manual_ping_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _autoping_timeout(const char * const to, const char * const error,
+    void * const userdata);
+static void _autoping_schedule(xmpp_conn_t * const conn);
+
 static int _error_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
 static int _ping_get_handler(xmpp_conn_t * const conn,
@@ -119,29 +169,43 @@ iq_add_handlers(void)
 
     HANDLE(STANZA_NS_PING,      STANZA_TYPE_GET,    _ping_get_handler);
 
-    if (prefs_get_autoping() != 0) {
-        int millis = prefs_get_autoping() * 1000;
-        xmpp_timed_handler_add(conn, _ping_timed_handler, millis, ctx);
-    }
+    xmpp_timed_handler_add(conn, _iq_timeout_timed_handler, IQ_TIMEOUT_SWEEP_MILLIS, NULL);
+
+    autoping_connected();
+    _autoping_schedule(conn);
 }
 
 void
 iq_set_autoping(const int seconds)
 {
     xmpp_conn_t * const conn = connection_get_conn();
-    xmpp_ctx_t * const ctx = connection_get_ctx();
 
-    if (jabber_get_connection_status() == JABBER_CONNECTED) {
-        xmpp_timed_handler_delete(conn, _ping_timed_handler);
+    // an explicit setting discards the adapted interval
+    autoping_reset();
 
-        if (seconds != 0) {
-            int millis = seconds * 1000;
-            xmpp_timed_handler_add(conn, _ping_timed_handler, millis,
-                ctx);
-        }
+    if (jabber_get_connection_status() == JABBER_CONNECTED) {
+        _autoping_schedule(conn);
     }
 }
 
+int
+iq_autoping_interval(void)
+{
+    return autoping_interval(prefs_get_autoping());
+}
+
+IqStats *
+iq_autoping_stats(void)
+{
+    return &autoping_stats;
+}
+
+int
+iq_autoping_last_rtt(void)
+{
+    return autoping_last_millis;
+}
+
 void
 iq_room_list_request(gchar *conferencejid)
 {
@@ -160,11 +224,14 @@ iq_disco_info_request(gchar *jid)
     char *id = create_unique_id("disco_info");
     xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, jid, NULL);
 
-    xmpp_id_handler_add(conn, _disco_info_response_handler, id, NULL);
+    gboolean tracked = _iq_id_handler_add(conn, id, XMPP_NS_DISCO_INFO, jid, _disco_info_response_handler,
+        _disco_info_timeout, NULL, NULL);
 
     free(id);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -176,11 +243,14 @@ iq_room_info_request(gchar *room)
     char *id = create_unique_id("room_disco_info");
     xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, room, NULL);
 
-    xmpp_id_handler_add(conn, _disco_info_response_handler, id, room);
+    gboolean tracked = _iq_id_handler_add(conn, id, XMPP_NS_DISCO_INFO, room, _disco_info_response_handler,
+        _disco_info_timeout, strdup(room), free);
 
     free(id);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -205,9 +275,12 @@ iq_send_caps_request_for_jid(const char * const to, const char * const id,
     xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, to, node_str->str);
     g_string_free(node_str, TRUE);
 
-    xmpp_id_handler_add(conn, _caps_response_handler_for_jid, id, strdup(to));
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_CAPS, to, _caps_response_handler_for_jid,
+        NULL, strdup(to), free);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -232,9 +305,12 @@ iq_send_caps_request(const char * const to, const char * const id,
     xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, to, node_str->str);
     g_string_free(node_str, TRUE);
 
-    xmpp_id_handler_add(conn, _caps_response_handler, id, NULL);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_CAPS, to, _caps_response_handler,
+        NULL, NULL, NULL);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -258,10 +334,13 @@ iq_send_caps_request_legacy(const char * const to, const char * const id,
     g_string_printf(node_str, "%s#%s", node, ver);
     xmpp_stanza_t *iq = stanza_create_disco_info_iq(ctx, id, to, node_str->str);
 
-    xmpp_id_handler_add(conn, _caps_response_handler_legacy, id, node_str->str);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_CAPS, to, _caps_response_handler_legacy,
+        NULL, node_str->str, g_free);
     g_string_free(node_str, FALSE);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -303,9 +382,12 @@ iq_destroy_room(const char * const room_jid)
     xmpp_stanza_t *iq = stanza_create_instant_room_destroy_iq(ctx, room_jid);
 
     char *id = xmpp_stanza_get_id(iq);
-    xmpp_id_handler_add(conn, _destroy_room_result_handler, id, NULL);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_OWNER, room_jid, _destroy_room_result_handler,
+        NULL, NULL, NULL);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -317,9 +399,12 @@ iq_request_room_config_form(const char * const room_jid)
     xmpp_stanza_t *iq = stanza_create_room_config_request_iq(ctx, room_jid);
 
     char *id = xmpp_stanza_get_id(iq);
-    xmpp_id_handler_add(conn, _room_config_handler, id, NULL);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_OWNER, room_jid, _room_config_handler,
+        _room_config_timeout, NULL, NULL);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -331,9 +416,12 @@ iq_submit_room_config(const char * const room, DataForm *form)
     xmpp_stanza_t *iq = stanza_create_room_config_submit_iq(ctx, room, form);
 
     char *id = xmpp_stanza_get_id(iq);
-    xmpp_id_handler_add(conn, _room_config_submit_handler, id, NULL);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_OWNER, room, _room_config_submit_handler,
+        _room_config_submit_timeout, NULL, NULL);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -355,9 +443,12 @@ iq_room_affiliation_list(const char * const room, char *affiliation)
     xmpp_stanza_t *iq = stanza_create_room_affiliation_list_iq(ctx, room, affiliation);
 
     char *id = xmpp_stanza_get_id(iq);
-    xmpp_id_handler_add(conn, _room_affiliation_list_result_handler, id, strdup(affiliation));
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_ADMIN, room, _room_affiliation_list_result_handler,
+        _room_affiliation_list_timeout, strdup(affiliation), free);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -369,9 +460,12 @@ iq_room_kick_occupant(const char * const room, const char * const nick, const ch
     xmpp_stanza_t *iq = stanza_create_room_kick_iq(ctx, room, nick, reason);
 
     char *id = xmpp_stanza_get_id(iq);
-    xmpp_id_handler_add(conn, _room_kick_result_handler, id, strdup(nick));
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_ADMIN, room, _room_kick_result_handler,
+        _room_kick_timeout, strdup(nick), free);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -380,6 +474,16 @@ struct privilege_set_t {
     char *privilege;
 };
 
+static void
+_privilege_set_free(struct privilege_set_t *privilege_set)
+{
+    if (privilege_set != NULL) {
+        free(privilege_set->item);
+        free(privilege_set->privilege);
+        free(privilege_set);
+    }
+}
+
 void
 iq_room_affiliation_set(const char * const room, const char * const jid, char *affiliation,
     const char * const reason)
@@ -394,9 +498,12 @@ iq_room_affiliation_set(const char * const room, const char * const jid, char *a
     affiliation_set->item = strdup(jid);
     affiliation_set->privilege = strdup(affiliation);
 
-    xmpp_id_handler_add(conn, _room_affiliation_set_result_handler, id, affiliation_set);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_ADMIN, room, _room_affiliation_set_result_handler,
+        _room_affiliation_set_timeout, affiliation_set, (GDestroyNotify)_privilege_set_free);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -414,9 +521,12 @@ iq_room_role_set(const char * const room, const char * const nick, char *role,
     role_set->item = strdup(nick);
     role_set->privilege = strdup(role);
 
-    xmpp_id_handler_add(conn, _room_role_set_result_handler, id, role_set);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_ADMIN, room, _room_role_set_result_handler,
+        _room_role_set_timeout, role_set, (GDestroyNotify)_privilege_set_free);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -428,9 +538,12 @@ iq_room_role_list(const char * const room, char *role)
     xmpp_stanza_t *iq = stanza_create_room_role_list_iq(ctx, room, role);
 
     char *id = xmpp_stanza_get_id(iq);
-    xmpp_id_handler_add(conn, _room_role_list_result_handler, id, strdup(role));
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_MUC_ADMIN, room, _room_role_list_result_handler,
+        _room_role_list_timeout, strdup(role), free);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
@@ -443,12 +556,61 @@ iq_send_ping(const char * const target)
     char *id = xmpp_stanza_get_id(iq);
 
     GDateTime *now = g_date_time_new_now_local();
-    xmpp_id_handler_add(conn, _manual_pong_handler, id, now);
+    gboolean tracked = _iq_id_handler_add(conn, id, STANZA_NS_PING, target, _manual_pong_handler,
+        _manual_ping_timeout, now, (GDestroyNotify)g_date_time_unref);
 
-    xmpp_send(conn, iq);
+    if (tracked) {
+        xmpp_send(conn, iq);
+    }
     xmpp_stanza_release(iq);
 }
 
+GList *
+iq_stats_list(void)
+{
+    return iq_tracker_stats_list();
+}
+
+int
+iq_stats_bucket_limit(int bucket)
+{
+    return iq_tracker_bucket_limit(bucket);
+}
+
+int
+iq_outstanding_count(void)
+{
+    return iq_tracker_count();
+}
+
+void
+iq_stats_reset(void)
+{
+    iq_tracker_stats_reset();
+    memset(&autoping_stats, 0, sizeof(IqStats));
+}
+
+/*
+ * Drop every outstanding request without invoking its callbacks,
+ * used when the session ends and responses can no longer arrive
+ */
+void
+iq_requests_clear(void)
+{
+    xmpp_conn_t * const conn = connection_get_conn();
+    GList *pending = iq_tracker_take_expired(G_MAXINT64);
+    GList *curr = pending;
+    while (curr != NULL) {
+        ProfIqRequest *request = curr->data;
+        if (conn != NULL) {
+            xmpp_id_handler_delete(conn, _iq_response_handler, request->id);
+        }
+        iq_tracker_request_free(request);
+        curr = g_list_next(curr);
+    }
+    g_list_free(pending);
+}
+
 static int
 _error_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
     void * const userdata)
@@ -475,6 +637,7 @@ _pong_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
 {
     char *id = xmpp_stanza_get_id(stanza);
     char *type = xmpp_stanza_get_type(stanza);
+    gint64 *sent = (gint64 *)userdata;
 
     if (id != NULL) {
         log_debug("IQ pong handler fired, id: %s.", id);
@@ -482,6 +645,23 @@ _pong_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
         log_debug("IQ pong handler fired.");
     }
 
+    // any response shows the connection is alive, only results are timed
+    if (g_strcmp0(type, STANZA_TYPE_ERROR) == 0) {
+        autoping_stats.errors++;
+    } else {
+        int elapsed_millis = _iq_now_millis() - *sent;
+        autoping_stats.results++;
+        iq_tracker_record_latency(&autoping_stats, elapsed_millis);
+        autoping_last_millis = elapsed_millis;
+        handle_autoping_pong(elapsed_millis);
+    }
+
+    // grow an adapted interval back towards the preference
+    if (autoping_pong(prefs_get_autoping())) {
+        log_debug("Autoping interval increased to %d seconds", iq_autoping_interval());
+        _autoping_schedule(conn);
+    }
+
     if (id != NULL && type != NULL) {
         // show warning if error
         if (strcmp(type, STANZA_TYPE_ERROR) == 0) {
@@ -699,7 +879,6 @@ _caps_response_handler_legacy(xmpp_conn_t *const conn, xmpp_stanza_t * const sta
         log_info("Legacy Capabilities nodes do not match, expeceted %s, given %s.", expected_node, node);
     }
 
-    free(expected_node);
     return 0;
 }
 
@@ -716,7 +895,6 @@ _manual_pong_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
         char *error_message = stanza_get_error_message(stanza);
         handle_ping_error_result(from, error_message);
         free(error_message);
-        g_date_time_unref(sent);
         return 0;
     }
 
@@ -725,7 +903,6 @@ _manual_pong_handler(xmpp_conn_t *const conn, xmpp_stanza_t * const stanza,
     GTimeSpan elapsed = g_date_time_difference(now, sent);
     int elapsed_millis = elapsed / 1000;
 
-    g_date_time_unref(sent);
     g_date_time_unref(now);
 
     handle_ping_result(from, elapsed_millis);
@@ -743,8 +920,15 @@ _ping_timed_handler(xmpp_conn_t * const conn, void * const userdata)
         xmpp_stanza_t *iq = stanza_create_ping_iq(ctx, NULL);
         char *id = xmpp_stanza_get_id(iq);
 
-        // add pong handler
-        xmpp_id_handler_add(conn, _pong_handler, id, ctx);
+        gint64 *sent = malloc(sizeof(gint64));
+        *sent = _iq_now_millis();
+        autoping_stats.sent++;
+
+        // add pong handler, several missed pongs mean the connection is dead,
+        // there is only ever one autoping outstanding so it is never refused
+        int timeout_secs = autoping_timeout(prefs_get_autoping());
+        _iq_id_handler_add_with_timeout(conn, id, STANZA_NS_PING, NULL, timeout_secs,
+            _pong_handler, _autoping_timeout, sent, free);
 
         xmpp_send(conn, iq);
         xmpp_stanza_release(iq);
@@ -1084,10 +1268,6 @@ static int _room_affiliation_set_result_handler(xmpp_conn_t * const conn, xmpp_s
         free(error_message);
     }
 
-    free(affiliation_set->item);
-    free(affiliation_set->privilege);
-    free(affiliation_set);
-
     return 0;
 }
 
@@ -1112,10 +1292,6 @@ static int _room_role_set_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t
         free(error_message);
     }
 
-    free(role_set->item);
-    free(role_set->privilege);
-    free(role_set);
-
     return 0;
 }
 
@@ -1138,7 +1314,6 @@ _room_affiliation_list_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t *
         char *error_message = stanza_get_error_message(stanza);
         handle_room_affiliation_list_result_error(from, affiliation, error_message);
         free(error_message);
-        free(affiliation);
         return 0;
     }
     GSList *jids = NULL;
@@ -1159,7 +1334,6 @@ _room_affiliation_list_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t *
     }
 
     handle_room_affiliation_list(from, affiliation, jids);
-    free(affiliation);
     g_slist_free(jids);
 
     return 0;
@@ -1184,7 +1358,6 @@ _room_role_list_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const s
         char *error_message = stanza_get_error_message(stanza);
         handle_room_role_list_result_error(from, role, error_message);
         free(error_message);
-        free(role);
         return 0;
     }
     GSList *nicks = NULL;
@@ -1205,7 +1378,6 @@ _room_role_list_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const s
     }
 
     handle_room_role_list(from, role, nicks);
-    free(role);
     g_slist_free(nicks);
 
     return 0;
@@ -1257,12 +1429,9 @@ _room_kick_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza
         char *error_message = stanza_get_error_message(stanza);
         handle_room_kick_result_error(from, nick, error_message);
         free(error_message);
-        free(nick);
         return 0;
     }
 
-    free(nick);
-
     return 0;
 }
 
@@ -1372,7 +1541,8 @@ _disco_info_response_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const sta
         g_slist_free_full(features, free);
         g_slist_free_full(identities, (GDestroyNotify)_identity_destroy);
     }
-    return 1;
+
+    return 0;
 }
 
 static int
@@ -1422,4 +1592,218 @@ _disco_items_result_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stan
     g_slist_free_full(items, (GDestroyNotify)_item_destroy);
 
     return 1;
-}
\ No newline at end of file
+}
+
+static gint64
+_iq_now_millis(void)
+{
+    return g_get_monotonic_time() / 1000;
+}
+
+static void
+_iq_request_expire(xmpp_conn_t * const conn, ProfIqRequest *request)
+{
+    xmpp_id_handler_delete(conn, _iq_response_handler, request->id);
+    iq_tracker_record_timeout(request);
+
+    log_warning("IQ request timed out, id: %s, namespace: %s, to: %s",
+        request->id, request->ns, request->to == NULL ? "server" : request->to);
+
+    if (request->timeout_func != NULL) {
+        request->timeout_func(request->to, "Request timed out", request->userdata);
+    }
+
+    iq_tracker_request_free(request);
+}
+
+/*
+ * Track a request before it is sent, returns FALSE without tracking it when
+ * too many are outstanding, the request is then failed through timeout_func
+ * and must not be sent
+ */
+static gboolean
+_iq_id_handler_add(xmpp_conn_t * const conn, const char * const id,
+    const char * const ns, const char * const to, xmpp_handler func,
+    ProfIqTimeoutCallback timeout_func, void * const userdata,
+    GDestroyNotify free_func)
+{
+    if (iq_tracker_count() >= IQ_MAX_OUTSTANDING) {
+        log_warning("Too many IQ requests outstanding, not sending id: %s, namespace: %s, to: %s",
+            id, ns, to == NULL ? "server" : to);
+        if (timeout_func != NULL) {
+            timeout_func(to, "Too many requests outstanding", userdata);
+        }
+        if (free_func != NULL) {
+            free_func(userdata);
+        }
+        return FALSE;
+    }
+
+    _iq_id_handler_add_with_timeout(conn, id, ns, to, IQ_TIMEOUT_SECS, func,
+        timeout_func, userdata, free_func);
+
+    return TRUE;
+}
+
+static void
+_iq_id_handler_add_with_timeout(xmpp_conn_t * const conn, const char * const id,
+    const char * const ns, const char * const to, int timeout_secs, xmpp_handler func,
+    ProfIqTimeoutCallback timeout_func, void * const userdata,
+    GDestroyNotify free_func)
+{
+    iq_tracker_add(id, ns, to, func, timeout_func, userdata, free_func,
+        _iq_now_millis(), timeout_secs * 1000);
+
+    // the handler finds the request by id, a reused id needs only one
+    xmpp_id_handler_delete(conn, _iq_response_handler, id);
+    xmpp_id_handler_add(conn, _iq_response_handler, id, NULL);
+}
+
+/*
+ * A result or error retires the request whatever its callback returns,
+ * the callback must not free userdata
+ */
+static int
+_iq_response_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
+    void * const userdata)
+{
+    char *type = xmpp_stanza_get_type(stanza);
+    gboolean is_result = g_strcmp0(type, STANZA_TYPE_RESULT) == 0;
+    gboolean is_error = g_strcmp0(type, STANZA_TYPE_ERROR) == 0;
+    if (!is_result && !is_error) {
+        return 1;
+    }
+
+    // no request when it has already timed out
+    ProfIqRequest *request = iq_tracker_take(xmpp_stanza_get_id(stanza));
+    if (request == NULL) {
+        return 0;
+    }
+
+    iq_tracker_record_response(request, is_error, _iq_now_millis());
+    request->func(conn, stanza, request->userdata);
+    iq_tracker_request_free(request);
+
+    return 0;
+}
+
+static int
+_iq_timeout_timed_handler(xmpp_conn_t * const conn, void * const userdata)
+{
+    // expire outside the table, timeout callbacks may send new requests
+    GList *expired = iq_tracker_take_expired(_iq_now_millis());
+    GList *curr = expired;
+    while (curr != NULL) {
+        _iq_request_expire(conn, curr->data);
+        curr = g_list_next(curr);
+    }
+    g_list_free(expired);
+
+    return 1;
+}
+
+static void
+_disco_info_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    if (userdata != NULL) {
+        handle_room_info_error(to, error);
+    } else {
+        handle_disco_info_error(to, error);
+    }
+}
+
+static void
+_room_config_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    handle_room_configuration_form_error(to, error);
+}
+
+static void
+_room_config_submit_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    handle_room_config_submit_result_error(to, error);
+}
+
+static void
+_room_affiliation_list_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    handle_room_affiliation_list_result_error(to, (char *)userdata, error);
+}
+
+static void
+_room_affiliation_set_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    struct privilege_set_t *affiliation_set = (struct privilege_set_t *)userdata;
+    handle_room_affiliation_set_error(to, affiliation_set->item, affiliation_set->privilege,
+        error);
+}
+
+static void
+_room_role_list_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    handle_room_role_list_result_error(to, (char *)userdata, error);
+}
+
+static void
+_room_role_set_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    struct privilege_set_t *role_set = (struct privilege_set_t *)userdata;
+    handle_room_role_set_error(to, role_set->item, role_set->privilege, error);
+}
+
+static void
+_room_kick_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    handle_room_kick_result_error(to, (char *)userdata, error);
+}
+
+static void
+_manual_ping_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    if (to == NULL) {
+        handle_ping_error_result(jabber_get_domain(), error);
+    } else {
+        handle_ping_error_result(to, error);
+    }
+}
+
+static void
+_autoping_timeout(const char * const to, const char * const error, void * const userdata)
+{
+    autoping_stats.timeouts++;
+    autoping_last_millis = -1;
+
+    // the connection was dropped while idle, ping more often from now on
+    int configured = prefs_get_autoping();
+    int timeout_secs = autoping_timeout(configured);
+    int current = autoping_interval(configured);
+    gboolean dead = autoping_missed(configured);
+    if (autoping_interval(configured) != current) {
+        log_info("Autoping interval reduced to %d seconds", autoping_interval(configured));
+    }
+
+    if (dead) {
+        handle_autoping_timeout(timeout_secs);
+        connection_force_disconnect();
+    } else {
+        log_warning("Server did not respond to ping within %d seconds, %d of %d misses",
+            timeout_secs, autoping_misses(), AUTOPING_MAX_MISSES);
+        // ping again now rather than after the interval, to find a dead connection quickly
+        xmpp_conn_t * const conn = connection_get_conn();
+        _autoping_schedule(conn);
+        _ping_timed_handler(conn, connection_get_ctx());
+    }
+}
+
+static void
+_autoping_schedule(xmpp_conn_t * const conn)
+{
+    xmpp_ctx_t * const ctx = connection_get_ctx();
+
+    xmpp_timed_handler_delete(conn, _ping_timed_handler);
+
+    int interval = iq_autoping_interval();
+    if (interval != 0) {
+        xmpp_timed_handler_add(conn, _ping_timed_handler, interval * 1000, ctx);
+    }
+}
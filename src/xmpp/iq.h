@@ -37,5 +37,6 @@
 
 void iq_add_handlers(void);
 void iq_roster_request(void);
+void iq_requests_clear(void);
 
 #endif
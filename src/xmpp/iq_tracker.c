@@ -0,0 +1,272 @@
+/*
+ * iq_tracker.c
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "xmpp/iq_tracker.h"
+
+// upper bound in millis of each latency bucket, the last bucket is unbounded
+static const int latency_bucket_limits[IQ_LATENCY_BUCKETS] =
+    { 50, 100, 250, 500, 1000, 2500, 5000, -1 };
+
+static GHashTable *requests = NULL;
+static GHashTable *stats = NULL;
+
+static void _iq_stats_free(IqStats *ns_stats);
+static gint _iq_stats_compare(IqStats *a, IqStats *b);
+static gint _iq_request_deadline_compare(ProfIqRequest *a, ProfIqRequest *b);
+
+/*
+ * Track a request until its response arrives or its deadline passes,
+ * the tracker owns userdata from now on and frees it with the request
+ */
+void
+iq_tracker_add(const char * const id, const char * const ns, const char * const to,
+    xmpp_handler func, ProfIqTimeoutCallback timeout_func, void * const userdata,
+    GDestroyNotify free_func, gint64 now, int timeout_millis)
+{
+    if (requests == NULL) {
+        requests = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+            (GDestroyNotify)iq_tracker_request_free);
+    }
+
+    ProfIqRequest *request = malloc(sizeof(ProfIqRequest));
+    request->id = strdup(id);
+    request->ns = strdup(ns);
+    request->to = to == NULL ? NULL : strdup(to);
+    request->func = func;
+    request->timeout_func = timeout_func;
+    request->userdata = userdata;
+    request->free_func = free_func;
+    request->sent = now;
+    request->deadline = now + timeout_millis;
+
+    // a reused id replaces the earlier request
+    g_hash_table_remove(requests, id);
+    g_hash_table_insert(requests, request->id, request);
+    iq_tracker_stats(ns)->sent++;
+}
+
+/*
+ * Stop tracking the request with id, the caller frees it
+ */
+ProfIqRequest*
+iq_tracker_take(const char * const id)
+{
+    if (requests == NULL || id == NULL) {
+        return NULL;
+    }
+
+    ProfIqRequest *request = g_hash_table_lookup(requests, id);
+    if (request != NULL) {
+        g_hash_table_steal(requests, id);
+    }
+
+    return request;
+}
+
+/*
+ * Stop tracking every request whose deadline has passed, earliest first
+ */
+GList*
+iq_tracker_take_expired(gint64 now)
+{
+    if (requests == NULL) {
+        return NULL;
+    }
+
+    GList *expired = NULL;
+    GList *pending = g_hash_table_get_values(requests);
+    GList *curr = pending;
+    while (curr != NULL) {
+        ProfIqRequest *request = curr->data;
+        if (request->deadline <= now) {
+            expired = g_list_insert_sorted(expired, request, (GCompareFunc)_iq_request_deadline_compare);
+        }
+        curr = g_list_next(curr);
+    }
+    g_list_free(pending);
+
+    curr = expired;
+    while (curr != NULL) {
+        ProfIqRequest *request = curr->data;
+        g_hash_table_steal(requests, request->id);
+        curr = g_list_next(curr);
+    }
+
+    return expired;
+}
+
+void
+iq_tracker_request_free(ProfIqRequest *request)
+{
+    if (request != NULL) {
+        if (request->free_func != NULL && request->userdata != NULL) {
+            request->free_func(request->userdata);
+        }
+        free(request->id);
+        free(request->ns);
+        free(request->to);
+        free(request);
+    }
+}
+
+int
+iq_tracker_count(void)
+{
+    if (requests == NULL) {
+        return 0;
+    }
+
+    return g_hash_table_size(requests);
+}
+
+void
+iq_tracker_clear(void)
+{
+    if (requests != NULL) {
+        g_hash_table_destroy(requests);
+        requests = NULL;
+    }
+}
+
+void
+iq_tracker_record_response(ProfIqRequest *request, gboolean is_error, gint64 now)
+{
+    IqStats *ns_stats = iq_tracker_stats(request->ns);
+    if (is_error) {
+        ns_stats->errors++;
+    } else {
+        ns_stats->results++;
+    }
+    iq_tracker_record_latency(ns_stats, now - request->sent);
+}
+
+void
+iq_tracker_record_timeout(ProfIqRequest *request)
+{
+    iq_tracker_stats(request->ns)->timeouts++;
+}
+
+void
+iq_tracker_record_latency(IqStats *ns_stats, int millis)
+{
+    int bucket = 0;
+    while (bucket < IQ_LATENCY_BUCKETS - 1 && millis > latency_bucket_limits[bucket]) {
+        bucket++;
+    }
+    ns_stats->buckets[bucket]++;
+    ns_stats->total_millis += millis;
+    if (millis > ns_stats->max_millis) {
+        ns_stats->max_millis = millis;
+    }
+}
+
+IqStats*
+iq_tracker_stats(const char * const ns)
+{
+    if (stats == NULL) {
+        stats = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+            (GDestroyNotify)_iq_stats_free);
+    }
+
+    IqStats *ns_stats = g_hash_table_lookup(stats, ns);
+    if (ns_stats == NULL) {
+        ns_stats = malloc(sizeof(IqStats));
+        memset(ns_stats, 0, sizeof(IqStats));
+        ns_stats->ns = strdup(ns);
+        g_hash_table_insert(stats, ns_stats->ns, ns_stats);
+    }
+
+    return ns_stats;
+}
+
+GList*
+iq_tracker_stats_list(void)
+{
+    if (stats == NULL) {
+        return NULL;
+    }
+
+    return g_list_sort(g_hash_table_get_values(stats), (GCompareFunc)_iq_stats_compare);
+}
+
+int
+iq_tracker_bucket_limit(int bucket)
+{
+    if (bucket < 0 || bucket >= IQ_LATENCY_BUCKETS) {
+        return -1;
+    }
+
+    return latency_bucket_limits[bucket];
+}
+
+void
+iq_tracker_stats_reset(void)
+{
+    if (stats != NULL) {
+        g_hash_table_destroy(stats);
+        stats = NULL;
+    }
+}
+
+static void
+_iq_stats_free(IqStats *ns_stats)
+{
+    if (ns_stats != NULL) {
+        free(ns_stats->ns);
+        free(ns_stats);
+    }
+}
+
+static gint
+_iq_stats_compare(IqStats *a, IqStats *b)
+{
+    return g_strcmp0(a->ns, b->ns);
+}
+
+static gint
+_iq_request_deadline_compare(ProfIqRequest *a, ProfIqRequest *b)
+{
+    if (a->deadline < b->deadline) {
+        return -1;
+    } else if (a->deadline > b->deadline) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * iq_tracker.h
+ *
+ * Copyright (C) 2012 - 2014 James Booth <boothj5@gmail.com>
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef XMPP_IQ_TRACKER_H
+#define XMPP_IQ_TRACKER_H
+
+#include <glib.h>
+
+#include "xmpp/xmpp.h"
+
+// called when no response will arrive, with the reason
+typedef void (*ProfIqTimeoutCallback)(const char * const to, const char * const error,
+    void * const userdata);
+
+typedef struct prof_iq_request_t {
+    char *id;
+    char *ns;
+    char *to;
+    xmpp_handler func;
+    ProfIqTimeoutCallback timeout_func;
+    void *userdata;
+    GDestroyNotify free_func;
+    gint64 sent;
+    gint64 deadline;
+} ProfIqRequest;
+
+void iq_tracker_add(const char * const id, const char * const ns, const char * const to,
+    xmpp_handler func, ProfIqTimeoutCallback timeout_func, void * const userdata,
+    GDestroyNotify free_func, gint64 now, int timeout_millis);
+ProfIqRequest* iq_tracker_take(const char * const id);
+GList* iq_tracker_take_expired(gint64 now);
+void iq_tracker_request_free(ProfIqRequest *request);
+int iq_tracker_count(void);
+void iq_tracker_clear(void);
+
+void iq_tracker_record_response(ProfIqRequest *request, gboolean is_error, gint64 now);
+void iq_tracker_record_timeout(ProfIqRequest *request);
+void iq_tracker_record_latency(IqStats *ns_stats, int millis);
+IqStats* iq_tracker_stats(const char * const ns);
+GList* iq_tracker_stats_list(void);
+int iq_tracker_bucket_limit(int bucket);
+void iq_tracker_stats_reset(void);
+
+#endif
@@ -64,6 +64,8 @@ static int _captcha_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
 static int _message_error_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata);
+static void _handle_groupchat(xmpp_stanza_t * const stanza, const char * const room_jid,
+    const char * const room, const char * const nick);
 
 void
 message_add_handlers(void)
@@ -346,25 +348,41 @@ _captcha_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza,
 static int
 _groupchat_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
+{
+    char *room_jid = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
+    JidView jid;
+    if (!jid_view_parse(room_jid, &jid)) {
+        log_error("Invalid room JID: %s", room_jid);
+        return 1;
+    }
+
+    // held by the room while joined, so usually no allocation
+    const char *room = jid_intern_slice(jid.barejid);
+    _handle_groupchat(stanza, room_jid, room, jid.resourcepart.ptr);
+    jid_intern_release(room);
+
+    return 1;
+}
+
+static void
+_handle_groupchat(xmpp_stanza_t * const stanza, const char * const room_jid,
+    const char * const room, const char * const nick)
 {
     xmpp_ctx_t *ctx = connection_get_ctx();
     char *message = NULL;
-    char *room_jid = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
-    Jid *jid = jid_create(room_jid);
 
     // handle room subject
     xmpp_stanza_t *subject = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_SUBJECT);
     if (subject != NULL) {
         message = xmpp_stanza_get_text(subject);
-        handle_room_subject(jid->barejid, jid->resourcepart, message);
+        handle_room_subject(room, nick, message);
         xmpp_free(ctx, message);
 
-        jid_destroy(jid);
-        return 1;
+        return;
     }
 
     // handle room broadcasts
-    if (jid->resourcepart == NULL) {
+    if (nick == NULL) {
         xmpp_stanza_t *body = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_BODY);
         if (body != NULL) {
             message = xmpp_stanza_get_text(body);
@@ -374,21 +392,13 @@ _groupchat_handler(xmpp_conn_t * const conn,
             }
         }
 
-        jid_destroy(jid);
-        return 1;
-    }
-
-    if (!jid_is_valid_room_form(jid)) {
-        log_error("Invalid room JID: %s", jid->str);
-        jid_destroy(jid);
-        return 1;
+        return;
     }
 
     // room not active in profanity
-    if (!muc_active(jid->barejid)) {
-        log_error("Message received for inactive chat room: %s", jid->str);
-        jid_destroy(jid);
-        return 1;
+    if (!muc_active(room)) {
+        log_error("Message received for inactive chat room: %s", room_jid);
+        return;
     }
 
     // determine if the notifications happened whilst offline
@@ -400,18 +410,18 @@ _groupchat_handler(xmpp_conn_t * const conn,
     if (body != NULL) {
         message = xmpp_stanza_get_text(body);
         if (message != NULL) {
-            if (delayed) {
-                handle_room_history(jid->barejid, jid->resourcepart, tv_stamp, message);
+            // drop messages already received, e.g. history replayed when rejoining
+            char *id = xmpp_stanza_get_id(stanza);
+            if (muc_message_seen(room, id, nick)) {
+                log_debug("Dropping duplicate message %s from %s", id, room_jid);
+            } else if (delayed) {
+                handle_room_history(room, nick, tv_stamp, message);
             } else {
-                handle_room_message(jid->barejid, jid->resourcepart, message);
+                handle_room_message(room, nick, message);
             }
             xmpp_free(ctx, message);
         }
     }
-
-    jid_destroy(jid);
-
-    return 1;
 }
 
 static int
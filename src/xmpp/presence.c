@@ -185,12 +185,6 @@ presence_sub_request_exists(const char * const bare_jid)
     return result;
 }
 
-void
-presence_reset_sub_request_search(void)
-{
-    autocomplete_reset(sub_requests_ac);
-}
-
 void
 presence_update(const resource_presence_t presence_type, const char * const msg,
     const int idle)
@@ -281,7 +275,17 @@ presence_join_room(char *room, char *nick, char * passwd)
     int pri = accounts_get_priority_for_presence_type(jabber_get_account_name(),
         presence_type);
 
-    xmpp_stanza_t *presence = stanza_create_room_join_presence(ctx, jid->fulljid, passwd);
+    // only request history since the last message we received from the room,
+    // the server's default limit still applies
+    char *since = NULL;
+    GTimeVal last_seen;
+    if (muc_last_seen(room, &last_seen)) {
+        since = g_time_val_to_iso8601(&last_seen);
+    }
+
+    xmpp_stanza_t *presence = stanza_create_room_join_presence(ctx, jid->fulljid, passwd,
+        since, -1);
+    g_free(since);
     stanza_attach_show(ctx, presence, show);
     stanza_attach_status(ctx, presence, status);
     stanza_attach_priority(ctx, presence, pri);
@@ -464,37 +468,34 @@ static int
 _unavailable_handler(xmpp_conn_t * const conn,
     xmpp_stanza_t * const stanza, void * const userdata)
 {
-    const char *jid = xmpp_conn_get_jid(conn);
     char *from = xmpp_stanza_get_attribute(stanza, STANZA_ATTR_FROM);
     log_debug("Unavailable presence handler fired for %s", from);
 
-    Jid *my_jid = jid_create(jid);
-    Jid *from_jid = jid_create(from);
-    if (my_jid == NULL || from_jid == NULL) {
-        jid_destroy(my_jid);
-        jid_destroy(from_jid);
+    JidView from_jid;
+    if (!jid_view_parse(from, &from_jid)) {
         return 1;
     }
 
     char *status_str = stanza_get_status(stanza, NULL);
 
-    if (strcmp(my_jid->barejid, from_jid->barejid) !=0) {
-        if (from_jid->resourcepart != NULL) {
-            handle_contact_offline(from_jid->barejid, from_jid->resourcepart, status_str);
+    if (!jid_slice_equals(from_jid.barejid, jabber_get_barejid())) {
+        // held by the roster for known contacts, so usually no allocation
+        const char *barejid = jid_intern_slice(from_jid.barejid);
+        if (from_jid.resourcepart.ptr != NULL) {
+            handle_contact_offline(barejid, from_jid.resourcepart.ptr, status_str);
 
         // hack for servers that do not send full jid with unavailable presence
         } else {
-            handle_contact_offline(from_jid->barejid, "__prof_default", status_str);
+            handle_contact_offline(barejid, "__prof_default", status_str);
         }
+        jid_intern_release(barejid);
     } else {
-        if (from_jid->resourcepart != NULL) {
-            connection_remove_available_resource(from_jid->resourcepart);
+        if (from_jid.resourcepart.ptr != NULL) {
+            connection_remove_available_resource(from_jid.resourcepart.ptr);
         }
     }
 
     free(status_str);
-    jid_destroy(my_jid);
-    jid_destroy(from_jid);
 
     return 1;
 }
@@ -638,13 +639,14 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void *
     }
 
     // invalid from attribute
-    Jid *from_jid = jid_create(from);
-    if (from_jid == NULL || from_jid->resourcepart == NULL) {
+    JidView from_jid;
+    if (!jid_view_parse(from, &from_jid) || from_jid.resourcepart.ptr == NULL) {
         return 1;
     }
 
-    char *room = from_jid->barejid;
-    char *nick = from_jid->resourcepart;
+    // held by the room while joined, so usually no allocation
+    const char *room = jid_intern_slice(from_jid.barejid);
+    const char *nick = from_jid.resourcepart.ptr;
 
     char *show_str = stanza_get_show(stanza, "online");
     char *status_str = stanza_get_status(stanza, NULL);
@@ -665,7 +667,7 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void *
 
     // handle self presence
     if (stanza_is_muc_self_presence(stanza, jabber_get_fulljid())) {
-        log_debug("Room self presence received from %s", from_jid->fulljid);
+        log_debug("Room self presence received from %s", from);
 
         // self unavailable
         if (g_strcmp0(type, STANZA_TYPE_UNAVAILABLE) == 0) {
@@ -718,7 +720,7 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void *
 
     // handle presence from room members
     } else {
-        log_debug("Room presence received from %s", from_jid->fulljid);
+        log_debug("Room presence received from %s", from);
 
         if (g_strcmp0(type, STANZA_TYPE_UNAVAILABLE) == 0) {
 
@@ -771,7 +773,7 @@ _muc_user_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void *
 
     free(show_str);
     free(status_str);
-    jid_destroy(from_jid);
+    jid_intern_release(room);
 
     return 1;
 }
\ No newline at end of file
@@ -380,7 +380,8 @@ stanza_create_invite(xmpp_ctx_t *ctx, const char * const room,
 
 xmpp_stanza_t *
 stanza_create_room_join_presence(xmpp_ctx_t * const ctx,
-    const char * const full_room_jid, const char * const passwd)
+    const char * const full_room_jid, const char * const passwd,
+    const char * const history_since, int history_maxstanzas)
 {
     xmpp_stanza_t *presence = xmpp_stanza_new(ctx);
     xmpp_stanza_set_name(presence, STANZA_NAME_PRESENCE);
@@ -405,6 +406,22 @@ stanza_create_room_join_presence(xmpp_ctx_t * const ctx,
         xmpp_stanza_release(pass);
     }
 
+    // limit the discussion history sent by the room
+    if (history_since != NULL || history_maxstanzas >= 0) {
+        xmpp_stanza_t *history = xmpp_stanza_new(ctx);
+        xmpp_stanza_set_name(history, STANZA_NAME_HISTORY);
+        if (history_since != NULL) {
+            xmpp_stanza_set_attribute(history, STANZA_ATTR_SINCE, history_since);
+        }
+        if (history_maxstanzas >= 0) {
+            char *maxstanzas = g_strdup_printf("%d", history_maxstanzas);
+            xmpp_stanza_set_attribute(history, STANZA_ATTR_MAXSTANZAS, maxstanzas);
+            g_free(maxstanzas);
+        }
+        xmpp_stanza_add_child(x, history);
+        xmpp_stanza_release(history);
+    }
+
     xmpp_stanza_add_child(presence, x);
     xmpp_stanza_release(x);
 
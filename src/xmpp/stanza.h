@@ -73,6 +73,7 @@
 #define STANZA_NAME_STORAGE "storage"
 #define STANZA_NAME_NICK "nick"
 #define STANZA_NAME_PASSWORD "password"
+#define STANZA_NAME_HISTORY "history"
 #define STANZA_NAME_CONFERENCE "conference"
 #define STANZA_NAME_VALUE "value"
 #define STANZA_NAME_DESTROY "destroy"
@@ -133,6 +134,8 @@
 #define STANZA_ATTR_CATEGORY "category"
 #define STANZA_ATTR_REASON "reason"
 #define STANZA_ATTR_AUTOJOIN "autojoin"
+#define STANZA_ATTR_SINCE "since"
+#define STANZA_ATTR_MAXSTANZAS "maxstanzas"
 
 #define STANZA_TEXT_AWAY "away"
 #define STANZA_TEXT_DND "dnd"
@@ -186,7 +189,8 @@ xmpp_stanza_t* stanza_create_message(xmpp_ctx_t *ctx,
     const char * const message, const char * const state);
 
 xmpp_stanza_t* stanza_create_room_join_presence(xmpp_ctx_t * const ctx,
-    const char * const full_room_jid, const char * const passwd);
+    const char * const full_room_jid, const char * const passwd,
+    const char * const history_since, int history_maxstanzas);
 
 xmpp_stanza_t* stanza_create_room_newnick_presence(xmpp_ctx_t *ctx,
     const char * const full_room_jid);
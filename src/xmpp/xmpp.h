@@ -129,6 +129,19 @@ typedef struct data_form_t {
     gboolean modified;
 } DataForm;
 
+#define IQ_LATENCY_BUCKETS 8
+
+typedef struct iq_stats_t {
+    char *ns;
+    int sent;
+    int results;
+    int errors;
+    int timeouts;
+    int max_millis;
+    gint64 total_millis;
+    int buckets[IQ_LATENCY_BUCKETS];
+} IqStats;
+
 // connection functions
 void jabber_init(const int disable_tls);
 jabber_conn_status_t jabber_connect_with_details(const char * const jid,
@@ -138,6 +151,7 @@ void jabber_disconnect(void);
 void jabber_shutdown(void);
 void jabber_process_events(void);
 const char * jabber_get_fulljid(void);
+const char * jabber_get_barejid(void);
 const char * jabber_get_domain(void);
 jabber_conn_status_t jabber_get_connection_status(void);
 char * jabber_get_presence_message(void);
@@ -163,7 +177,6 @@ void message_send_invite(const char * const room, const char * const contact,
 void presence_subscription(const char * const jid, const jabber_subscr_t action);
 GSList* presence_get_subscription_requests(void);
 gint presence_sub_request_count(void);
-void presence_reset_sub_request_search(void);
 char * presence_sub_request_find(char * search_str);
 void presence_join_room(char *room, char *nick, char * passwd);
 void presence_change_room_nick(const char * const room, const char * const nick);
@@ -198,9 +211,17 @@ void iq_room_kick_occupant(const char * const room, const char * const nick, con
 void iq_room_role_set(const char * const room, const char * const nick, char *role,
     const char * const reason);
 void iq_room_role_list(const char * const room, char *role);
+GList * iq_stats_list(void);
+int iq_stats_bucket_limit(int bucket);
+int iq_outstanding_count(void);
+void iq_stats_reset(void);
+int iq_autoping_interval(void);
+IqStats * iq_autoping_stats(void);
+int iq_autoping_last_rtt(void);
 
 // caps functions
 Capabilities* caps_lookup(const char * const jid);
+void caps_preload(void);
 void caps_close(void);
 void caps_destroy(Capabilities *caps);
 
@@ -210,7 +231,7 @@ gboolean bookmark_remove(const char *jid);
 gboolean bookmark_join(const char *jid);
 const GList * bookmark_get_list(void);
 char * bookmark_find(char *search_str);
-void bookmark_autocomplete_reset(void);
+char * bookmark_fuzzy_find(char *search_str);
 
 void roster_send_name_change(const char * const barejid, const char * const new_name, GSList *groups);
 void roster_send_add_to_group(const char * const group, PContact contact);
@@ -231,7 +252,6 @@ gboolean form_field_contains_option(DataForm *form, const char * const tag, char
 int form_get_value_count(DataForm *form, const char * const tag);
 FormField* form_get_field_by_tag(DataForm *form, const char * const tag);
 Autocomplete form_get_value_ac(DataForm *form, const char * const tag);
-void form_reset_autocompleters(DataForm *form);
 
 GSList * form_get_non_form_type_fields_sorted(DataForm *form);
 GSList * form_get_field_values_sorted(FormField *field);
@@ -19,9 +19,6 @@ char * accounts_find_enabled(char *prefix)
     return NULL;
 }
 
-void accounts_reset_all_search(void) {}
-void accounts_reset_enabled_search(void) {}
-
 void accounts_add(const char *jid, const char *altdomain, const int port)
 {
     check_expected(jid);
@@ -95,6 +95,11 @@ char * otr_decrypt_message(const char * const from, const char * const message,
 
 void otr_free_message(char *message) {}
 
+OtrStats* otr_stats(const char * const recipient)
+{
+    return NULL;
+}
+
 prof_otrpolicy_t otr_get_policy(const char * const recipient)
 {
     return PROF_OTRPOLICY_MANUAL;
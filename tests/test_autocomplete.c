@@ -4,6 +4,7 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "contact.h"
 #include "tools/autocomplete.h"
@@ -117,3 +118,183 @@ void add_two_same_updates(void **state)
     autocomplete_clear(ac);
     g_slist_free_full(result, g_free);
 }
+
+void complete_cycles_matches_in_order(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "help");
+    autocomplete_add(ac, "hello");
+    autocomplete_add(ac, "other");
+    autocomplete_add(ac, "hel");
+
+    char *result1 = autocomplete_complete(ac, "hel", FALSE);
+    char *result2 = autocomplete_complete(ac, "hel", FALSE);
+    char *result3 = autocomplete_complete(ac, "hel", FALSE);
+    char *result4 = autocomplete_complete(ac, "hel", FALSE);
+
+    assert_string_equal("hel", result1);
+    assert_string_equal("hello", result2);
+    assert_string_equal("help", result3);
+    assert_string_equal("hel", result4);
+
+    free(result1);
+    free(result2);
+    free(result3);
+    free(result4);
+    autocomplete_free(ac);
+}
+
+void remove_keeps_remaining_items(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "hel");
+    autocomplete_add(ac, "hello");
+    autocomplete_add(ac, "help");
+    autocomplete_remove(ac, "hel");
+    autocomplete_remove(ac, "missing");
+    GSList *result = autocomplete_create_list(ac);
+
+    assert_int_equal(2, autocomplete_length(ac));
+    assert_false(autocomplete_contains(ac, "hel"));
+    assert_string_equal("hello", result->data);
+    assert_string_equal("help", result->next->data);
+
+    g_slist_free_full(result, g_free);
+    autocomplete_free(ac);
+}
+
+void fuzzy_complete_matches_characters_in_order(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "alice@server.org");
+    autocomplete_add(ac, "bob@server.org");
+    autocomplete_add(ac, "albert");
+
+    char *result1 = autocomplete_complete_fuzzy(ac, "ae", FALSE, NULL);
+    char *result2 = autocomplete_complete_fuzzy(ac, "ae", FALSE, NULL);
+    char *result3 = autocomplete_complete_fuzzy(ac, "ae", FALSE, NULL);
+
+    assert_string_equal("albert", result1);
+    assert_string_equal("alice@server.org", result2);
+    assert_string_equal("albert", result3);
+
+    free(result1);
+    free(result2);
+    free(result3);
+    autocomplete_free(ac);
+}
+
+static int
+_weight_alice(const char * const item)
+{
+    if (g_strcmp0(item, "alice") == 0) {
+        return 100;
+    } else {
+        return 0;
+    }
+}
+
+void fuzzy_complete_returns_highest_weight_first(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "alex");
+    autocomplete_add(ac, "alice");
+
+    char *result = autocomplete_complete_fuzzy(ac, "al", FALSE, _weight_alice);
+
+    assert_string_equal("alice", result);
+
+    free(result);
+    autocomplete_free(ac);
+}
+
+static int
+_weight_malice(const char * const item)
+{
+    if (g_strcmp0(item, "malice") == 0) {
+        return 1000;
+    } else {
+        return 0;
+    }
+}
+
+void fuzzy_complete_weight_does_not_beat_better_match(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "alex");
+    autocomplete_add(ac, "malice");
+
+    char *result = autocomplete_complete_fuzzy(ac, "al", FALSE, _weight_malice);
+
+    assert_string_equal("alex", result);
+
+    free(result);
+    autocomplete_free(ac);
+}
+
+void reset_all_starts_new_search(void **state)
+{
+    Autocomplete ac = autocomplete_new();
+    autocomplete_add(ac, "hello");
+    autocomplete_add(ac, "help");
+    autocomplete_add(ac, "other");
+
+    char *result1 = autocomplete_complete(ac, "hel", FALSE);
+    autocomplete_reset_all();
+    char *result2 = autocomplete_complete(ac, "oth", FALSE);
+
+    assert_string_equal("hello", result1);
+    assert_string_equal("other", result2);
+
+    free(result1);
+    free(result2);
+    autocomplete_free(ac);
+}
+
+void borrowed_cycles_in_order(void **state)
+{
+    Autocomplete ac = autocomplete_new_borrowed(NULL);
+    autocomplete_add(ac, "helper");
+    autocomplete_add(ac, "hello");
+    autocomplete_add(ac, "other");
+
+    char *result1 = autocomplete_complete(ac, "hel", FALSE);
+    char *result2 = autocomplete_complete(ac, "hel", FALSE);
+    char *result3 = autocomplete_complete(ac, "hel", FALSE);
+
+    assert_string_equal("hello", result1);
+    assert_string_equal("helper", result2);
+    assert_string_equal("hello", result3);
+
+    free(result1);
+    free(result2);
+    free(result3);
+    autocomplete_free(ac);
+}
+
+static int released = 0;
+
+static void
+_count_release(gpointer item)
+{
+    released++;
+    free(item);
+}
+
+void borrowed_releases_duplicates_and_removed(void **state)
+{
+    released = 0;
+    Autocomplete ac = autocomplete_new_borrowed(_count_release);
+    autocomplete_add(ac, strdup("james"));
+    autocomplete_add(ac, strdup("james"));
+    assert_int_equal(1, released);
+    assert_true(autocomplete_contains(ac, "james"));
+
+    autocomplete_remove(ac, "james");
+    assert_int_equal(2, released);
+    assert_false(autocomplete_contains(ac, "james"));
+
+    autocomplete_add(ac, strdup("bob"));
+    autocomplete_free(ac);
+    assert_int_equal(3, released);
+}
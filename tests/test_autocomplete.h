@@ -8,3 +8,11 @@ void add_two_and_complete_returns_second(void **state);
 void add_two_adds_two(void **state);
 void add_two_same_adds_one(void **state);
 void add_two_same_updates(void **state);
+void complete_cycles_matches_in_order(void **state);
+void remove_keeps_remaining_items(void **state);
+void fuzzy_complete_matches_characters_in_order(void **state);
+void fuzzy_complete_returns_highest_weight_first(void **state);
+void fuzzy_complete_weight_does_not_beat_better_match(void **state);
+void reset_all_starts_new_search(void **state);
+void borrowed_cycles_in_order(void **state);
+void borrowed_releases_duplicates_and_removed(void **state);
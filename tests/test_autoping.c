@@ -0,0 +1,97 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <glib.h>
+
+#include "xmpp/autoping.h"
+
+void interval_is_preference_until_pong_missed(void **state)
+{
+    autoping_reset();
+
+    assert_int_equal(60, autoping_interval(60));
+    assert_int_equal(0, autoping_interval(0));
+    assert_int_equal(AUTOPING_TIMEOUT_SECS, autoping_timeout(60));
+    assert_int_equal(5, autoping_timeout(5));
+}
+
+void single_missed_pong_does_not_close(void **state)
+{
+    autoping_reset();
+
+    assert_false(autoping_missed(60));
+    assert_int_equal(1, autoping_misses());
+    assert_int_equal(30, autoping_interval(60));
+}
+
+void consecutive_missed_pongs_close(void **state)
+{
+    autoping_reset();
+
+    int i;
+    for (i = 1; i < AUTOPING_MAX_MISSES; i++) {
+        assert_false(autoping_missed(60));
+    }
+    assert_true(autoping_missed(60));
+    assert_int_equal(0, autoping_misses());
+}
+
+void pong_resets_missed_count(void **state)
+{
+    autoping_reset();
+
+    int i;
+    for (i = 1; i < AUTOPING_MAX_MISSES; i++) {
+        assert_false(autoping_missed(60));
+    }
+    autoping_pong(60);
+    assert_int_equal(0, autoping_misses());
+    assert_false(autoping_missed(60));
+}
+
+void missed_pongs_halve_interval_to_minimum(void **state)
+{
+    autoping_reset();
+
+    autoping_missed(60);
+    assert_int_equal(30, autoping_interval(60));
+    autoping_missed(60);
+    assert_int_equal(15, autoping_interval(60));
+    autoping_pong(60);
+    autoping_missed(60);
+    assert_int_equal(AUTOPING_MIN_INTERVAL_SECS, autoping_interval(60));
+}
+
+void pongs_grow_interval_back_to_preference(void **state)
+{
+    autoping_reset();
+    autoping_missed(40);
+    assert_int_equal(20, autoping_interval(40));
+
+    int i;
+    for (i = 1; i < AUTOPING_GROW_AFTER; i++) {
+        assert_false(autoping_pong(40));
+    }
+    assert_true(autoping_pong(40));
+    assert_int_equal(30, autoping_interval(40));
+
+    for (i = 1; i < AUTOPING_GROW_AFTER; i++) {
+        autoping_pong(40);
+    }
+    assert_true(autoping_pong(40));
+    assert_int_equal(40, autoping_interval(40));
+    assert_false(autoping_pong(40));
+}
+
+void connected_keeps_interval_clears_misses(void **state)
+{
+    autoping_reset();
+    autoping_missed(60);
+
+    autoping_connected();
+
+    assert_int_equal(0, autoping_misses());
+    assert_int_equal(30, autoping_interval(60));
+}
@@ -0,0 +1,7 @@
+void interval_is_preference_until_pong_missed(void **state);
+void single_missed_pong_does_not_close(void **state);
+void consecutive_missed_pongs_close(void **state);
+void pong_resets_missed_count(void **state);
+void missed_pongs_halve_interval_to_minimum(void **state);
+void pongs_grow_interval_back_to_preference(void **state);
+void connected_keeps_interval_clears_misses(void **state);
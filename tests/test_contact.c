@@ -405,3 +405,43 @@ void contact_available_when_highest_priority_chat(void **state)
 
     p_contact_free(contact);
 }
+
+void contact_presence_next_highest_when_highest_removed(void **state)
+{
+    PContact contact = p_contact_new("bob@server.com", "bob", NULL, "both",
+        "is offline", FALSE);
+
+    Resource *resource10 = resource_new("resource10", RESOURCE_ONLINE, NULL, 10);
+    Resource *resource20 = resource_new("resource20", RESOURCE_AWAY, "gone", 20);
+    p_contact_set_presence(contact, resource10);
+    p_contact_set_presence(contact, resource20);
+    p_contact_remove_resource(contact, "resource20");
+
+    assert_string_equal("online", p_contact_presence(contact));
+    assert_null(p_contact_status(contact));
+
+    p_contact_remove_resource(contact, "resource10");
+
+    assert_string_equal("offline", p_contact_presence(contact));
+    assert_string_equal("is offline", p_contact_status(contact));
+
+    p_contact_free(contact);
+}
+
+void contact_presence_updated_when_highest_replaced(void **state)
+{
+    PContact contact = p_contact_new("bob@server.com", "bob", NULL, "both",
+        "is offline", FALSE);
+
+    Resource *resource10 = resource_new("resource10", RESOURCE_AWAY, NULL, 10);
+    Resource *resource20 = resource_new("resource20", RESOURCE_CHAT, NULL, 20);
+    p_contact_set_presence(contact, resource10);
+    p_contact_set_presence(contact, resource20);
+
+    Resource *replacement = resource_new("resource20", RESOURCE_DND, NULL, 5);
+    p_contact_set_presence(contact, replacement);
+
+    assert_string_equal("away", p_contact_presence(contact));
+
+    p_contact_free(contact);
+}
@@ -22,3 +22,5 @@ void contact_not_available_when_highest_priority_xa(void **state);
 void contact_not_available_when_highest_priority_dnd(void **state);
 void contact_available_when_highest_priority_online(void **state);
 void contact_available_when_highest_priority_chat(void **state);
+void contact_presence_next_highest_when_highest_removed(void **state);
+void contact_presence_updated_when_highest_replaced(void **state);
@@ -0,0 +1,101 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "tools/filewriter.h"
+
+#define TEST_FILE "./tests/files/xdg_config_home/profanity/filewriter"
+
+static const char *contents = NULL;
+
+static gchar *
+_serialise(gsize *length)
+{
+    *length = strlen(contents);
+    return g_strdup(contents);
+}
+
+static gchar *
+_read_test_file(void)
+{
+    gchar *data = NULL;
+    g_file_get_contents(TEST_FILE, &data, NULL, NULL);
+    return data;
+}
+
+void flush_writes_changed_contents(void **state)
+{
+    contents = "[ui]\nbeep=true\n";
+    FileWriter writer = filewriter_new(TEST_FILE, _serialise, 60000);
+
+    filewriter_changed(writer);
+    filewriter_flush(writer);
+    gchar *data = _read_test_file();
+
+    assert_string_equal("[ui]\nbeep=true\n", data);
+
+    g_free(data);
+    filewriter_free(writer);
+    remove(TEST_FILE);
+}
+
+void nothing_written_before_delay(void **state)
+{
+    contents = "[ui]\nbeep=true\n";
+    FileWriter writer = filewriter_new(TEST_FILE, _serialise, 60000);
+
+    filewriter_changed(writer);
+    filewriter_tick();
+    gchar *before_free = _read_test_file();
+    filewriter_free(writer);
+    gchar *after_free = _read_test_file();
+
+    assert_null(before_free);
+    assert_string_equal("[ui]\nbeep=true\n", after_free);
+
+    g_free(after_free);
+    remove(TEST_FILE);
+}
+
+void unchanged_contents_not_written(void **state)
+{
+    g_file_set_contents(TEST_FILE, "[ui]\nbeep=true\n", -1, NULL);
+    contents = "[ui]\nbeep=true\n";
+    FileWriter writer = filewriter_new(TEST_FILE, _serialise, 0);
+
+    // changed on disk behind the writer's back
+    g_file_set_contents(TEST_FILE, "[ui]\nbeep=false\n", -1, NULL);
+    filewriter_changed(writer);
+    filewriter_flush(writer);
+    gchar *data = _read_test_file();
+
+    assert_string_equal("[ui]\nbeep=false\n", data);
+
+    g_free(data);
+    filewriter_free(writer);
+    remove(TEST_FILE);
+}
+
+void writer_thread_writes_changed_contents(void **state)
+{
+    filewriter_init();
+    contents = "[ui]\nbeep=true\n";
+    FileWriter writer = filewriter_new(TEST_FILE, _serialise, 0);
+
+    filewriter_changed(writer);
+    contents = "[ui]\nbeep=false\n";
+    filewriter_changed(writer);
+    filewriter_free(writer);
+    filewriter_shutdown();
+    gchar *data = _read_test_file();
+
+    assert_string_equal("[ui]\nbeep=false\n", data);
+
+    g_free(data);
+    remove(TEST_FILE);
+}
@@ -0,0 +1,4 @@
+void flush_writes_changed_contents(void **state);
+void nothing_written_before_delay(void **state);
+void unchanged_contents_not_written(void **state);
+void writer_thread_writes_changed_contents(void **state);
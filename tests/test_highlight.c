@@ -0,0 +1,97 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/highlight.h"
+
+void highlight_matches_nick_as_word(void **state)
+{
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, "bob", HIGHLIGHT_NICK);
+
+    assert_int_equal(HIGHLIGHT_NICK, highlight_match(hl, "hello bob, how are you"));
+    assert_int_equal(HIGHLIGHT_NICK, highlight_match(hl, "bob"));
+
+    highlight_free(hl);
+}
+
+void highlight_ignores_case(void **state)
+{
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, "Bob", HIGHLIGHT_NICK);
+
+    assert_int_equal(HIGHLIGHT_NICK, highlight_match(hl, "BOB: ping"));
+
+    highlight_free(hl);
+}
+
+void highlight_does_not_match_inside_word(void **state)
+{
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, "bob", HIGHLIGHT_NICK);
+
+    assert_int_equal(HIGHLIGHT_NONE, highlight_match(hl, "bobby and kabob"));
+
+    highlight_free(hl);
+}
+
+void highlight_matches_after_partial_match(void **state)
+{
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, "abc", HIGHLIGHT_KEYWORD);
+    highlight_add_word(hl, "bcd", HIGHLIGHT_NICK);
+
+    assert_int_equal(HIGHLIGHT_NONE, highlight_match(hl, "abcd"));
+    assert_int_equal(HIGHLIGHT_NICK, highlight_match(hl, "ab bcd"));
+    assert_int_equal(HIGHLIGHT_NICK | HIGHLIGHT_KEYWORD, highlight_match(hl, "abc bcd"));
+
+    highlight_free(hl);
+}
+
+void highlight_matches_non_word_edges(void **state)
+{
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, "@ops", HIGHLIGHT_KEYWORD);
+
+    assert_int_equal(HIGHLIGHT_KEYWORD, highlight_match(hl, "need help@ops"));
+    assert_int_equal(HIGHLIGHT_NONE, highlight_match(hl, "@opsteam"));
+
+    highlight_free(hl);
+}
+
+void highlight_matches_utf8_case(void **state)
+{
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, "Ärger", HIGHLIGHT_KEYWORD);
+
+    assert_int_equal(HIGHLIGHT_KEYWORD, highlight_match(hl, "kein ärger hier"));
+    assert_int_equal(HIGHLIGHT_NONE, highlight_match(hl, "verärgert"));
+
+    highlight_free(hl);
+}
+
+void highlight_matches_regex(void **state)
+{
+    Highlight hl = highlight_new();
+    highlight_add_word(hl, "bob", HIGHLIGHT_NICK);
+    gboolean added = highlight_add_regex(hl, "deploy(ed|ing)?", HIGHLIGHT_KEYWORD);
+
+    assert_true(added);
+    assert_int_equal(HIGHLIGHT_KEYWORD, highlight_match(hl, "DEPLOYING now"));
+    assert_int_equal(HIGHLIGHT_NICK | HIGHLIGHT_KEYWORD, highlight_match(hl, "bob deployed"));
+
+    highlight_free(hl);
+}
+
+void highlight_rejects_bad_regex(void **state)
+{
+    Highlight hl = highlight_new();
+
+    assert_false(highlight_add_regex(hl, "deploy(", HIGHLIGHT_KEYWORD));
+    assert_int_equal(HIGHLIGHT_NONE, highlight_match(hl, "deploy("));
+
+    highlight_free(hl);
+}
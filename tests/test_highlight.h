@@ -0,0 +1,8 @@
+void highlight_matches_nick_as_word(void **state);
+void highlight_ignores_case(void **state);
+void highlight_does_not_match_inside_word(void **state);
+void highlight_matches_after_partial_match(void **state);
+void highlight_matches_non_word_edges(void **state);
+void highlight_matches_utf8_case(void **state);
+void highlight_matches_regex(void **state);
+void highlight_rejects_bad_regex(void **state);
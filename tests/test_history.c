@@ -217,3 +217,69 @@ void start_session_add_new_submit_previous(void **state)
 
     history_append(history, item3);
 }
+
+void full_history_drops_oldest(void **state)
+{
+    History history = history_new(2);
+    history_append(history, "first");
+    history_append(history, "second");
+    history_append(history, "third");
+
+    assert_int_equal(2, history_length(history));
+    assert_string_equal("second", history_get(history, 0));
+    assert_string_equal("third", history_get(history, 1));
+
+    history_free(history);
+}
+
+void search_returns_newest_match_first(void **state)
+{
+    History history = history_new(10);
+    history_append(history, "/join room@server");
+    history_append(history, "hello");
+    history_append(history, "/join other@server");
+
+    int index1 = history_search(history, "join", history_length(history));
+    int index2 = history_search(history, "join", index1);
+    int index3 = history_search(history, "join", index2);
+
+    assert_int_equal(2, index1);
+    assert_int_equal(0, index2);
+    assert_int_equal(-1, index3);
+
+    history_free(history);
+}
+
+void search_skips_dropped_items(void **state)
+{
+    History history = history_new(2);
+    history_append(history, "/join room@server");
+    history_append(history, "hello");
+    history_append(history, "again");
+
+    int index = history_search(history, "join", history_length(history));
+
+    assert_int_equal(-1, index);
+
+    history_free(history);
+}
+
+void search_finds_edited_item(void **state)
+{
+    History history = history_new(10);
+    history_append(history, "hello");
+    history_append(history, "again");
+
+    char *item1 = history_previous(history, "new item");
+    char *item2 = history_previous(history, "changed");
+    history_append(history, "new item");
+
+    int index = history_search(history, "changed", history_length(history));
+
+    assert_int_equal(1, index);
+    assert_string_equal("changed", history_get(history, index));
+
+    free(item1);
+    free(item2);
+    history_free(history);
+}
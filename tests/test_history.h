@@ -11,3 +11,7 @@ void navigate_then_append_new(void **state);
 void edit_item_mid_history(void **state);
 void edit_previous_and_append(void **state);
 void start_session_add_new_submit_previous(void **state);
+void full_history_drops_oldest(void **state);
+void search_returns_newest_match_first(void **state);
+void search_skips_dropped_items(void **state);
+void search_finds_edited_item(void **state);
@@ -0,0 +1,77 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include "tools/http.h"
+
+typedef struct response_t {
+    int calls;
+    gboolean had_body;
+    int frees;
+} Response;
+
+static void
+_response(const char * const body, void *userdata)
+{
+    Response *response = userdata;
+    response->calls++;
+    response->had_body = (body != NULL);
+}
+
+static void
+_response_free(void *userdata)
+{
+    Response *response = userdata;
+    response->frees++;
+}
+
+void failed_request_answered_in_place_without_init(void **state)
+{
+    Response response = { 0, FALSE, 0 };
+
+    http_get("nope://example.com/", 1, 0, _response, &response, _response_free);
+
+    assert_int_equal(1, response.calls);
+    assert_false(response.had_body);
+    assert_int_equal(1, response.frees);
+}
+
+void failed_request_answered_from_main_loop(void **state)
+{
+    Response response = { 0, FALSE, 0 };
+
+    http_init();
+    http_get("nope://example.com/", 1, 0, _response, &response, _response_free);
+    assert_int_equal(0, response.calls);
+
+    int tries = 0;
+    while (response.calls == 0 && tries++ < 100) {
+        http_process();
+        usleep(10000);
+    }
+    http_shutdown();
+
+    assert_int_equal(1, response.calls);
+    assert_false(response.had_body);
+    assert_int_equal(1, response.frees);
+}
+
+void shutdown_frees_requests_in_flight(void **state)
+{
+    Response first = { 0, FALSE, 0 };
+    Response second = { 0, FALSE, 0 };
+
+    http_init();
+    http_get("nope://example.com/", 1, 0, _response, &first, _response_free);
+    http_get("nope://example.com/", 1, 0, _response, &second, _response_free);
+    http_shutdown();
+
+    assert_int_equal(0, first.calls);
+    assert_int_equal(1, first.frees);
+    assert_int_equal(0, second.calls);
+    assert_int_equal(1, second.frees);
+}
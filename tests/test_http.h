@@ -0,0 +1,3 @@
+void failed_request_answered_in_place_without_init(void **state);
+void failed_request_answered_from_main_loop(void **state);
+void shutdown_frees_requests_in_flight(void **state);
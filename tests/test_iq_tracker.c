@@ -0,0 +1,138 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "xmpp/iq_tracker.h"
+
+static int
+_handler(xmpp_conn_t * const conn, xmpp_stanza_t * const stanza, void * const userdata)
+{
+    return 0;
+}
+
+static void
+_count_free(void *userdata)
+{
+    int *frees = userdata;
+    (*frees)++;
+}
+
+void request_retired_on_response(void **state)
+{
+    int frees = 0;
+    iq_tracker_add("id1", "ns", "room@server", _handler, NULL, &frees, _count_free, 1000, 30000);
+    assert_int_equal(1, iq_tracker_count());
+
+    ProfIqRequest *request = iq_tracker_take("id1");
+    assert_non_null(request);
+    assert_string_equal("room@server", request->to);
+    assert_int_equal(0, iq_tracker_count());
+    assert_null(iq_tracker_take("id1"));
+
+    iq_tracker_request_free(request);
+    assert_int_equal(1, frees);
+
+    iq_tracker_clear();
+    iq_tracker_stats_reset();
+}
+
+void request_retired_on_timeout(void **state)
+{
+    iq_tracker_add("id1", "ns", NULL, _handler, NULL, NULL, NULL, 1000, 30000);
+    iq_tracker_add("id2", "ns", NULL, _handler, NULL, NULL, NULL, 2000, 5000);
+
+    assert_null(iq_tracker_take_expired(6999));
+
+    GList *expired = iq_tracker_take_expired(7000);
+    assert_int_equal(1, g_list_length(expired));
+    ProfIqRequest *request = expired->data;
+    assert_string_equal("id2", request->id);
+    iq_tracker_request_free(request);
+    g_list_free(expired);
+
+    assert_int_equal(1, iq_tracker_count());
+    assert_null(iq_tracker_take("id2"));
+
+    expired = iq_tracker_take_expired(31000);
+    assert_int_equal(1, g_list_length(expired));
+    g_list_free_full(expired, (GDestroyNotify)iq_tracker_request_free);
+    assert_int_equal(0, iq_tracker_count());
+
+    iq_tracker_clear();
+    iq_tracker_stats_reset();
+}
+
+void reused_id_replaces_request(void **state)
+{
+    int frees = 0;
+    iq_tracker_add("id1", "ns", NULL, _handler, NULL, &frees, _count_free, 1000, 30000);
+    iq_tracker_add("id1", "ns", NULL, _handler, NULL, NULL, NULL, 2000, 30000);
+
+    assert_int_equal(1, iq_tracker_count());
+    assert_int_equal(1, frees);
+
+    iq_tracker_clear();
+    iq_tracker_stats_reset();
+}
+
+void clear_frees_outstanding_userdata(void **state)
+{
+    int frees = 0;
+    iq_tracker_add("id1", "ns", NULL, _handler, NULL, &frees, _count_free, 1000, 30000);
+    iq_tracker_add("id2", "ns", NULL, _handler, NULL, &frees, _count_free, 1000, 30000);
+
+    iq_tracker_clear();
+
+    assert_int_equal(0, iq_tracker_count());
+    assert_int_equal(2, frees);
+
+    iq_tracker_stats_reset();
+}
+
+void stats_count_responses_and_timeouts(void **state)
+{
+    iq_tracker_add("id1", "ns1", NULL, _handler, NULL, NULL, NULL, 1000, 30000);
+    iq_tracker_add("id2", "ns1", NULL, _handler, NULL, NULL, NULL, 1000, 30000);
+    iq_tracker_add("id3", "ns1", NULL, _handler, NULL, NULL, NULL, 1000, 30000);
+    iq_tracker_add("id4", "ns2", NULL, _handler, NULL, NULL, NULL, 1000, 30000);
+
+    ProfIqRequest *request = iq_tracker_take("id1");
+    iq_tracker_record_response(request, FALSE, 1040);
+    iq_tracker_request_free(request);
+
+    request = iq_tracker_take("id2");
+    iq_tracker_record_response(request, TRUE, 1300);
+    iq_tracker_request_free(request);
+
+    request = iq_tracker_take("id3");
+    iq_tracker_record_timeout(request);
+    iq_tracker_request_free(request);
+
+    GList *stats = iq_tracker_stats_list();
+    assert_int_equal(2, g_list_length(stats));
+
+    IqStats *ns1 = stats->data;
+    assert_string_equal("ns1", ns1->ns);
+    assert_int_equal(3, ns1->sent);
+    assert_int_equal(1, ns1->results);
+    assert_int_equal(1, ns1->errors);
+    assert_int_equal(1, ns1->timeouts);
+    assert_int_equal(300, ns1->max_millis);
+    assert_int_equal(340, ns1->total_millis);
+    assert_int_equal(1, ns1->buckets[0]);
+    assert_int_equal(1, ns1->buckets[3]);
+
+    IqStats *ns2 = stats->next->data;
+    assert_string_equal("ns2", ns2->ns);
+    assert_int_equal(1, ns2->sent);
+    assert_int_equal(0, ns2->results);
+    g_list_free(stats);
+
+    iq_tracker_clear();
+    iq_tracker_stats_reset();
+    assert_null(iq_tracker_stats_list());
+}
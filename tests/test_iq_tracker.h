@@ -0,0 +1,5 @@
+void request_retired_on_response(void **state);
+void request_retired_on_timeout(void **state);
+void reused_id_replaces_request(void **state);
+void clear_frees_outstanding_userdata(void **state);
+void stats_count_responses_and_timeouts(void **state);
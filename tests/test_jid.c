@@ -3,6 +3,7 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "jid.h"
 
@@ -182,4 +183,97 @@ void returns_barejid_when_fulljid_not_exists(void **state)
     char *result = jid_fulljid_or_barejid(jid);
 
     assert_string_equal("localpart@domainpart", result);
-}
\ No newline at end of file
+}
+
+void parse_view_from_null_returns_false(void **state)
+{
+    JidView view;
+    assert_false(jid_view_parse(NULL, &view));
+}
+
+void parse_view_from_empty_string_returns_false(void **state)
+{
+    JidView view;
+    assert_false(jid_view_parse("", &view));
+}
+
+void parse_view_from_full_returns_parts(void **state)
+{
+    JidView view;
+    assert_true(jid_view_parse("myuser@mydomain/laptop", &view));
+
+    assert_true(jid_slice_equals(view.localpart, "myuser"));
+    assert_true(jid_slice_equals(view.domainpart, "mydomain"));
+    assert_true(jid_slice_equals(view.barejid, "myuser@mydomain"));
+    assert_string_equal("laptop", view.resourcepart.ptr);
+}
+
+void parse_view_from_bare_returns_null_resource(void **state)
+{
+    JidView view;
+    assert_true(jid_view_parse("myuser@mydomain", &view));
+
+    assert_true(jid_slice_equals(view.barejid, "myuser@mydomain"));
+    assert_null(view.resourcepart.ptr);
+}
+
+void parse_view_from_nolocal_returns_null_localpart(void **state)
+{
+    JidView view;
+    assert_true(jid_view_parse("mydomain/laptop", &view));
+
+    assert_null(view.localpart.ptr);
+    assert_true(jid_slice_equals(view.domainpart, "mydomain"));
+    assert_true(jid_slice_equals(view.barejid, "mydomain"));
+}
+
+void parse_view_with_at_and_slash_in_resource(void **state)
+{
+    JidView view;
+    assert_true(jid_view_parse("room@conference.domain.org/my@nick/something", &view));
+
+    assert_true(jid_slice_equals(view.localpart, "room"));
+    assert_true(jid_slice_equals(view.barejid, "room@conference.domain.org"));
+    assert_string_equal("my@nick/something", view.resourcepart.ptr);
+}
+
+void intern_returns_same_pointer_for_equal_jids(void **state)
+{
+    char *jid1 = strdup("room@conference.server");
+    char *jid2 = strdup("room@conference.server");
+
+    const char *result1 = jid_intern(jid1);
+    const char *result2 = jid_intern(jid2);
+
+    assert_string_equal("room@conference.server", result1);
+    assert_ptr_equal(result1, result2);
+
+    free(jid1);
+    free(jid2);
+    jid_intern_release(result1);
+    jid_intern_release(result2);
+}
+
+void intern_barejid_matches_interned_bare(void **state)
+{
+    const char *bare = jid_intern("room@conference.server");
+    const char *result = jid_intern_barejid("room@conference.server/nick");
+
+    assert_ptr_equal(bare, result);
+
+    jid_intern_release(bare);
+    jid_intern_release(result);
+}
+
+void intern_release_last_reference_removes_jid(void **state)
+{
+    const char *result1 = jid_intern("room@conference.server");
+    const char *result2 = jid_intern("room@conference.server");
+    assert_int_equal(1, jid_intern_size());
+
+    jid_intern_release(result1);
+    assert_int_equal(1, jid_intern_size());
+
+    jid_intern_release(result2);
+    assert_int_equal(0, jid_intern_size());
+}
@@ -23,3 +23,12 @@ void create_with_at_and_slash_in_resource(void **state);
 void create_full_with_trailing_slash(void **state);
 void returns_fulljid_when_exists(void **state);
 void returns_barejid_when_fulljid_not_exists(void **state);
+void parse_view_from_null_returns_false(void **state);
+void parse_view_from_empty_string_returns_false(void **state);
+void parse_view_from_full_returns_parts(void **state);
+void parse_view_from_bare_returns_null_resource(void **state);
+void parse_view_from_nolocal_returns_null_localpart(void **state);
+void parse_view_with_at_and_slash_in_resource(void **state);
+void intern_returns_same_pointer_for_equal_jids(void **state);
+void intern_barejid_matches_interned_bare(void **state);
+void intern_release_last_reference_removes_jid(void **state);
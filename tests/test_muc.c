@@ -3,7 +3,9 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <stdlib.h>
+#include <stdio.h>
 
+#include "jid.h"
 #include "muc.h"
 
 void muc_before_test(void **state)
@@ -76,3 +78,208 @@ void test_muc_active(void **state)
 
     assert_true(room_is_active);
 }
+
+void test_muc_message_not_seen_first_time(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+
+    gboolean seen = muc_message_seen(room, "id1", "alice");
+
+    assert_false(seen);
+}
+
+void test_muc_message_seen_second_time(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_message_seen(room, "id1", "alice");
+
+    gboolean seen = muc_message_seen(room, "id1", "alice");
+
+    assert_true(seen);
+}
+
+void test_muc_message_same_id_other_sender_not_seen(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_message_seen(room, "id1", "alice");
+
+    assert_false(muc_message_seen(room, "id1", "mike"));
+}
+
+void test_muc_message_seen_forgets_oldest(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    int i;
+    for (i = 0; i <= MUC_SEEN_IDS_MAX; i++) {
+        char id[16];
+        sprintf(id, "id%d", i);
+        muc_message_seen(room, id, "alice");
+    }
+
+    assert_true(muc_message_seen(room, "id1", "alice"));
+    assert_false(muc_message_seen(room, "id0", "alice"));
+}
+
+void test_muc_last_seen_not_set(void **state)
+{
+    GTimeVal tv_stamp;
+
+    gboolean result = muc_last_seen("room@server.org", &tv_stamp);
+
+    assert_false(result);
+}
+
+void test_muc_last_seen_keeps_latest(void **state)
+{
+    char *room = "room@server.org";
+    GTimeVal later = { 2000, 0 };
+    GTimeVal earlier = { 1000, 0 };
+    muc_set_last_seen(room, &later);
+    muc_set_last_seen(room, &earlier);
+
+    GTimeVal tv_stamp;
+    gboolean result = muc_last_seen(room, &tv_stamp);
+
+    assert_true(result);
+    assert_int_equal(2000, tv_stamp.tv_sec);
+}
+
+void test_muc_last_seen_now_allows_for_clock_skew(void **state)
+{
+    char *room = "room@server.org";
+    GTimeVal before;
+    g_get_current_time(&before);
+
+    muc_set_last_seen_now(room);
+
+    GTimeVal tv_stamp;
+    assert_true(muc_last_seen(room, &tv_stamp));
+    assert_true(tv_stamp.tv_sec >= before.tv_sec - MUC_CLOCK_SKEW_SECS);
+    assert_true(tv_stamp.tv_sec <= before.tv_sec + 1 - MUC_CLOCK_SKEW_SECS);
+}
+
+void test_muc_pending_history_in_order(void **state)
+{
+    char *room = "room@server.org";
+    GTimeVal tv_stamp = { 1000, 0 };
+    muc_join(room, "bob", NULL, FALSE);
+    muc_pending_history_add(room, "alice", tv_stamp, "first");
+    muc_pending_history_add(room, "mike", tv_stamp, "second");
+
+    GList *history = muc_pending_history(room);
+
+    assert_int_equal(2, muc_pending_history_count(room));
+    assert_string_equal("first", ((MucHistory *)history->data)->message);
+    assert_string_equal("second", ((MucHistory *)history->next->data)->message);
+
+    muc_pending_history_clear(room);
+    assert_int_equal(0, muc_pending_history_count(room));
+}
+
+void test_muc_roster_ordered_by_nick(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "mike", NULL, "participant", "none", NULL, NULL);
+    muc_roster_add(room, "alice", NULL, "moderator", "owner", NULL, NULL);
+    muc_roster_add(room, "james", NULL, "participant", "member", NULL, NULL);
+
+    GList *occupants = muc_roster(room);
+
+    assert_int_equal(3, g_list_length(occupants));
+    assert_string_equal("alice", ((Occupant *)occupants->data)->nick);
+    assert_string_equal("james", ((Occupant *)occupants->next->data)->nick);
+    assert_string_equal("mike", ((Occupant *)occupants->next->next->data)->nick);
+    g_list_free(occupants);
+
+    GSList *participants = muc_occupants_by_role(room, MUC_ROLE_PARTICIPANT);
+    assert_int_equal(2, g_slist_length(participants));
+    assert_string_equal("james", ((Occupant *)participants->data)->nick);
+    assert_string_equal("mike", ((Occupant *)participants->next->data)->nick);
+    g_slist_free(participants);
+}
+
+void test_muc_roster_update_moves_occupant_between_roles(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "mike", NULL, "participant", "none", NULL, NULL);
+    muc_roster_add(room, "mike", NULL, "moderator", "admin", "away", NULL);
+
+    GSList *participants = muc_occupants_by_role(room, MUC_ROLE_PARTICIPANT);
+    GSList *moderators = muc_occupants_by_role(room, MUC_ROLE_MODERATOR);
+    GSList *admins = muc_occupants_by_affiliation(room, MUC_AFFILIATION_ADMIN);
+
+    assert_null(participants);
+    assert_int_equal(1, g_slist_length(moderators));
+    assert_int_equal(RESOURCE_AWAY, ((Occupant *)moderators->data)->presence);
+    assert_int_equal(1, g_slist_length(admins));
+    g_slist_free(moderators);
+    g_slist_free(admins);
+
+    muc_roster_remove(room, "mike");
+
+    GList *occupants = muc_roster(room);
+    assert_null(occupants);
+    assert_null(muc_occupants_by_role(room, MUC_ROLE_MODERATOR));
+}
+
+void test_muc_roster_compact_above_threshold(void **state)
+{
+    char *room = "room@server.org";
+    muc_set_compact_threshold(2);
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "mike", "mike@server.org/laptop", "participant", "none", "away", "Lunch");
+    assert_false(muc_compact(room));
+
+    muc_roster_add(room, "james", NULL, "moderator", "member", NULL, NULL);
+    muc_roster_add(room, "mike", "mike@server.org/laptop", "participant", "none", "dnd", "Busy");
+
+    Occupant *mike = muc_roster_item(room, "mike");
+    Occupant *james = muc_roster_item(room, "james");
+
+    assert_true(muc_compact(room));
+    assert_string_equal("mike", mike->nick);
+    assert_string_equal("mike@server.org/laptop", mike->jid);
+    assert_string_equal("Busy", mike->status);
+    assert_int_equal(RESOURCE_DND, mike->presence);
+    assert_int_equal(MUC_ROLE_MODERATOR, james->role);
+    assert_int_equal(MUC_AFFILIATION_MEMBER, james->affiliation);
+    assert_null(james->status);
+
+    muc_set_compact_threshold(0);
+}
+
+void test_muc_compact_filters_role_and_releases_jids(void **state)
+{
+    char *room = "room@server.org";
+    muc_set_compact_threshold(2);
+    muc_join(room, "bob", NULL, FALSE);
+    muc_roster_add(room, "mike", "mike@server.org/laptop", "participant", "none", NULL, NULL);
+    muc_roster_add(room, "Alice", "alice@server.org/phone", "moderator", "owner", NULL, NULL);
+    muc_roster_add(room, "james", "mike@server.org/desktop", "participant", "member", NULL, NULL);
+    assert_true(muc_compact(room));
+
+    GSList *participants = muc_occupants_by_role(room, MUC_ROLE_PARTICIPANT);
+    assert_int_equal(2, g_slist_length(participants));
+    assert_string_equal("james", ((Occupant *)participants->data)->nick);
+    assert_string_equal("mike", ((Occupant *)participants->next->data)->nick);
+    g_slist_free(participants);
+
+    GList *roster = muc_roster(room);
+    assert_string_equal("Alice", ((Occupant *)roster->data)->nick);
+    g_list_free(roster);
+
+    muc_roster_remove(room, "mike");
+    assert_false(autocomplete_contains(muc_roster_ac(room), "mike"));
+    assert_true(autocomplete_contains(muc_roster_jid_ac(room), "mike@server.org"));
+
+    muc_leave(room);
+    assert_int_equal(0, jid_intern_size());
+
+    muc_set_compact_threshold(0);
+}
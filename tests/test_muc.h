@@ -7,3 +7,15 @@ void test_muc_invites_count_0(void **state);
 void test_muc_invites_count_5(void **state);
 void test_muc_room_is_not_active(void **state);
 void test_muc_active(void **state);
+void test_muc_message_not_seen_first_time(void **state);
+void test_muc_message_seen_second_time(void **state);
+void test_muc_message_same_id_other_sender_not_seen(void **state);
+void test_muc_message_seen_forgets_oldest(void **state);
+void test_muc_last_seen_not_set(void **state);
+void test_muc_last_seen_keeps_latest(void **state);
+void test_muc_last_seen_now_allows_for_clock_skew(void **state);
+void test_muc_pending_history_in_order(void **state);
+void test_muc_roster_ordered_by_nick(void **state);
+void test_muc_roster_update_moves_occupant_between_roles(void **state);
+void test_muc_roster_compact_above_threshold(void **state);
+void test_muc_compact_filters_role_and_releases_jids(void **state);
@@ -0,0 +1,146 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "ui/notify_queue.h"
+
+void messages_to_window_coalesced_into_count(void **state)
+{
+    notify_queue_clear();
+
+    notify_queue_message("bob", 2, "one", 0);
+    notify_queue_message("bob", 2, "two", 100);
+    notify_queue_message("bob", 2, "three", 200);
+    assert_int_equal(1, notify_queue_length());
+
+    NotifyQueueItem *item = notify_queue_next(NOTIFY_COALESCE_MS);
+    assert_non_null(item);
+    assert_string_equal("3 new messages from bob (win 2)\nthree", item->message);
+    assert_int_equal(0, notify_queue_length());
+
+    notify_queue_item_free(item);
+    notify_queue_clear();
+}
+
+void nothing_shown_until_coalesce_delay(void **state)
+{
+    notify_queue_clear();
+
+    notify_queue_message("bob", 2, "hello", 1000);
+
+    assert_null(notify_queue_next(1000 + NOTIFY_COALESCE_MS - 1));
+    assert_int_equal(1, notify_queue_length());
+
+    NotifyQueueItem *item = notify_queue_next(1000 + NOTIFY_COALESCE_MS);
+    assert_non_null(item);
+    assert_string_equal("bob (win 2)\nhello", item->message);
+
+    notify_queue_item_free(item);
+    notify_queue_clear();
+}
+
+void one_notification_per_min_interval(void **state)
+{
+    notify_queue_clear();
+
+    notify_queue_message("bob", 2, "hello", 0);
+    notify_queue_message("alice", 3, "hi", 0);
+
+    NotifyQueueItem *item = notify_queue_next(1000);
+    assert_non_null(item);
+    assert_string_equal("bob (win 2)\nhello", item->message);
+    notify_queue_item_free(item);
+
+    assert_null(notify_queue_next(1000 + NOTIFY_MIN_INTERVAL_MS - 1));
+
+    item = notify_queue_next(1000 + NOTIFY_MIN_INTERVAL_MS);
+    assert_non_null(item);
+    assert_string_equal("alice (win 3)\nhi", item->message);
+
+    notify_queue_item_free(item);
+    notify_queue_clear();
+}
+
+void one_notification_per_window_interval(void **state)
+{
+    notify_queue_clear();
+
+    notify_queue_message("bob", 2, "hello", 0);
+    NotifyQueueItem *item = notify_queue_next(1000);
+    assert_non_null(item);
+    notify_queue_item_free(item);
+
+    notify_queue_message("bob", 2, "again", 1000);
+    assert_null(notify_queue_next(1000 + NOTIFY_WIN_INTERVAL_MS - 1));
+    assert_int_equal(1, notify_queue_length());
+
+    item = notify_queue_next(1000 + NOTIFY_WIN_INTERVAL_MS);
+    assert_non_null(item);
+    assert_string_equal("bob (win 2)\nagain", item->message);
+
+    notify_queue_item_free(item);
+    notify_queue_clear();
+}
+
+void message_drops_pending_typing(void **state)
+{
+    notify_queue_clear();
+
+    notify_queue_typing("bob", 0);
+    assert_int_equal(1, notify_queue_length());
+
+    notify_queue_message("bob", 2, "hello", 100);
+    assert_int_equal(1, notify_queue_length());
+
+    NotifyQueueItem *item = notify_queue_next(1000);
+    assert_non_null(item);
+    assert_string_equal("bob (win 2)\nhello", item->message);
+    assert_int_equal(0, notify_queue_length());
+
+    notify_queue_item_free(item);
+    notify_queue_clear();
+}
+
+void full_queue_drops_oldest(void **state)
+{
+    notify_queue_clear();
+
+    int i;
+    for (i = 1; i <= NOTIFY_QUEUE_MAX + 1; i++) {
+        notify_queue_message("bob", i, "hello", 0);
+    }
+    assert_int_equal(NOTIFY_QUEUE_MAX, notify_queue_length());
+
+    NotifyQueueItem *item = notify_queue_next(1000);
+    assert_non_null(item);
+    assert_string_equal("bob (win 2)\nhello", item->message);
+
+    notify_queue_item_free(item);
+    notify_queue_clear();
+}
+
+void shown_pruned_after_interval(void **state)
+{
+    notify_queue_clear();
+
+    notify_queue_message("bob", 2, "hello", 0);
+    notify_queue_typing("alice", 0);
+
+    NotifyQueueItem *item = notify_queue_next(1000);
+    notify_queue_item_free(item);
+    item = notify_queue_next(1000 + NOTIFY_MIN_INTERVAL_MS);
+    notify_queue_item_free(item);
+    assert_int_equal(2, notify_queue_shown_count());
+
+    assert_null(notify_queue_next(1000 + NOTIFY_WIN_INTERVAL_MS));
+    assert_int_equal(1, notify_queue_shown_count());
+
+    assert_null(notify_queue_next(1000 + NOTIFY_MIN_INTERVAL_MS + NOTIFY_TYPING_MS));
+    assert_int_equal(0, notify_queue_shown_count());
+
+    notify_queue_clear();
+}
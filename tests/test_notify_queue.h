@@ -0,0 +1,7 @@
+void messages_to_window_coalesced_into_count(void **state);
+void nothing_shown_until_coalesce_delay(void **state);
+void one_notification_per_min_interval(void **state);
+void one_notification_per_window_interval(void **state);
+void message_drops_pending_typing(void **state);
+void full_queue_drops_oldest(void **state);
+void shown_pruned_after_interval(void **state);
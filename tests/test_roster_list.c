@@ -262,10 +262,104 @@ void find_twice_returns_first_when_two_match_and_reset(void **state)
     roster_add("Bob", NULL, NULL, NULL, FALSE);
 
     char *result1 = roster_contact_autocomplete("Jam");
-    roster_reset_search_attempts();
+    autocomplete_reset_all();
     char *result2 = roster_contact_autocomplete(result1);
     assert_string_equal("James", result2);
     free(result1);
     free(result2);
     roster_free();
 }
+
+void contacts_sorted_by_name_after_rename(void **state)
+{
+    roster_init();
+    roster_add("a@server", "Alice", NULL, NULL, FALSE);
+    roster_add("b@server", "Bob", NULL, NULL, FALSE);
+    roster_change_name(roster_get_contact("a@server"), "Zed");
+
+    GSList *list = roster_get_contacts();
+    assert_string_equal("b@server", p_contact_barejid(list->data));
+    assert_string_equal("a@server", p_contact_barejid(g_slist_next(list)->data));
+
+    g_slist_free(list);
+    roster_free();
+}
+
+void contacts_by_presence_follow_presence_changes(void **state)
+{
+    roster_init();
+    roster_add("a@server", NULL, NULL, NULL, FALSE);
+    roster_add("b@server", NULL, NULL, NULL, FALSE);
+    Resource *resource = resource_new("laptop", RESOURCE_AWAY, NULL, 10);
+    roster_update_presence("a@server", resource, NULL);
+
+    GSList *away = roster_get_contacts_by_presence("away");
+    GSList *offline = roster_get_contacts_by_presence("offline");
+    GSList *online = roster_get_contacts_online();
+    assert_int_equal(1, g_slist_length(away));
+    assert_string_equal("a@server", p_contact_barejid(away->data));
+    assert_int_equal(1, g_slist_length(offline));
+    assert_string_equal("b@server", p_contact_barejid(offline->data));
+    assert_int_equal(1, g_slist_length(online));
+    g_slist_free(away);
+    g_slist_free(offline);
+    g_slist_free(online);
+
+    roster_contact_offline("a@server", "laptop", NULL);
+
+    away = roster_get_contacts_by_presence("away");
+    offline = roster_get_contacts_by_presence("offline");
+    online = roster_get_contacts_online();
+    assert_null(away);
+    assert_int_equal(2, g_slist_length(offline));
+    assert_null(online);
+    g_slist_free(offline);
+
+    roster_free();
+}
+
+void groups_follow_roster_updates(void **state)
+{
+    roster_init();
+    GSList *groups = g_slist_append(NULL, strdup("friends"));
+    roster_add("a@server", NULL, groups, NULL, FALSE);
+    roster_add("b@server", NULL, NULL, NULL, FALSE);
+
+    GSList *friends = roster_get_group("friends");
+    GSList *nogroup = roster_get_nogroup();
+    assert_int_equal(1, g_slist_length(friends));
+    assert_string_equal("a@server", p_contact_barejid(friends->data));
+    assert_int_equal(1, g_slist_length(nogroup));
+    assert_string_equal("b@server", p_contact_barejid(nogroup->data));
+    g_slist_free(friends);
+    g_slist_free(nogroup);
+
+    groups = g_slist_append(NULL, strdup("friends"));
+    roster_update("b@server", NULL, groups, "both", FALSE);
+    roster_update("a@server", NULL, NULL, "both", FALSE);
+
+    friends = roster_get_group("friends");
+    nogroup = roster_get_nogroup();
+    assert_int_equal(1, g_slist_length(friends));
+    assert_string_equal("b@server", p_contact_barejid(friends->data));
+    assert_int_equal(1, g_slist_length(nogroup));
+    assert_string_equal("a@server", p_contact_barejid(nogroup->data));
+    g_slist_free(friends);
+    g_slist_free(nogroup);
+
+    roster_free();
+}
+
+void removed_contact_not_in_any_view(void **state)
+{
+    roster_init();
+    GSList *groups = g_slist_append(NULL, strdup("friends"));
+    roster_add("a@server", NULL, groups, NULL, FALSE);
+    roster_remove("a@server", "a@server");
+
+    assert_null(roster_get_contacts());
+    assert_null(roster_get_group("friends"));
+    assert_null(roster_get_contacts_by_presence("offline"));
+
+    roster_free();
+}
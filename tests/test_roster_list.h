@@ -16,3 +16,7 @@ void find_on_empty_returns_null(void **state);
 void find_twice_returns_second_when_two_match(void **state);
 void find_five_times_finds_fifth(void **state);
 void find_twice_returns_first_when_two_match_and_reset(void **state);
+void contacts_sorted_by_name_after_rename(void **state);
+void contacts_by_presence_follow_presence_changes(void **state);
+void groups_follow_roster_updates(void **state);
+void removed_contact_not_in_any_view(void **state);
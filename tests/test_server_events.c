@@ -12,6 +12,7 @@
 #include "config/preferences.h"
 #include "ui/ui.h"
 #include "muc.h"
+#include "ui/stub_ui.h"
 
 void console_doesnt_show_online_presence_when_set_none(void **state)
 {
@@ -180,3 +181,26 @@ void handle_presence_error_when_from_recipient(void **state)
 
     handle_presence_error(from, type, err_msg);
 }
+
+void handle_autoping_timeout_shows_error(void **state)
+{
+    expect_cons_show_error("Server did not respond to ping within 10 seconds, closing connection.");
+
+    handle_autoping_timeout(10);
+}
+
+void room_history_up_to_last_seen_ignored(void **state)
+{
+    char *room = "room@server.org";
+    muc_join(room, "bob", NULL, FALSE);
+    GTimeVal last_seen = { 1000, 500 };
+    muc_set_last_seen(room, &last_seen);
+
+    GTimeVal boundary = { 1000, 500 };
+    handle_room_history(room, "alice", boundary, "seen");
+    assert_int_equal(0, muc_pending_history_count(room));
+
+    GTimeVal later = { 1000, 501 };
+    handle_room_history(room, "alice", later, "unseen");
+    assert_int_equal(1, muc_pending_history_count(room));
+}
@@ -9,4 +9,6 @@ void handle_message_error_when_recipient_cancel(void **state);
 void handle_message_error_when_recipient_cancel_disables_chat_session(void **state);
 void handle_message_error_when_recipient_and_no_type(void **state);
 void handle_presence_error_when_no_recipient(void **state);
-void handle_presence_error_when_from_recipient(void **state);
\ No newline at end of file
+void handle_presence_error_when_from_recipient(void **state);
+void handle_autoping_timeout_shows_error(void **state);
+void room_history_up_to_last_seen_ignored(void **state);
@@ -0,0 +1,55 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <glib.h>
+
+#include "tools/worker.h"
+
+typedef struct work_t {
+    int result;
+    gboolean done_saw_result;
+} Work;
+
+static void
+_work(gpointer data)
+{
+    Work *work = data;
+    work->result = 42;
+}
+
+static void
+_done(gpointer data)
+{
+    Work *work = data;
+    work->done_saw_result = (work->result == 42);
+}
+
+void work_runs_in_place_without_threads(void **state)
+{
+    Work work = { 0, FALSE };
+
+    worker_run(_work, _done, &work);
+
+    assert_int_equal(42, work.result);
+    assert_true(work.done_saw_result);
+}
+
+void done_runs_after_work_on_shutdown(void **state)
+{
+    Work work[10];
+    int i;
+
+    worker_init();
+    for (i = 0; i < 10; i++) {
+        work[i].result = 0;
+        work[i].done_saw_result = FALSE;
+        worker_run(_work, _done, &work[i]);
+    }
+    worker_shutdown();
+
+    for (i = 0; i < 10; i++) {
+        assert_true(work[i].done_saw_result);
+    }
+}
@@ -0,0 +1,2 @@
+void work_runs_in_place_without_threads(void **state);
+void done_runs_after_work_on_shutdown(void **state);
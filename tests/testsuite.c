@@ -11,6 +11,7 @@
 
 #include "helpers.h"
 #include "test_autocomplete.h"
+#include "test_highlight.h"
 #include "test_common.h"
 #include "test_contact.h"
 #include "test_cmd_connect.h"
@@ -32,6 +33,12 @@
 #include "test_cmd_roster.h"
 #include "test_cmd_win.h"
 #include "test_form.h"
+#include "test_filewriter.h"
+#include "test_worker.h"
+#include "test_http.h"
+#include "test_iq_tracker.h"
+#include "test_autoping.h"
+#include "test_notify_queue.h"
 
 int main(int argc, char* argv[]) {
     const UnitTest all_tests[] = {
@@ -93,6 +100,23 @@ int main(int argc, char* argv[]) {
         unit_test(add_two_adds_two),
         unit_test(add_two_same_adds_one),
         unit_test(add_two_same_updates),
+        unit_test(complete_cycles_matches_in_order),
+        unit_test(remove_keeps_remaining_items),
+        unit_test(fuzzy_complete_matches_characters_in_order),
+        unit_test(fuzzy_complete_returns_highest_weight_first),
+        unit_test(fuzzy_complete_weight_does_not_beat_better_match),
+        unit_test(reset_all_starts_new_search),
+        unit_test(borrowed_cycles_in_order),
+        unit_test(borrowed_releases_duplicates_and_removed),
+
+        unit_test(highlight_matches_nick_as_word),
+        unit_test(highlight_ignores_case),
+        unit_test(highlight_does_not_match_inside_word),
+        unit_test(highlight_matches_after_partial_match),
+        unit_test(highlight_matches_non_word_edges),
+        unit_test(highlight_matches_utf8_case),
+        unit_test(highlight_matches_regex),
+        unit_test(highlight_rejects_bad_regex),
 
         unit_test(previous_on_empty_returns_null),
         unit_test(next_on_empty_returns_null),
@@ -107,6 +131,10 @@ int main(int argc, char* argv[]) {
         unit_test(edit_item_mid_history),
         unit_test(edit_previous_and_append),
         unit_test(start_session_add_new_submit_previous),
+        unit_test(full_history_drops_oldest),
+        unit_test(search_returns_newest_match_first),
+        unit_test(search_skips_dropped_items),
+        unit_test(search_finds_edited_item),
 
         unit_test(create_jid_from_null_returns_null),
         unit_test(create_jid_from_empty_string_returns_null),
@@ -133,6 +161,15 @@ int main(int argc, char* argv[]) {
         unit_test(create_full_with_trailing_slash),
         unit_test(returns_fulljid_when_exists),
         unit_test(returns_barejid_when_fulljid_not_exists),
+        unit_test(parse_view_from_null_returns_false),
+        unit_test(parse_view_from_empty_string_returns_false),
+        unit_test(parse_view_from_full_returns_parts),
+        unit_test(parse_view_from_bare_returns_null_resource),
+        unit_test(parse_view_from_nolocal_returns_null_localpart),
+        unit_test(parse_view_with_at_and_slash_in_resource),
+        unit_test(intern_returns_same_pointer_for_equal_jids),
+        unit_test(intern_barejid_matches_interned_bare),
+        unit_test(intern_release_last_reference_removes_jid),
 
         unit_test(parse_null_returns_null),
         unit_test(parse_empty_returns_null),
@@ -203,6 +240,10 @@ int main(int argc, char* argv[]) {
         unit_test(find_twice_returns_second_when_two_match),
         unit_test(find_five_times_finds_fifth),
         unit_test(find_twice_returns_first_when_two_match_and_reset),
+        unit_test(contacts_sorted_by_name_after_rename),
+        unit_test(contacts_by_presence_follow_presence_changes),
+        unit_test(groups_follow_roster_updates),
+        unit_test(removed_contact_not_in_any_view),
 
         unit_test_setup_teardown(cmd_connect_shows_message_when_disconnecting,
             load_preferences,
@@ -368,6 +409,8 @@ int main(int argc, char* argv[]) {
         unit_test(contact_not_available_when_highest_priority_dnd),
         unit_test(contact_available_when_highest_priority_online),
         unit_test(contact_available_when_highest_priority_chat),
+        unit_test(contact_presence_next_highest_when_highest_removed),
+        unit_test(contact_presence_updated_when_highest_replaced),
 
         unit_test(cmd_statuses_shows_usage_when_bad_subcmd),
         unit_test(cmd_statuses_shows_usage_when_bad_console_setting),
@@ -439,6 +482,10 @@ int main(int argc, char* argv[]) {
         unit_test(handle_message_error_when_recipient_and_no_type),
         unit_test(handle_presence_error_when_no_recipient),
         unit_test(handle_presence_error_when_from_recipient),
+        unit_test(handle_autoping_timeout_shows_error),
+        unit_test_setup_teardown(room_history_up_to_last_seen_ignored,
+            muc_before_test,
+            muc_after_test),
 
         unit_test(cmd_alias_add_shows_usage_when_no_args),
         unit_test(cmd_alias_add_shows_usage_when_no_value),
@@ -466,6 +513,18 @@ int main(int argc, char* argv[]) {
         unit_test_setup_teardown(test_muc_invites_count_5, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_room_is_not_active, muc_before_test, muc_after_test),
         unit_test_setup_teardown(test_muc_active, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_message_not_seen_first_time, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_message_seen_second_time, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_message_same_id_other_sender_not_seen, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_message_seen_forgets_oldest, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_last_seen_not_set, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_last_seen_keeps_latest, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_last_seen_now_allows_for_clock_skew, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_pending_history_in_order, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_ordered_by_nick, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_update_moves_occupant_between_roles, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_roster_compact_above_threshold, muc_before_test, muc_after_test),
+        unit_test_setup_teardown(test_muc_compact_filters_role_and_releases_jids, muc_before_test, muc_after_test),
 
         unit_test(cmd_bookmark_shows_message_when_disconnected),
         unit_test(cmd_bookmark_shows_message_when_disconnecting),
@@ -594,6 +653,48 @@ int main(int argc, char* argv[]) {
         unit_test(remove_text_multi_value_does_nothing_when_doesnt_exist),
         unit_test(remove_text_multi_value_removes_when_one),
         unit_test(remove_text_multi_value_removes_when_many),
+
+        unit_test_setup_teardown(flush_writes_changed_contents,
+            create_config_dir,
+            remove_config_dir),
+        unit_test_setup_teardown(nothing_written_before_delay,
+            create_config_dir,
+            remove_config_dir),
+        unit_test_setup_teardown(unchanged_contents_not_written,
+            create_config_dir,
+            remove_config_dir),
+        unit_test_setup_teardown(writer_thread_writes_changed_contents,
+            create_config_dir,
+            remove_config_dir),
+
+        unit_test(work_runs_in_place_without_threads),
+        unit_test(done_runs_after_work_on_shutdown),
+
+        unit_test(failed_request_answered_in_place_without_init),
+        unit_test(failed_request_answered_from_main_loop),
+        unit_test(shutdown_frees_requests_in_flight),
+
+        unit_test(request_retired_on_response),
+        unit_test(request_retired_on_timeout),
+        unit_test(reused_id_replaces_request),
+        unit_test(clear_frees_outstanding_userdata),
+        unit_test(stats_count_responses_and_timeouts),
+
+        unit_test(interval_is_preference_until_pong_missed),
+        unit_test(single_missed_pong_does_not_close),
+        unit_test(consecutive_missed_pongs_close),
+        unit_test(pong_resets_missed_count),
+        unit_test(missed_pongs_halve_interval_to_minimum),
+        unit_test(pongs_grow_interval_back_to_preference),
+        unit_test(connected_keeps_interval_clears_misses),
+
+        unit_test(messages_to_window_coalesced_into_count),
+        unit_test(nothing_shown_until_coalesce_delay),
+        unit_test(one_notification_per_min_interval),
+        unit_test(one_notification_per_window_interval),
+        unit_test(message_drops_pending_typing),
+        unit_test(full_queue_drops_oldest),
+        unit_test(shown_pruned_after_interval),
     };
 
     return run_tests(all_tests);
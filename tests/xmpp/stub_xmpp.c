@@ -32,6 +32,11 @@ const char * jabber_get_fulljid(void)
     return NULL;
 }
 
+const char * jabber_get_barejid(void)
+{
+    return NULL;
+}
+
 const char * jabber_get_domain(void)
 {
     return NULL;
@@ -92,8 +97,6 @@ gint presence_sub_request_count(void)
     return 0;
 }
 
-void presence_reset_sub_request_search(void) {}
-
 char * presence_sub_request_find(char * search_str)
 {
     return  NULL;
@@ -152,6 +155,31 @@ void iq_room_kick_occupant(const char * const room, const char * const nick, con
 void iq_room_role_set(const char * const room, const char * const nick, char *role,
     const char * const reason) {}
 void iq_room_role_list(const char * const room, char *role) {}
+GList * iq_stats_list(void)
+{
+    return NULL;
+}
+int iq_stats_bucket_limit(int bucket)
+{
+    return -1;
+}
+int iq_outstanding_count(void)
+{
+    return 0;
+}
+void iq_stats_reset(void) {}
+int iq_autoping_interval(void)
+{
+    return 0;
+}
+IqStats * iq_autoping_stats(void)
+{
+    return NULL;
+}
+int iq_autoping_last_rtt(void)
+{
+    return -1;
+}
 
 // caps functions
 Capabilities* caps_lookup(const char * const jid)
@@ -159,6 +187,7 @@ Capabilities* caps_lookup(const char * const jid)
     return NULL;
 }
 
+void caps_preload(void) {}
 void caps_close(void) {}
 void caps_destroy(Capabilities *caps) {}
 
@@ -197,7 +226,10 @@ char * bookmark_find(char *search_str)
     return NULL;
 }
 
-void bookmark_autocomplete_reset(void) {}
+char * bookmark_fuzzy_find(char *search_str)
+{
+    return NULL;
+}
 
 void roster_send_name_change(const char * const barejid, const char * const new_name, GSList *groups)
 {